@@ -3761,6 +3761,102 @@ static void test_delete_value(void)
     ok(res == ERROR_FILE_NOT_FOUND, "expected ERROR_FILE_NOT_FOUND, got %ld\n", res);
 }
 
+static void test_cached_value_child(void)
+{
+    HANDLE read_event, write_event;
+    DWORD type, size, value;
+    HKEY key;
+    LONG res;
+
+    read_event = OpenEventA( EVENT_ALL_ACCESS, FALSE, "winetest_registry_read" );
+    ok(read_event != NULL, "OpenEvent failed, error %lu\n", GetLastError());
+    write_event = OpenEventA( EVENT_ALL_ACCESS, FALSE, "winetest_registry_written" );
+    ok(write_event != NULL, "OpenEvent failed, error %lu\n", GetLastError());
+
+    res = RegOpenKeyExA( HKEY_CURRENT_USER, "Software\\Wine\\Test", 0, KEY_QUERY_VALUE, &key );
+    ok(res == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %ld\n", res);
+
+    /* the second query may be served from the cache */
+    size = sizeof(value);
+    res = RegQueryValueExA( key, "cached", NULL, &type, (BYTE *)&value, &size );
+    ok(res == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %ld\n", res);
+    ok(value == 1, "got %lu\n", value);
+    size = sizeof(value);
+    res = RegQueryValueExA( key, "cached", NULL, &type, (BYTE *)&value, &size );
+    ok(res == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %ld\n", res);
+    ok(type == REG_DWORD, "got type %lu\n", type);
+    ok(value == 1, "got %lu\n", value);
+
+    SetEvent( read_event );
+    res = WaitForSingleObject( write_event, 10000 );
+    ok(res == WAIT_OBJECT_0, "wait failed %lx\n", res);
+
+    size = sizeof(value);
+    res = RegQueryValueExA( key, "cached", NULL, &type, (BYTE *)&value, &size );
+    ok(res == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %ld\n", res);
+    ok(value == 2, "got %lu\n", value);
+
+    SetEvent( read_event );
+    res = WaitForSingleObject( write_event, 10000 );
+    ok(res == WAIT_OBJECT_0, "wait failed %lx\n", res);
+
+    size = sizeof(value);
+    res = RegQueryValueExA( key, "cached", NULL, &type, (BYTE *)&value, &size );
+    ok(res == ERROR_FILE_NOT_FOUND, "expected ERROR_FILE_NOT_FOUND, got %ld\n", res);
+
+    RegCloseKey( key );
+    CloseHandle( read_event );
+    CloseHandle( write_event );
+}
+
+static void test_cached_value(void)
+{
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    HANDLE read_event, write_event;
+    char cmdline[MAX_PATH + 32];
+    DWORD value;
+    char **argv;
+    LONG res;
+    BOOL ret;
+
+    value = 1;
+    res = RegSetValueExA( hkey_main, "cached", 0, REG_DWORD, (const BYTE *)&value, sizeof(value) );
+    ok(res == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %ld\n", res);
+
+    read_event = CreateEventA( NULL, FALSE, FALSE, "winetest_registry_read" );
+    ok(read_event != NULL, "CreateEvent failed, error %lu\n", GetLastError());
+    write_event = CreateEventA( NULL, FALSE, FALSE, "winetest_registry_written" );
+    ok(write_event != NULL, "CreateEvent failed, error %lu\n", GetLastError());
+
+    /* have the child cache the values it queries; this has no effect on Windows */
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" registry cached_value", argv[0] );
+    SetEnvironmentVariableA( "WINEREGCACHE", "machine,user" );
+    ret = CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+    SetEnvironmentVariableA( "WINEREGCACHE", NULL );
+    ok(ret, "CreateProcess failed, error %lu\n", GetLastError());
+
+    res = WaitForSingleObject( read_event, 10000 );
+    ok(res == WAIT_OBJECT_0, "wait failed %lx\n", res);
+    value = 2;
+    res = RegSetValueExA( hkey_main, "cached", 0, REG_DWORD, (const BYTE *)&value, sizeof(value) );
+    ok(res == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %ld\n", res);
+    SetEvent( write_event );
+
+    res = WaitForSingleObject( read_event, 10000 );
+    ok(res == WAIT_OBJECT_0, "wait failed %lx\n", res);
+    res = RegDeleteValueA( hkey_main, "cached" );
+    ok(res == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %ld\n", res);
+    SetEvent( write_event );
+
+    wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+    CloseHandle( read_event );
+    CloseHandle( write_event );
+}
+
 static void test_delete_key_value(void)
 {
     HKEY subkey;
@@ -4914,9 +5010,19 @@ static void test_RegRenameKey(void)
 
 START_TEST(registry)
 {
+    char **argv;
+    int argc;
+
     /* Load pointers for functions that are not available in all Windows versions */
     InitFunctionPtrs();
 
+    argc = winetest_get_mainargs( &argv );
+    if (argc >= 3 && !strcmp( argv[2], "cached_value" ))
+    {
+        test_cached_value_child();
+        return;
+    }
+
     setup_main_key();
     check_user_privs();
     test_set_value();
@@ -4945,6 +5051,7 @@ START_TEST(registry)
     test_rw_order();
     test_deleted_key();
     test_delete_value();
+    test_cached_value();
     test_delete_key_value();
     test_RegOpenCurrentUser();
     test_RegNotifyChangeKeyValue();
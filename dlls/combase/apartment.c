@@ -715,12 +715,12 @@ static BOOL get_object_dll_path(const struct class_reg_data *regdata, WCHAR *dst
 
     if (regdata->origin == CLASS_REG_REGISTRY)
     {
-        DWORD keytype;
+        DWORD keytype = regdata->u.server->path_type;
         WCHAR src[MAX_PATH];
-        DWORD dwLength = dstlen * sizeof(WCHAR);
 
-        if ((ret = RegQueryValueExW(regdata->u.hkey, NULL, NULL, &keytype, (BYTE*)src, &dwLength)) == ERROR_SUCCESS)
+        if (!(ret = regdata->u.server->path_status))
         {
+            lstrcpynW(src, regdata->u.server->path, ARRAY_SIZE(src));
             if (keytype == REG_EXPAND_SZ)
             {
                 if (dstlen <= ExpandEnvironmentStringsW(src, dst, dstlen)) ret = ERROR_MORE_DATA;
@@ -1003,27 +1003,21 @@ static HRESULT apartment_hostobject_in_hostapt(struct apartment *apt, BOOL multi
     return hr;
 }
 
+static enum comclass_threadingmodel threading_model_from_string(const WCHAR *threading_model)
+{
+    if (!wcsicmp(threading_model, L"Apartment")) return ThreadingModel_Apartment;
+    if (!wcsicmp(threading_model, L"Free")) return ThreadingModel_Free;
+    if (!wcsicmp(threading_model, L"Both")) return ThreadingModel_Both;
+
+    /* there's not specific handling for this case */
+    if (threading_model[0]) return ThreadingModel_Neutral;
+    return ThreadingModel_No;
+}
+
 static enum comclass_threadingmodel get_threading_model(const struct class_reg_data *data)
 {
     if (data->origin == CLASS_REG_REGISTRY)
-    {
-        WCHAR threading_model[10 /* lstrlenW(L"apartment")+1 */];
-        DWORD dwLength = sizeof(threading_model);
-        DWORD keytype;
-        DWORD ret;
-
-        ret = RegQueryValueExW(data->u.hkey, L"ThreadingModel", NULL, &keytype, (BYTE*)threading_model, &dwLength);
-        if ((ret != ERROR_SUCCESS) || (keytype != REG_SZ))
-            threading_model[0] = '\0';
-
-        if (!wcsicmp(threading_model, L"Apartment")) return ThreadingModel_Apartment;
-        if (!wcsicmp(threading_model, L"Free")) return ThreadingModel_Free;
-        if (!wcsicmp(threading_model, L"Both")) return ThreadingModel_Both;
-
-        /* there's not specific handling for this case */
-        if (threading_model[0]) return ThreadingModel_Neutral;
-        return ThreadingModel_No;
-    }
+        return threading_model_from_string(data->u.server->threading_model);
     else
         return data->u.actctx.threading_model;
 }
@@ -30,8 +30,10 @@
 #include "combase_private.h"
 
 #include "wine/debug.h"
+#include "wine/rbtree.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(ole);
+WINE_DECLARE_DEBUG_CHANNEL(olecache);
 
 HINSTANCE hProxyDll;
 
@@ -369,6 +371,259 @@ HRESULT open_appidkey_from_clsid(REFCLSID clsid, REGSAM access, HKEY *subkey)
     return S_OK;
 }
 
+/*
+ * Class cache
+ *
+ * Registry data of classes resolved during activation is kept per process,
+ * so that repeated activations of the same class don't need a round trip to
+ * the server for each key and value. The whole cache is flushed whenever
+ * anything under the classes root changes; change notifications are picked up
+ * by a thread pool wait, so that lookups don't need to poll the event. As the
+ * notification arrives asynchronously, registry writes done by combase itself
+ * flush the cache directly, and failed lookups are not cached, so that classes
+ * registered by the process are found right away.
+ */
+
+enum class_cache_data
+{
+    CLASS_CACHE_TREAT_AS,
+    CLASS_CACHE_INPROC_SERVER,
+    CLASS_CACHE_INPROC_HANDLER,
+    CLASS_CACHE_DATA_COUNT
+};
+
+static const WCHAR *class_cache_keys[CLASS_CACHE_DATA_COUNT] =
+{
+    L"TreatAs",
+    L"InprocServer32",
+    L"InprocHandler32",
+};
+
+struct class_cache_entry
+{
+    struct rb_entry entry;
+    CLSID clsid;
+    DWORD resolved;   /* mask of resolved class_cache_data */
+    HRESULT hr[CLASS_CACHE_DATA_COUNT];
+    CLSID treat_as;
+    struct class_server_info server[2];
+};
+
+#define CLASS_CACHE_MAX_ENTRIES 1024
+
+static int class_cache_compare(const void *key, const struct rb_entry *entry)
+{
+    const struct class_cache_entry *cached = RB_ENTRY_VALUE(entry, const struct class_cache_entry, entry);
+    return memcmp(key, &cached->clsid, sizeof(cached->clsid));
+}
+
+static struct rb_tree class_cache = { class_cache_compare };
+static unsigned int class_cache_count;
+static HANDLE class_cache_event;
+static TP_WAIT *class_cache_wait;
+static LONG class_cache_stale = TRUE;
+
+static CRITICAL_SECTION class_cache_cs;
+static CRITICAL_SECTION_DEBUG class_cache_cs_debug =
+{
+    0, 0, &class_cache_cs,
+    { &class_cache_cs_debug.ProcessLocksList, &class_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": class_cache_cs") }
+};
+static CRITICAL_SECTION class_cache_cs = { &class_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static void class_cache_free_entry(struct rb_entry *entry, void *context)
+{
+    free(RB_ENTRY_VALUE(entry, struct class_cache_entry, entry));
+}
+
+static void class_cache_flush(void)
+{
+    rb_destroy(&class_cache, class_cache_free_entry, NULL);
+    class_cache_count = 0;
+}
+
+static void CALLBACK class_cache_changed(TP_CALLBACK_INSTANCE *instance, void *context, TP_WAIT *wait,
+        TP_WAIT_RESULT result)
+{
+    InterlockedExchange(&class_cache_stale, TRUE);
+}
+
+/* Flushes the cache if the classes have changed since it was last checked,
+ * returns FALSE if changes can't be tracked. Called with class_cache_cs held. */
+static BOOL class_cache_validate(void)
+{
+    HKEY root;
+
+    if (!ReadNoFence(&class_cache_stale))
+        return TRUE;
+
+    if (!class_cache_event && !(class_cache_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        return FALSE;
+    if (!class_cache_wait && !(class_cache_wait = CreateThreadpoolWait(class_cache_changed, NULL, NULL)))
+        return FALSE;
+
+    /* rearm the notification before dropping the entries, so that no change can be missed */
+    InterlockedExchange(&class_cache_stale, FALSE);
+    if (!(root = get_classes_root_hkey(HKEY_CLASSES_ROOT, KEY_READ)) ||
+            RegNotifyChangeKeyValue(root, TRUE, REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET,
+            class_cache_event, TRUE))
+    {
+        WARN("failed to watch the classes root, not caching classes\n");
+        class_cache_flush();
+        InterlockedExchange(&class_cache_stale, TRUE);
+        return FALSE;
+    }
+    SetThreadpoolWait(class_cache_wait, class_cache_event, NULL);
+
+    if (class_cache_count)
+        TRACE_(olecache)("classes changed, flushing %u entries\n", class_cache_count);
+    class_cache_flush();
+    return TRUE;
+}
+
+static struct class_cache_entry *class_cache_get(REFCLSID clsid)
+{
+    struct class_cache_entry *cached;
+    struct rb_entry *entry;
+
+    if (!class_cache_validate())
+        return NULL;
+
+    if ((entry = rb_get(&class_cache, clsid)))
+        return RB_ENTRY_VALUE(entry, struct class_cache_entry, entry);
+
+    if (class_cache_count >= CLASS_CACHE_MAX_ENTRIES)
+    {
+        TRACE_(olecache)("cache full, flushing %u entries\n", class_cache_count);
+        class_cache_flush();
+    }
+
+    if (!(cached = calloc(1, sizeof(*cached))))
+        return NULL;
+    cached->clsid = *clsid;
+    rb_put(&class_cache, clsid, &cached->entry);
+    class_cache_count++;
+    return cached;
+}
+
+static HRESULT read_treat_as_class(REFCLSID clsid, CLSID *treat_as)
+{
+    WCHAR buffW[CHARS_IN_GUID];
+    LONG len = sizeof(buffW);
+    HRESULT hr;
+    HKEY hkey;
+
+    *treat_as = *clsid;
+
+    if (FAILED(open_key_for_clsid(clsid, L"TreatAs", KEY_READ, &hkey)))
+        return S_FALSE;
+
+    if (RegQueryValueW(hkey, NULL, buffW, &len))
+        hr = S_FALSE;
+    else if (FAILED(hr = CLSIDFromString(buffW, treat_as)))
+        ERR("Failed to get CLSID from string %s, hr %#lx.\n", debugstr_w(buffW), hr);
+
+    RegCloseKey(hkey);
+    return hr;
+}
+
+static HRESULT read_class_server(REFCLSID clsid, const WCHAR *keyname, struct class_server_info *server)
+{
+    DWORD size, type;
+    HRESULT hr;
+    HKEY hkey;
+
+    memset(server, 0, sizeof(*server));
+
+    if (FAILED(hr = open_key_for_clsid(clsid, keyname, KEY_READ, &hkey)))
+        return hr;
+
+    size = sizeof(server->path) - sizeof(WCHAR);
+    server->path_status = RegQueryValueExW(hkey, NULL, NULL, &server->path_type, (BYTE *)server->path, &size);
+
+    size = sizeof(server->threading_model);
+    if (RegQueryValueExW(hkey, L"ThreadingModel", NULL, &type, (BYTE *)server->threading_model, &size) ||
+            type != REG_SZ)
+        server->threading_model[0] = 0;
+
+    RegCloseKey(hkey);
+    return S_OK;
+}
+
+/* Resolves the given class data if it isn't cached yet. Called with class_cache_cs held. */
+static HRESULT class_cache_resolve(struct class_cache_entry *cached, enum class_cache_data data)
+{
+    if (cached->resolved & (1 << data))
+    {
+        TRACE_(olecache)("hit %s %s, hr %#lx\n", debugstr_guid(&cached->clsid),
+                debugstr_w(class_cache_keys[data]), cached->hr[data]);
+        return cached->hr[data];
+    }
+
+    if (data == CLASS_CACHE_TREAT_AS)
+        cached->hr[data] = read_treat_as_class(&cached->clsid, &cached->treat_as);
+    else
+        cached->hr[data] = read_class_server(&cached->clsid, class_cache_keys[data],
+                &cached->server[data - CLASS_CACHE_INPROC_SERVER]);
+    if (cached->hr[data] == S_OK) cached->resolved |= 1 << data;
+
+    TRACE_(olecache)("miss %s %s, hr %#lx\n", debugstr_guid(&cached->clsid),
+            debugstr_w(class_cache_keys[data]), cached->hr[data]);
+    return cached->hr[data];
+}
+
+static HRESULT get_treat_as_class(REFCLSID clsid, CLSID *treat_as)
+{
+    struct class_cache_entry uncached = { .clsid = *clsid }, *cached;
+    HRESULT hr;
+
+    EnterCriticalSection(&class_cache_cs);
+    if (!(cached = class_cache_get(clsid))) cached = &uncached;
+    hr = class_cache_resolve(cached, CLASS_CACHE_TREAT_AS);
+    *treat_as = cached->treat_as;
+    LeaveCriticalSection(&class_cache_cs);
+
+    return hr;
+}
+
+static HRESULT get_class_server(REFCLSID clsid, enum class_cache_data data, struct class_server_info *server)
+{
+    struct class_cache_entry uncached = { .clsid = *clsid }, *cached;
+    HRESULT hr;
+
+    EnterCriticalSection(&class_cache_cs);
+    if (!(cached = class_cache_get(clsid))) cached = &uncached;
+    hr = class_cache_resolve(cached, data);
+    *server = cached->server[data - CLASS_CACHE_INPROC_SERVER];
+    LeaveCriticalSection(&class_cache_cs);
+
+    return hr;
+}
+
+/* Flushes the cache after the classes have been changed by the process. */
+static void class_cache_invalidate(void)
+{
+    EnterCriticalSection(&class_cache_cs);
+    if (class_cache_count)
+        TRACE_(olecache)("classes written, flushing %u entries\n", class_cache_count);
+    class_cache_flush();
+    LeaveCriticalSection(&class_cache_cs);
+}
+
+static void class_cache_cleanup(void)
+{
+    class_cache_flush();
+    if (class_cache_wait)
+    {
+        SetThreadpoolWait(class_cache_wait, NULL, NULL);
+        WaitForThreadpoolWaitCallbacks(class_cache_wait, TRUE);
+        CloseThreadpoolWait(class_cache_wait);
+    }
+    if (class_cache_event) CloseHandle(class_cache_event);
+    DeleteCriticalSection(&class_cache_cs);
+}
+
 /***********************************************************************
  *           InternalIsProcessInitialized  (combase.@)
  */
@@ -1207,34 +1462,61 @@ HRESULT WINAPI CoGetActivationState(GUID guid, DWORD arg2, DWORD *arg3)
  */
 HRESULT WINAPI CoGetTreatAsClass(REFCLSID clsidOld, CLSID *clsidNew)
 {
-    WCHAR buffW[CHARS_IN_GUID];
-    LONG len = sizeof(buffW);
-    HRESULT hr = S_OK;
-    HKEY hkey = NULL;
-
     TRACE("%s, %p.\n", debugstr_guid(clsidOld), clsidNew);
 
     if (!clsidOld || !clsidNew)
         return E_INVALIDARG;
 
-    *clsidNew = *clsidOld;
+    return get_treat_as_class(clsidOld, clsidNew);
+}
 
-    hr = open_key_for_clsid(clsidOld, L"TreatAs", KEY_READ, &hkey);
-    if (FAILED(hr))
-    {
-        hr = S_FALSE;
+/******************************************************************************
+ *                CoTreatAsClass        (combase.@)
+ */
+HRESULT WINAPI CoTreatAsClass(REFCLSID clsidOld, REFCLSID clsidNew)
+{
+    WCHAR clsid_new[CHARS_IN_GUID], auto_treat_as[CHARS_IN_GUID];
+    LONG auto_treat_as_size = sizeof(auto_treat_as);
+    HRESULT hr = S_OK;
+    HKEY hkey = NULL;
+    CLSID id;
+
+    TRACE("%s, %s.\n", debugstr_guid(clsidOld), debugstr_guid(clsidNew));
+
+    if (FAILED(hr = open_key_for_clsid(clsidOld, NULL, KEY_READ | KEY_WRITE, &hkey)))
         goto done;
-    }
 
-    if (RegQueryValueW(hkey, NULL, buffW, &len))
+    if (IsEqualGUID(clsidOld, clsidNew))
     {
-        hr = S_FALSE;
-        goto done;
+        if (!RegQueryValueW(hkey, L"AutoTreatAs", auto_treat_as, &auto_treat_as_size) &&
+                CLSIDFromString(auto_treat_as, &id) == S_OK)
+        {
+            if (RegSetValueW(hkey, L"TreatAs", REG_SZ, auto_treat_as, sizeof(auto_treat_as)))
+                hr = REGDB_E_WRITEREGDB;
+        }
+        else if (RegDeleteKeyW(hkey, L"TreatAs"))
+            hr = REGDB_E_WRITEREGDB;
+    }
+    else if (IsEqualGUID(clsidNew, &CLSID_NULL))
+        RegDeleteKeyW(hkey, L"TreatAs");
+    else
+    {
+        if (!StringFromGUID2(clsidNew, clsid_new, ARRAY_SIZE(clsid_new)))
+        {
+            WARN("StringFromGUID2 failed\n");
+            hr = E_FAIL;
+            goto done;
+        }
+
+        if (RegSetValueW(hkey, L"TreatAs", REG_SZ, clsid_new, sizeof(clsid_new)))
+        {
+            WARN("RegSetValue failed\n");
+            hr = REGDB_E_WRITEREGDB;
+        }
     }
 
-    hr = CLSIDFromString(buffW, clsidNew);
-    if (FAILED(hr))
-        ERR("Failed to get CLSID from string %s, hr %#lx.\n", debugstr_w(buffW), hr);
+    class_cache_invalidate();
+
 done:
     if (hkey) RegCloseKey(hkey);
     return hr;
@@ -1699,6 +1981,7 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
         COSERVERINFO *server_info, REFIID riid, void **obj)
 {
     struct class_reg_data clsreg = { 0 };
+    struct class_server_info server;
     HRESULT hr = E_UNEXPECTED;
     IUnknown *registered_obj;
     struct apartment *apt;
@@ -1771,9 +2054,7 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
     /* First try in-process server */
     if (clscontext & CLSCTX_INPROC_SERVER)
     {
-        HKEY hkey;
-
-        hr = open_key_for_clsid(rclsid, L"InprocServer32", KEY_READ, &hkey);
+        hr = get_class_server(rclsid, CLASS_CACHE_INPROC_SERVER, &server);
         if (FAILED(hr))
         {
             if (hr == REGDB_E_CLASSNOTREG)
@@ -1787,11 +2068,10 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
 
         if (SUCCEEDED(hr))
         {
-            clsreg.u.hkey = hkey;
+            clsreg.u.server = &server;
             clsreg.origin = CLASS_REG_REGISTRY;
 
             hr = apartment_get_inproc_class_object(apt, &clsreg, rclsid, riid, clscontext, obj);
-            RegCloseKey(hkey);
         }
 
         /* return if we got a class, otherwise fall through to one of the
@@ -1806,9 +2086,7 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
     /* Next try in-process handler */
     if (clscontext & CLSCTX_INPROC_HANDLER)
     {
-        HKEY hkey;
-
-        hr = open_key_for_clsid(rclsid, L"InprocHandler32", KEY_READ, &hkey);
+        hr = get_class_server(rclsid, CLASS_CACHE_INPROC_HANDLER, &server);
         if (FAILED(hr))
         {
             if (hr == REGDB_E_CLASSNOTREG)
@@ -1822,11 +2100,10 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
 
         if (SUCCEEDED(hr))
         {
-            clsreg.u.hkey = hkey;
+            clsreg.u.server = &server;
             clsreg.origin = CLASS_REG_REGISTRY;
 
             hr = apartment_get_inproc_class_object(apt, &clsreg, rclsid, riid, clscontext, obj);
-            RegCloseKey(hkey);
         }
 
         /* return if we got a class, otherwise fall through to one of the
@@ -3377,6 +3654,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD reason, LPVOID reserved)
         if (reserved) break;
         apartment_global_cleanup();
         DeleteCriticalSection(&registered_classes_cs);
+        class_cache_cleanup();
         rpc_unregister_channel_hooks();
         break;
     case DLL_THREAD_DETACH:
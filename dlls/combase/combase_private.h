@@ -141,6 +141,15 @@ enum class_reg_data_origin
     CLASS_REG_REGISTRY,
 };
 
+/* InprocServer32/InprocHandler32 values, as kept in the class cache */
+struct class_server_info
+{
+    LSTATUS path_status;
+    DWORD path_type;
+    WCHAR path[MAX_PATH + 1];
+    WCHAR threading_model[10 /* lstrlenW(L"apartment")+1 */];
+};
+
 struct class_reg_data
 {
     enum class_reg_data_origin origin;
@@ -152,7 +161,7 @@ struct class_reg_data
             DWORD threading_model;
             HANDLE hactctx;
         } actctx;
-        HKEY hkey;
+        const struct class_server_info *server;
     } u;
 };
 
@@ -34,6 +34,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(crypt);
 WINE_DECLARE_DEBUG_CHANNEL(chain);
 
 #define DEFAULT_CYCLE_MODULUS 7
+#define MAX_CACHED_CHAINS 32
 
 /* This represents a subset of a certificate chain engine:  it doesn't include
  * the "hOther" store described by MSDN, because I'm not sure how that's used.
@@ -49,8 +50,41 @@ typedef struct _CertificateChainEngine
     DWORD      dwUrlRetrievalTimeout;
     DWORD      MaximumCachedCertificates;
     DWORD      CycleDetectionModulus;
+    CRITICAL_SECTION cs;
+    struct list      chainCache;
+    DWORD            cCachedChains;
 } CertificateChainEngine;
 
+/* The parameters a chain was built with, as far as they affect the result
+ * before the revocation and usage checks.
+ */
+struct chain_cache_key
+{
+    BYTE       hash[20];    /* hash of the end cert */
+    HCERTSTORE additional;  /* hAdditionalStore */
+    DWORD      flags;
+    BOOL       now;         /* built for the current time */
+    FILETIME   time;        /* pTime, if not built for the current time */
+};
+
+/* A chain the engine has already built and verified, as it was before the
+ * revocation and usage checks, which are redone for every request.  It's only
+ * reused as long as the engine's stores and the additional store are
+ * unchanged.  Chains built for the current time are reused while it lies
+ * within the validity period of every cert in the chain.  The additional
+ * store can't go away while the entry exists, since the chain's world holds
+ * a reference to it.
+ */
+struct cached_chain
+{
+    struct list                entry;
+    struct chain_cache_key     key;
+    LONG                       generation;
+    FILETIME                   notBefore;
+    FILETIME                   notAfter;
+    PCCERT_CHAIN_CONTEXT       chain;
+};
+
 static inline void CRYPT_AddStoresToCollection(HCERTSTORE collection,
  DWORD cStores, HCERTSTORE *stores)
 {
@@ -153,6 +187,10 @@ HCERTCHAINENGINE CRYPT_CreateChainEngine(HCERTSTORE root, DWORD system_store, co
         engine->CycleDetectionModulus = config->CycleDetectionModulus;
     else
         engine->CycleDetectionModulus = DEFAULT_CYCLE_MODULUS;
+    InitializeCriticalSection(&engine->cs);
+    engine->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": CertificateChainEngine.cs");
+    list_init(&engine->chainCache);
+    engine->cCachedChains = 0;
 
     return engine;
 }
@@ -196,9 +234,18 @@ static CertificateChainEngine *get_chain_engine(HCERTCHAINENGINE handle, BOOL al
 
 static void free_chain_engine(CertificateChainEngine *engine)
 {
+    struct cached_chain *cached, *next;
+
     if(!engine || InterlockedDecrement(&engine->ref))
         return;
 
+    LIST_FOR_EACH_ENTRY_SAFE(cached, next, &engine->chainCache, struct cached_chain, entry)
+    {
+        CertFreeCertificateChain(cached->chain);
+        CryptMemFree(cached);
+    }
+    engine->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&engine->cs);
     CertCloseStore(engine->hWorld, 0);
     CertCloseStore(engine->hRoot, 0);
     CryptMemFree(engine);
@@ -2872,14 +2919,225 @@ static void dump_chain_para(const CERT_CHAIN_PARA *pChainPara)
     }
 }
 
+static BOOL CRYPT_GetChainCacheKey(PCCERT_CONTEXT cert, const FILETIME *pTime,
+ HCERTSTORE hAdditionalStore, DWORD flags, struct chain_cache_key *key)
+{
+    DWORD size = sizeof(key->hash);
+
+    memset(key, 0, sizeof(*key));
+    key->additional = hAdditionalStore;
+    key->flags = flags;
+    key->now = !pTime;
+    if (pTime)
+        key->time = *pTime;
+    return CertGetCertificateContextProperty(cert, CERT_HASH_PROP_ID,
+     key->hash, &size);
+}
+
+static BOOL CRYPT_ChainCacheKeyEqual(const struct chain_cache_key *key1,
+ const struct chain_cache_key *key2)
+{
+    return !memcmp(key1->hash, key2->hash, sizeof(key1->hash)) &&
+     key1->additional == key2->additional && key1->flags == key2->flags &&
+     key1->now == key2->now &&
+     (key1->now || !CompareFileTime(&key1->time, &key2->time));
+}
+
+/* Makes a copy of chain that can be modified independently of it.  If cert
+ * isn't NULL, it replaces the end cert of the copy.
+ */
+static CertificateChain *CRYPT_DuplicateChainContext(
+ const CertificateChain *chain, PCCERT_CONTEXT cert)
+{
+    CertificateChain *copy = CryptMemAlloc(sizeof(CertificateChain));
+    DWORD i, j;
+
+    if (!copy)
+        return NULL;
+    copy->ref = 1;
+    copy->world = CertDuplicateStore(chain->world);
+    copy->context = chain->context;
+    copy->context.cChain = 0;
+    copy->context.cLowerQualityChainContext = 0;
+    copy->context.rgpLowerQualityChainContext = NULL;
+    copy->context.rgpChain = CryptMemAlloc(
+     chain->context.cChain * sizeof(PCERT_SIMPLE_CHAIN));
+    if (!copy->context.rgpChain)
+    {
+        CertCloseStore(copy->world, 0);
+        CryptMemFree(copy);
+        return NULL;
+    }
+    for (i = 0; i < chain->context.cChain; i++)
+    {
+        const CERT_SIMPLE_CHAIN *simpleChain = chain->context.rgpChain[i];
+        PCERT_SIMPLE_CHAIN simpleCopy = CryptMemAlloc(sizeof(CERT_SIMPLE_CHAIN));
+
+        if (!simpleCopy)
+            break;
+        *simpleCopy = *simpleChain;
+        simpleCopy->cElement = 0;
+        simpleCopy->rgpElement = CryptMemAlloc(
+         simpleChain->cElement * sizeof(PCERT_CHAIN_ELEMENT));
+        copy->context.rgpChain[copy->context.cChain++] = simpleCopy;
+        if (!simpleCopy->rgpElement)
+            break;
+        for (j = 0; j < simpleChain->cElement; j++)
+        {
+            PCERT_CHAIN_ELEMENT element =
+             CryptMemAlloc(sizeof(CERT_CHAIN_ELEMENT));
+
+            if (!element)
+                break;
+            *element = *simpleChain->rgpElement[j];
+            element->pCertContext = CertDuplicateCertificateContext(
+             !i && !j && cert ? cert : element->pCertContext);
+            simpleCopy->rgpElement[simpleCopy->cElement++] = element;
+        }
+        if (j < simpleChain->cElement)
+            break;
+    }
+    if (i < chain->context.cChain)
+    {
+        CRYPT_FreeChainContext(copy);
+        copy = NULL;
+    }
+    return copy;
+}
+
+/* Gets the generation of the stores a chain is built from.  Returns FALSE if
+ * changes to them can't be tracked, in which case the chain can't be cached.
+ */
+static BOOL CRYPT_GetChainGeneration(const CertificateChainEngine *engine,
+ HCERTSTORE hAdditionalStore, LONG *generation)
+{
+    LONG additional;
+
+    /* The root store is part of the world, so checking the latter suffices. */
+    if (!CRYPT_GetStoreGeneration(engine->hWorld, generation))
+        return FALSE;
+    if (!hAdditionalStore)
+        return TRUE;
+    if (!CRYPT_GetStoreGeneration(hAdditionalStore, &additional))
+        return FALSE;
+    *generation = max(*generation, additional);
+    return TRUE;
+}
+
+static CertificateChain *CRYPT_FindCachedChain(CertificateChainEngine *engine,
+ const struct chain_cache_key *key, LONG generation, PCCERT_CONTEXT cert)
+{
+    struct cached_chain *cached;
+    CertificateChain *chain = NULL;
+    FILETIME time;
+
+    if (key->now)
+        GetSystemTimeAsFileTime(&time);
+    else
+        time = key->time;
+
+    EnterCriticalSection(&engine->cs);
+    LIST_FOR_EACH_ENTRY(cached, &engine->chainCache, struct cached_chain, entry)
+    {
+        if (!CRYPT_ChainCacheKeyEqual(&cached->key, key))
+            continue;
+        if (cached->generation != generation)
+        {
+            TRACE_(chain)("discarding stale chain %p\n", cached->chain);
+            list_remove(&cached->entry);
+            engine->cCachedChains--;
+            CertFreeCertificateChain(cached->chain);
+            CryptMemFree(cached);
+        }
+        else if (CompareFileTime(&time, &cached->notBefore) >= 0 &&
+         CompareFileTime(&time, &cached->notAfter) <= 0)
+        {
+            chain = CRYPT_DuplicateChainContext(
+             (const CertificateChain *)cached->chain, cert);
+            list_remove(&cached->entry);
+            list_add_head(&engine->chainCache, &cached->entry);
+        }
+        break;
+    }
+    LeaveCriticalSection(&engine->cs);
+    TRACE_(chain)("%s for %p\n", chain ? "hit" : "miss", cert);
+    return chain;
+}
+
+static void CRYPT_CacheChain(CertificateChainEngine *engine,
+ const struct chain_cache_key *key, LONG generation,
+ const CertificateChain *chain)
+{
+    struct cached_chain *cached, *old, *next;
+    CertificateChain *copy;
+    FILETIME notBefore = { 0, 0 }, notAfter = { ~0u, ~0u };
+    DWORD i, j;
+
+    /* A chain that's not time valid is cheap to rebuild, and it couldn't be
+     * reused at any other time anyway.
+     */
+    if (chain->context.TrustStatus.dwErrorStatus &
+     (CERT_TRUST_IS_NOT_TIME_VALID | CERT_TRUST_IS_NOT_TIME_NESTED))
+        return;
+    for (i = 0; i < chain->context.cChain; i++)
+    {
+        const CERT_SIMPLE_CHAIN *simpleChain = chain->context.rgpChain[i];
+
+        for (j = 0; j < simpleChain->cElement; j++)
+        {
+            const CERT_INFO *info = simpleChain->rgpElement[j]->pCertContext->pCertInfo;
+
+            if (CompareFileTime(&info->NotBefore, &notBefore) > 0)
+                notBefore = info->NotBefore;
+            if (CompareFileTime(&info->NotAfter, &notAfter) < 0)
+                notAfter = info->NotAfter;
+        }
+    }
+
+    if (!(cached = CryptMemAlloc(sizeof(*cached))))
+        return;
+    if (!(copy = CRYPT_DuplicateChainContext(chain, NULL)))
+    {
+        CryptMemFree(cached);
+        return;
+    }
+    cached->key = *key;
+    cached->generation = generation;
+    cached->notBefore = notBefore;
+    cached->notAfter = notAfter;
+    cached->chain = &copy->context;
+
+    EnterCriticalSection(&engine->cs);
+    LIST_FOR_EACH_ENTRY_SAFE(old, next, &engine->chainCache, struct cached_chain, entry)
+    {
+        /* Replace any older entry for the same key, and evict the least
+         * recently used one when the cache is full.
+         */
+        if (CRYPT_ChainCacheKeyEqual(&old->key, key) ||
+         (engine->cCachedChains >= MAX_CACHED_CHAINS &&
+          &old->entry == list_tail(&engine->chainCache)))
+        {
+            list_remove(&old->entry);
+            engine->cCachedChains--;
+            CertFreeCertificateChain(old->chain);
+            CryptMemFree(old);
+        }
+    }
+    list_add_head(&engine->chainCache, &cached->entry);
+    engine->cCachedChains++;
+    LeaveCriticalSection(&engine->cs);
+}
+
 BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
  PCCERT_CONTEXT pCertContext, LPFILETIME pTime, HCERTSTORE hAdditionalStore,
  PCERT_CHAIN_PARA pChainPara, DWORD dwFlags, LPVOID pvReserved,
  PCCERT_CHAIN_CONTEXT* ppChainContext)
 {
     CertificateChainEngine *engine;
-    BOOL ret;
+    BOOL ret, cacheable;
     CertificateChain *chain = NULL;
+    struct chain_cache_key key;
+    LONG generation = 0;
 
     TRACE("(%p, %p, %s, %p, %p, %08lx, %p, %p)\n", hChainEngine, pCertContext,
      debugstr_filetime(pTime), hAdditionalStore, pChainPara, dwFlags,
@@ -2904,13 +3162,23 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
 
     if (TRACE_ON(chain))
         dump_chain_para(pChainPara);
+    /* Chains with lower quality contexts aren't cached. */
+    /* Get the generation before building, so that any concurrent change to
+     * the stores invalidates the chain being built.
+     */
+    cacheable = !(dwFlags & CERT_CHAIN_RETURN_LOWER_QUALITY_CONTEXTS) &&
+     CRYPT_GetChainCacheKey(pCertContext, pTime, hAdditionalStore, dwFlags,
+     &key) &&
+     CRYPT_GetChainGeneration(engine, hAdditionalStore, &generation);
+    if (cacheable)
+        chain = CRYPT_FindCachedChain(engine, &key, generation, pCertContext);
+    if (chain)
+        ret = TRUE;
     /* FIXME: what about HCCE_LOCAL_MACHINE? */
-    ret = CRYPT_BuildCandidateChainFromCert(engine, pCertContext, pTime,
-     hAdditionalStore, dwFlags, &chain);
-    if (ret)
+    else if ((ret = CRYPT_BuildCandidateChainFromCert(engine, pCertContext,
+     pTime, hAdditionalStore, dwFlags, &chain)))
     {
         CertificateChain *alternate = NULL;
-        PCERT_CHAIN_CONTEXT pChain;
 
         do {
             alternate = CRYPT_BuildAlternateContextFromChain(engine,
@@ -2926,7 +3194,13 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
         chain = CRYPT_ChooseHighestQualityChain(chain);
         if (!(dwFlags & CERT_CHAIN_RETURN_LOWER_QUALITY_CONTEXTS))
             CRYPT_FreeLowerQualityChains(chain);
-        pChain = (PCERT_CHAIN_CONTEXT)chain;
+        if (ret && cacheable)
+            CRYPT_CacheChain(engine, &key, generation, chain);
+    }
+    if (chain)
+    {
+        PCERT_CHAIN_CONTEXT pChain = (PCERT_CHAIN_CONTEXT)chain;
+
         CRYPT_VerifyChainRevocation(pChain, pTime, hAdditionalStore,
          pChainPara, dwFlags);
         CRYPT_CheckUsages(pChain, pChainPara);
@@ -404,6 +404,25 @@ static BOOL Collection_deleteCTL(WINECRYPT_CERTSTORE *store, context_t *context)
     return CertDeleteCTLFromStore(&linked->ctx);
 }
 
+BOOL CRYPT_CollectionGetGeneration(WINECRYPT_CERTSTORE *cert_store, LONG *generation)
+{
+    WINE_COLLECTIONSTORE *store = (WINE_COLLECTIONSTORE*)cert_store;
+    WINE_STORE_LIST_ENTRY *entry;
+    LONG sibling;
+    BOOL ret = TRUE;
+
+    EnterCriticalSection(&store->cs);
+    *generation = store->hdr.generation;
+    LIST_FOR_EACH_ENTRY(entry, &store->stores, WINE_STORE_LIST_ENTRY, entry)
+    {
+        if (!(ret = CRYPT_GetStoreGeneration(entry->store, &sibling)))
+            break;
+        *generation = max(*generation, sibling);
+    }
+    LeaveCriticalSection(&store->cs);
+    return ret;
+}
+
 static BOOL Collection_control(WINECRYPT_CERTSTORE *cert_store, DWORD dwFlags,
  DWORD dwCtrlType, void const *pvCtrlPara)
 {
@@ -545,6 +564,7 @@ BOOL WINAPI CertAddStoreToCollection(HCERTSTORE hCollectionStore,
         }
         else
             list_add_tail(&collection->stores, &entry->entry);
+        CRYPT_StoreModified(&collection->hdr);
         LeaveCriticalSection(&collection->cs);
         ret = TRUE;
     }
@@ -584,6 +604,7 @@ void WINAPI CertRemoveStoreFromCollection(HCERTSTORE hCollectionStore,
             list_remove(&store->entry);
             CertCloseStore(store->store, 0);
             CryptMemFree(store);
+            CRYPT_StoreModified(&collection->hdr);
             break;
         }
     }
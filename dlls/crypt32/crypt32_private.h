@@ -324,11 +324,24 @@ typedef struct WINE_CRYPTCERTSTORE
     CertStoreType               type;
     const store_vtbl_t         *vtbl;
     CONTEXT_PROPERTY_LIST      *properties;
+    LONG                        generation;
 } WINECRYPT_CERTSTORE;
 
 void CRYPT_InitStore(WINECRYPT_CERTSTORE *store, DWORD dwFlags,
  CertStoreType type, const store_vtbl_t*);
 void CRYPT_FreeStore(WINECRYPT_CERTSTORE *store);
+
+/* Marks store as modified, giving it a new, process-wide unique generation. */
+void CRYPT_StoreModified(WINECRYPT_CERTSTORE *store);
+/* Gets the most recent generation of store or, for collection and provider
+ * stores, of any store it's made of.  The value changes whenever a context is
+ * added to or removed from any of them, or when a collection's siblings change.
+ * Returns FALSE if the store's contents can't be tracked, e.g. because they're
+ * only known to an external provider.
+ */
+BOOL CRYPT_GetStoreGeneration(WINECRYPT_CERTSTORE *store, LONG *generation);
+BOOL CRYPT_CollectionGetGeneration(WINECRYPT_CERTSTORE *store, LONG *generation);
+BOOL CRYPT_ProvGetGeneration(WINECRYPT_CERTSTORE *store, LONG *generation);
 BOOL WINAPI I_CertUpdateStore(HCERTSTORE store1, HCERTSTORE store2, DWORD unk0,
  DWORD unk1);
 
@@ -372,6 +372,17 @@ WINECRYPT_CERTSTORE *CRYPT_ProvCreateStore(DWORD dwFlags,
     return (WINECRYPT_CERTSTORE*)ret;
 }
 
+BOOL CRYPT_ProvGetGeneration(WINECRYPT_CERTSTORE *cert_store, LONG *generation)
+{
+    WINE_PROVIDERSTORE *store = (WINE_PROVIDERSTORE*)cert_store;
+
+    /* The contents of an external store are only known to its provider. */
+    if (!store->memStore || !CRYPT_GetStoreGeneration(store->memStore, generation))
+        return FALSE;
+    *generation = max(*generation, store->hdr.generation);
+    return TRUE;
+}
+
 WINECRYPT_CERTSTORE *CRYPT_ProvOpenStore(LPCSTR lpszStoreProvider,
  DWORD dwEncodingType, HCRYPTPROV hCryptProv, DWORD dwFlags, const void *pvPara)
 {
@@ -93,6 +93,7 @@ void CRYPT_InitStore(WINECRYPT_CERTSTORE *store, DWORD dwFlags, CertStoreType ty
     store->dwOpenFlags = dwFlags;
     store->vtbl = vtbl;
     store->properties = NULL;
+    store->generation = 0;
 }
 
 void CRYPT_FreeStore(WINECRYPT_CERTSTORE *store)
@@ -103,6 +104,27 @@ void CRYPT_FreeStore(WINECRYPT_CERTSTORE *store)
     CryptMemFree(store);
 }
 
+static LONG store_generation;
+
+void CRYPT_StoreModified(WINECRYPT_CERTSTORE *store)
+{
+    store->generation = InterlockedIncrement(&store_generation);
+}
+
+BOOL CRYPT_GetStoreGeneration(WINECRYPT_CERTSTORE *store, LONG *generation)
+{
+    switch (store->type)
+    {
+    case StoreTypeCollection:
+        return CRYPT_CollectionGetGeneration(store, generation);
+    case StoreTypeProvider:
+        return CRYPT_ProvGetGeneration(store, generation);
+    default:
+        *generation = store->generation;
+        return TRUE;
+    }
+}
+
 BOOL WINAPI I_CertUpdateStore(HCERTSTORE store1, HCERTSTORE store2, DWORD unk0,
  DWORD unk1)
 {
@@ -162,6 +184,7 @@ static BOOL MemStore_addContext(WINE_MEMSTORE *store, struct list *list, context
     }else {
         list_add_head(list, &context->u.entry);
     }
+    CRYPT_StoreModified(&store->hdr);
     LeaveCriticalSection(&store->cs);
 
     if(ret_context)
@@ -204,6 +227,7 @@ static BOOL MemStore_deleteContext(WINE_MEMSTORE *store, context_t *context)
         list_remove(&context->u.entry);
         list_init(&context->u.entry);
         in_list = TRUE;
+        CRYPT_StoreModified(&store->hdr);
     }
     LeaveCriticalSection(&store->cs);
 
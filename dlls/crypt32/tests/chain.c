@@ -4623,6 +4623,115 @@ static void testGetCertChain(void)
     CertCloseStore(store, 0);
 }
 
+static void test_chain_cache(void)
+{
+    static char one_two_three[] = "1.2.3";
+    LPSTR oids[] = { one_two_three };
+    CERT_CHAIN_ENGINE_CONFIG config = { sizeof(config) };
+    CERT_CHAIN_PARA para = { sizeof(para) };
+    PCCERT_CHAIN_CONTEXT chain, prev;
+    HCERTCHAINENGINE engine;
+    HCERTSTORE root, store, store2;
+    PCCERT_CONTEXT cert;
+    FILETIME fileTime;
+    DWORD i;
+    BOOL ret;
+
+    root = CertOpenStore(CERT_STORE_PROV_MEMORY, 0, 0, CERT_STORE_CREATE_NEW_FLAG, NULL);
+    config.hExclusiveRoot = root;
+    if (!CertCreateCertificateChainEngine(&config, &engine))
+    {
+        skip("Couldn't create chain engine\n");
+        CertCloseStore(root, 0);
+        return;
+    }
+
+    store = CertOpenStore(CERT_STORE_PROV_MEMORY, 0, 0, CERT_STORE_CREATE_NEW_FLAG, NULL);
+    ret = CertAddEncodedCertificateToStore(store, X509_ASN_ENCODING, usertrust_ca, sizeof(usertrust_ca),
+            CERT_STORE_ADD_ALWAYS, NULL);
+    ok(ret, "CertAddEncodedCertificateToStore failed: %08lx\n", GetLastError());
+    ret = CertAddEncodedCertificateToStore(store, X509_ASN_ENCODING, incommon_rsa_ca, sizeof(incommon_rsa_ca),
+            CERT_STORE_ADD_ALWAYS, NULL);
+    ok(ret, "CertAddEncodedCertificateToStore failed: %08lx\n", GetLastError());
+    ret = CertAddEncodedCertificateToStore(store, X509_ASN_ENCODING, cs_stanford_edu, sizeof(cs_stanford_edu),
+            CERT_STORE_ADD_ALWAYS, &cert);
+    ok(ret, "CertAddEncodedCertificateToStore failed: %08lx\n", GetLastError());
+    SystemTimeToFileTime(&nov2016, &fileTime);
+
+    /* Repeatedly building the same chain gives independent, identical results. */
+    prev = NULL;
+    for (i = 0; i < 3; i++)
+    {
+        ret = CertGetCertificateChain(engine, cert, &fileTime, store, &para, 0, NULL, &chain);
+        ok(ret, "CertGetCertificateChain failed: %08lx\n", GetLastError());
+        ok(chain != prev, "got the same chain context twice\n");
+        ok(chain->TrustStatus.dwErrorStatus == CERT_TRUST_IS_UNTRUSTED_ROOT,
+           "%lu: unexpected error status %08lx\n", i, chain->TrustStatus.dwErrorStatus);
+        ok(chain->cChain == 1, "%lu: unexpected chain count %lu\n", i, chain->cChain);
+        ok(chain->rgpChain[0]->cElement == 3, "%lu: unexpected element count %lu\n", i,
+           chain->rgpChain[0]->cElement);
+        ok(chain->rgpChain[0]->rgpElement[0]->pCertContext == cert, "%lu: unexpected end cert\n", i);
+        if (prev)
+            CertFreeCertificateChain(prev);
+        prev = chain;
+    }
+    CertFreeCertificateChain(prev);
+
+    /* The chain built with another additional store isn't reused. */
+    store2 = CertOpenStore(CERT_STORE_PROV_MEMORY, 0, 0, CERT_STORE_CREATE_NEW_FLAG, NULL);
+    ret = CertGetCertificateChain(engine, cert, &fileTime, store2, &para, 0, NULL, &chain);
+    ok(ret, "CertGetCertificateChain failed: %08lx\n", GetLastError());
+    ok(chain->TrustStatus.dwErrorStatus == (CERT_TRUST_IS_PARTIAL_CHAIN | CERT_TRUST_IS_UNTRUSTED_ROOT) ||
+       chain->TrustStatus.dwErrorStatus == CERT_TRUST_IS_PARTIAL_CHAIN,
+       "unexpected error status %08lx\n", chain->TrustStatus.dwErrorStatus);
+    ok(chain->rgpChain[0]->cElement == 1, "unexpected element count %lu\n", chain->rgpChain[0]->cElement);
+    CertFreeCertificateChain(chain);
+
+    /* Changes to the additional store are noticed. */
+    ret = CertAddEncodedCertificateToStore(store2, X509_ASN_ENCODING, incommon_rsa_ca, sizeof(incommon_rsa_ca),
+            CERT_STORE_ADD_ALWAYS, NULL);
+    ok(ret, "CertAddEncodedCertificateToStore failed: %08lx\n", GetLastError());
+    ret = CertGetCertificateChain(engine, cert, &fileTime, store2, &para, 0, NULL, &chain);
+    ok(ret, "CertGetCertificateChain failed: %08lx\n", GetLastError());
+    ok(chain->rgpChain[0]->cElement == 2, "unexpected element count %lu\n", chain->rgpChain[0]->cElement);
+    CertFreeCertificateChain(chain);
+    CertCloseStore(store2, 0);
+
+    /* Usage checks are applied to each chain separately. */
+    para.RequestedUsage.dwType = USAGE_MATCH_TYPE_AND;
+    para.RequestedUsage.Usage.cUsageIdentifier = 1;
+    para.RequestedUsage.Usage.rgpszUsageIdentifier = oids;
+    ret = CertGetCertificateChain(engine, cert, &fileTime, store, &para, 0, NULL, &chain);
+    ok(ret, "CertGetCertificateChain failed: %08lx\n", GetLastError());
+    ok(chain->TrustStatus.dwErrorStatus == (CERT_TRUST_IS_UNTRUSTED_ROOT | CERT_TRUST_IS_NOT_VALID_FOR_USAGE),
+       "unexpected error status %08lx\n", chain->TrustStatus.dwErrorStatus);
+    CertFreeCertificateChain(chain);
+    memset(&para.RequestedUsage, 0, sizeof(para.RequestedUsage));
+
+    /* A time outside the end cert's validity isn't answered from earlier results. */
+    SystemTimeToFileTime(&oct2016, &fileTime);
+    ret = CertGetCertificateChain(engine, cert, &fileTime, store, &para, 0, NULL, &chain);
+    ok(ret, "CertGetCertificateChain failed: %08lx\n", GetLastError());
+    ok(chain->TrustStatus.dwErrorStatus == (CERT_TRUST_IS_UNTRUSTED_ROOT | CERT_TRUST_IS_NOT_TIME_VALID),
+       "unexpected error status %08lx\n", chain->TrustStatus.dwErrorStatus);
+    CertFreeCertificateChain(chain);
+
+    /* Trusting the root is noticed. */
+    SystemTimeToFileTime(&nov2016, &fileTime);
+    ret = CertAddEncodedCertificateToStore(root, X509_ASN_ENCODING, usertrust_ca, sizeof(usertrust_ca),
+            CERT_STORE_ADD_ALWAYS, NULL);
+    ok(ret, "CertAddEncodedCertificateToStore failed: %08lx\n", GetLastError());
+    ret = CertGetCertificateChain(engine, cert, &fileTime, store, &para, 0, NULL, &chain);
+    ok(ret, "CertGetCertificateChain failed: %08lx\n", GetLastError());
+    ok(!chain->TrustStatus.dwErrorStatus, "unexpected error status %08lx\n", chain->TrustStatus.dwErrorStatus);
+    CertFreeCertificateChain(chain);
+
+    CertFreeCertificateContext(cert);
+    CertCloseStore(store, 0);
+    CertFreeCertificateChainEngine(engine);
+    CertCloseStore(root, 0);
+}
+
 static void test_CERT_CHAIN_PARA_cbSize(void)
 {
     BOOL ret;
@@ -5385,4 +5494,5 @@ START_TEST(chain)
     testVerifyCertChainPolicy();
     testGetCertChain();
     test_CERT_CHAIN_PARA_cbSize();
+    test_chain_cache();
 }
@@ -2552,6 +2552,97 @@ static void test_actctx(void)
     test_allowDelayedBinding();
 }
 
+static const char cache_test_manifest[] =
+"<assembly xmlns=\"urn:schemas-microsoft-com:asm.v1\" manifestVersion=\"1.0\">"
+"<assemblyIdentity version=\"1.2.3.4\" name=\"Wine.Test\" type=\"win32\"/>"
+"<dependency>"
+"<dependentAssembly>"
+"<assemblyIdentity type=\"win32\" name=\"Wine.Cache.Test\" version=\"1.0.0.0\" "
+    "processorArchitecture=\"" ARCH "\" publicKeyToken=\"6595b64144ccf1df\"/>"
+"</dependentAssembly>"
+"</dependency>"
+"</assembly>";
+
+static const char cache_test_sxs_manifest[] =
+"<assembly xmlns=\"urn:schemas-microsoft-com:asm.v1\" manifestVersion=\"1.0\">"
+"<assemblyIdentity type=\"win32\" name=\"Wine.Cache.Test\" version=\"1.0.0.0\" "
+    "processorArchitecture=\"" ARCH "\" publicKeyToken=\"6595b64144ccf1df\"/>"
+"<file name=\"%s\"/>"
+"</assembly>";
+
+static BOOL write_sxs_manifest(const char *path, const char *dllname)
+{
+    char buffer[1024];
+    DWORD size;
+    HANDLE file;
+
+    sprintf(buffer, cache_test_sxs_manifest, dllname);
+    file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return FALSE;
+    WriteFile(file, buffer, strlen(buffer), &size, NULL);
+    CloseHandle(file);
+    return TRUE;
+}
+
+static BOOL find_dll_in_actctx(HANDLE handle, const char *dllname)
+{
+    ACTCTX_SECTION_KEYED_DATA data;
+    ULONG_PTR cookie;
+    BOOL ret;
+
+    ret = ActivateActCtx(handle, &cookie);
+    ok(ret, "ActivateActCtx failed: %lu\n", GetLastError());
+    memset(&data, 0xfe, sizeof(data));
+    data.cbSize = sizeof(data);
+    ret = FindActCtxSectionStringA(0, NULL, ACTIVATION_CONTEXT_SECTION_DLL_REDIRECTION, dllname, &data);
+    DeactivateActCtx(0, cookie);
+    return ret;
+}
+
+static void test_CreateActCtx_shared_manifest_update(void)
+{
+    char path[MAX_PATH];
+    HANDLE handle;
+
+    GetWindowsDirectoryA(path, MAX_PATH);
+    strcat(path, "\\winsxs\\manifests\\" ARCH "_wine.cache.test_6595b64144ccf1df_1.0.0.0_none_0123abcd.manifest");
+    if (!write_sxs_manifest(path, "testa.dll"))
+    {
+        skip("Could not create %s, error %lu\n", path, GetLastError());
+        return;
+    }
+    if (!create_manifest_file("test_cache.manifest", cache_test_manifest, -1, NULL, NULL))
+    {
+        DeleteFileA(path);
+        return;
+    }
+
+    handle = test_create("test_cache.manifest");
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        win_skip("Shared assembly manifest not found\n");
+        goto done;
+    }
+    ok(find_dll_in_actctx(handle, "testa.dll"), "testa.dll not found\n");
+    ok(!find_dll_in_actctx(handle, "testb.dll"), "testb.dll found\n");
+    ReleaseActCtx(handle);
+
+    /* same size, different contents: a new context must not use the previous parse */
+    ok(write_sxs_manifest(path, "testb.dll"), "Could not rewrite %s, error %lu\n", path, GetLastError());
+    handle = test_create("test_cache.manifest");
+    ok(handle != INVALID_HANDLE_VALUE, "CreateActCtx failed, error %lu\n", GetLastError());
+    if (handle != INVALID_HANDLE_VALUE)
+    {
+        ok(!find_dll_in_actctx(handle, "testa.dll"), "testa.dll found\n");
+        ok(find_dll_in_actctx(handle, "testb.dll"), "testb.dll not found\n");
+        ReleaseActCtx(handle);
+    }
+
+done:
+    DeleteFileA("test_cache.manifest");
+    DeleteFileA(path);
+}
+
 static void test_app_manifest(void)
 {
     HANDLE handle;
@@ -4426,6 +4517,7 @@ START_TEST(actctx)
     test_manifest_resources();
     test_valid_manifest_resources_locale();
     test_actctx();
+    test_CreateActCtx_shared_manifest_update();
     test_create_fail();
     test_CreateActCtx();
     test_CreateActCtx_share_mode();
@@ -4161,6 +4161,53 @@ static void test_dll_file( const char *name )
 #undef OK_FIELD
 }
 
+static void test_image_section_update(void)
+{
+    IMAGE_NT_HEADERS nt_header = nt_header_template;
+    char dll_name[MAX_PATH], new_name[MAX_PATH];
+    SECTION_IMAGE_INFORMATION image[2];
+    HANDLE file, mapping;
+    NTSTATUS status;
+    DWORD size;
+    BOOL ret;
+    int i;
+
+    size = create_test_dll( &dos_header, sizeof(dos_header), &nt_header, dll_name );
+    ok( size, "failed to create test dll\n" );
+    query_image_section( 0, dll_name, &nt_header, NULL );
+
+    /* sections created again from the same file report the same image */
+    file = CreateFileA( dll_name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, 0 );
+    ok( file != INVALID_HANDLE_VALUE, "CreateFile error %lu\n", GetLastError() );
+    for (i = 0; i < ARRAY_SIZE(image); i++)
+    {
+        status = pNtCreateSection( &mapping, STANDARD_RIGHTS_REQUIRED | SECTION_MAP_READ | SECTION_QUERY,
+                                   NULL, NULL, PAGE_READONLY, SEC_IMAGE, file );
+        ok( !status, "NtCreateSection failed err %lx\n", status );
+        memset( &image[i], 0xcc, sizeof(image[i]) );
+        status = pNtQuerySection( mapping, SectionImageInformation, &image[i], sizeof(image[i]), NULL );
+        ok( !status, "NtQuerySection failed err %lx\n", status );
+        CloseHandle( mapping );
+    }
+    ok( !memcmp( &image[0], &image[1], sizeof(image[0]) ), "image information differs\n" );
+    ok( image[1].MaximumStackSize == nt_header.OptionalHeader.SizeOfStackReserve, "got %#Ix\n",
+        image[1].MaximumStackSize );
+    CloseHandle( file );
+
+    /* rewriting the file in place with the same size must be noticed */
+    nt_header.OptionalHeader.SizeOfStackReserve *= 2;
+    nt_header.OptionalHeader.SizeOfStackCommit *= 2;
+    nt_header.OptionalHeader.AddressOfEntryPoint += 0x10;
+    ok( create_test_dll( &dos_header, sizeof(dos_header), &nt_header, new_name ) == size,
+        "size changed\n" );
+    ret = CopyFileA( new_name, dll_name, FALSE );
+    ok( ret, "CopyFile error %lu\n", GetLastError() );
+    query_image_section( 1, dll_name, &nt_header, NULL );
+
+    DeleteFileA( new_name );
+    DeleteFileA( dll_name );
+}
+
 static void test_LoadPackagedLibrary(void)
 {
     HMODULE h;
@@ -4177,6 +4224,61 @@ static void test_LoadPackagedLibrary(void)
             h, GetLastError());
 }
 
+static DWORD *get_export_entry( HMODULE module, const char *name )
+{
+    IMAGE_EXPORT_DIRECTORY *exports;
+    DWORD *functions, *names;
+    WORD *ordinals;
+    ULONG size, i;
+
+    exports = pRtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &size );
+    if (!exports) return NULL;
+    functions = (DWORD *)((char *)module + exports->AddressOfFunctions);
+    names = (DWORD *)((char *)module + exports->AddressOfNames);
+    ordinals = (WORD *)((char *)module + exports->AddressOfNameOrdinals);
+    for (i = 0; i < exports->NumberOfNames; i++)
+        if (!strcmp( (char *)module + names[i], name )) return &functions[ordinals[i]];
+    return NULL;
+}
+
+static void test_forwarded_export_patch(void)
+{
+    HMODULE ntdll = GetModuleHandleA( "ntdll.dll" ), kernel32 = GetModuleHandleA( "kernel32.dll" );
+    void *zero_memory, *fill_memory, *proc;
+    DWORD *entry, *fill_entry, rva, old_prot;
+    BOOL ret;
+
+    zero_memory = GetProcAddress( ntdll, "RtlZeroMemory" );
+    fill_memory = GetProcAddress( ntdll, "RtlFillMemory" );
+    proc = GetProcAddress( kernel32, "RtlZeroMemory" );
+    if (!proc || proc != zero_memory)
+    {
+        skip( "RtlZeroMemory is not forwarded to ntdll\n" );
+        return;
+    }
+
+    entry = get_export_entry( ntdll, "RtlZeroMemory" );
+    fill_entry = get_export_entry( ntdll, "RtlFillMemory" );
+    ok( entry && fill_entry, "export entries not found\n" );
+    if (!entry || !fill_entry) return;
+
+    ret = VirtualProtect( entry, sizeof(*entry), PAGE_READWRITE, &old_prot );
+    ok( ret, "VirtualProtect failed, error %lu\n", GetLastError() );
+    if (!ret) return;
+
+    /* the forward is resolved again with the patched export table */
+    rva = *entry;
+    *entry = *fill_entry;
+    proc = GetProcAddress( kernel32, "RtlZeroMemory" );
+    *entry = rva;
+    ok( proc == fill_memory, "got %p, expected %p\n", proc, fill_memory );
+
+    proc = GetProcAddress( kernel32, "RtlZeroMemory" );
+    ok( proc == zero_memory, "got %p, expected %p\n", proc, zero_memory );
+
+    VirtualProtect( entry, sizeof(*entry), old_prot, &old_prot );
+}
+
 static void test_Wow64Transition(void)
 {
     char buffer[400];
@@ -4281,6 +4383,8 @@ START_TEST(loader)
     test_ResolveDelayLoadedAPI();
     test_ImportDescriptors();
     test_section_access();
+    test_image_section_update();
+    test_forwarded_export_patch();
     test_import_resolution();
     test_ExitProcess();
     test_InMemoryOrderModuleList();
@@ -3824,7 +3824,7 @@
 @ cdecl _Mtx_init(ptr long)
 @ cdecl _Mtx_lock(ptr)
 @ cdecl _Mtx_reset_owner(ptr)
-@ stub _Mtx_timedlock
+@ cdecl _Mtx_timedlock(ptr ptr)
 @ cdecl _Mtx_trylock(ptr)
 @ cdecl _Mtx_unlock(ptr)
 @ stub _Mtxdst
@@ -3769,7 +3769,7 @@
 @ cdecl _Mtx_init(ptr long) msvcp120._Mtx_init
 @ cdecl _Mtx_lock(ptr) msvcp120._Mtx_lock
 @ cdecl _Mtx_reset_owner(ptr) msvcp120._Mtx_reset_owner
-@ stub _Mtx_timedlock
+@ cdecl _Mtx_timedlock(ptr ptr) msvcp120._Mtx_timedlock
 @ cdecl _Mtx_trylock(ptr) msvcp120._Mtx_trylock
 @ cdecl _Mtx_unlock(ptr) msvcp120._Mtx_unlock
 @ stub _Mtxdst
@@ -215,6 +215,8 @@ static int (__cdecl *p__Mtx_init)(_Mtx_t*, int);
 static void (__cdecl *p__Mtx_destroy)(_Mtx_t);
 static int (__cdecl *p__Mtx_lock)(_Mtx_t);
 static int (__cdecl *p__Mtx_unlock)(_Mtx_t);
+static int (__cdecl *p__Mtx_trylock)(_Mtx_t);
+static int (__cdecl *p__Mtx_timedlock)(_Mtx_t, const xtime*);
 static int (__cdecl *p__Cnd_init)(_Cnd_t*);
 static void (__cdecl *p__Cnd_destroy)(_Cnd_t);
 static int (__cdecl *p__Cnd_wait)(_Cnd_t, _Mtx_t);
@@ -327,6 +329,8 @@ static BOOL init(void)
     SET(p__Mtx_destroy, "_Mtx_destroy");
     SET(p__Mtx_lock, "_Mtx_lock");
     SET(p__Mtx_unlock, "_Mtx_unlock");
+    SET(p__Mtx_trylock, "_Mtx_trylock");
+    SET(p__Mtx_timedlock, "_Mtx_timedlock");
     SET(p__Cnd_init, "_Cnd_init");
     SET(p__Cnd_destroy, "_Cnd_destroy");
     SET(p__Cnd_wait, "_Cnd_wait");
@@ -1577,6 +1581,185 @@ static void test_cnd(void)
     CloseHandle(cm.initialized);
 }
 
+struct mtx_thread_data
+{
+    _Mtx_t mtx;
+    _Cnd_t cnd;
+    LONG *counter;
+    int loops;
+    int turn;
+};
+
+static int __cdecl mtx_timedlock_thread(void *arg)
+{
+    struct mtx_thread_data *data = arg;
+    xtime xt;
+    int r;
+
+    p_xtime_get(&xt, 1);
+    xt.nsec += 100000000;
+    r = p__Mtx_timedlock(data->mtx, &xt);
+    ok(r == 2, "_Mtx_timedlock returned %d\n", r);
+
+    p_xtime_get(&xt, 1);
+    xt.sec += 5;
+    r = p__Mtx_timedlock(data->mtx, &xt);
+    ok(!r, "_Mtx_timedlock returned %d\n", r);
+    p__Mtx_unlock(data->mtx);
+    return 0;
+}
+
+static int __cdecl mtx_counter_thread(void *arg)
+{
+    struct mtx_thread_data *data = arg;
+    int i;
+
+    for(i = 0; i < data->loops; i++)
+    {
+        p__Mtx_lock(data->mtx);
+        (*data->counter)++;
+        p__Mtx_unlock(data->mtx);
+    }
+    return 0;
+}
+
+static int __cdecl cnd_pingpong_thread(void *arg)
+{
+    struct mtx_thread_data *data = arg;
+    int i;
+
+    p__Mtx_lock(data->mtx);
+    for(i = 0; i < data->loops; i++)
+    {
+        while(data->turn != 1)
+            p__Cnd_wait(data->cnd, data->mtx);
+        data->turn = 0;
+        p__Cnd_signal(data->cnd);
+    }
+    p__Mtx_unlock(data->mtx);
+    return 0;
+}
+
+static int __cdecl cnd_release_thread(void *arg)
+{
+    struct mtx_thread_data *data = arg;
+    xtime xt;
+
+    p__Mtx_lock(data->mtx);
+    data->turn = 1;
+    p_xtime_get(&xt, 1);
+    xt.sec += 5;
+    while(data->turn)
+        p__Cnd_timedwait(data->cnd, data->mtx, &xt);
+    p__Mtx_unlock(data->mtx);
+    return 0;
+}
+
+static void test_mtx(void)
+{
+    struct mtx_thread_data data;
+    _Thrd_t threads[4];
+    LONG counter = 0;
+    _Mtx_t mtx;
+    DWORD start;
+    xtime xt;
+    int r, i;
+
+    r = p__Mtx_init(&mtx, 0x4 /* _Mtx_timed */);
+    ok(!r, "failed to init mtx\n");
+
+    p_xtime_get(&xt, 1);
+    r = p__Mtx_timedlock(mtx, &xt);
+    ok(!r, "_Mtx_timedlock returned %d\n", r);
+    r = p__Mtx_timedlock(mtx, &xt);
+    ok(r == 2, "_Mtx_timedlock returned %d\n", r);
+    r = p__Mtx_trylock(mtx);
+    ok(r == 3, "_Mtx_trylock returned %d\n", r);
+
+    data.mtx = mtx;
+    p__Thrd_create(&threads[0], mtx_timedlock_thread, &data);
+    Sleep(300);
+    p__Mtx_unlock(mtx);
+    p__Thrd_join(threads[0], NULL);
+    p__Mtx_destroy(mtx);
+
+    r = p__Mtx_init(&mtx, 0x4 | 0x100 /* _Mtx_timed | _Mtx_recursive */);
+    ok(!r, "failed to init mtx\n");
+    p_xtime_get(&xt, 1);
+    r = p__Mtx_timedlock(mtx, &xt);
+    ok(!r, "_Mtx_timedlock returned %d\n", r);
+    r = p__Mtx_timedlock(mtx, &xt);
+    ok(!r, "_Mtx_timedlock returned %d\n", r);
+    p__Mtx_unlock(mtx);
+    p__Mtx_unlock(mtx);
+    p__Mtx_destroy(mtx);
+
+    r = p__Mtx_init(&mtx, 0x1 /* _Mtx_plain */);
+    ok(!r, "failed to init mtx\n");
+
+    p__Mtx_lock(mtx);
+    p__Mtx_unlock(mtx);
+    r = p__Mtx_trylock(mtx);
+    ok(!r, "_Mtx_trylock returned %d\n", r);
+    p__Mtx_unlock(mtx);
+
+    data.mtx = mtx;
+    data.counter = &counter;
+    data.loops = 10000;
+    for(i = 0; i < ARRAY_SIZE(threads); i++)
+        p__Thrd_create(&threads[i], mtx_counter_thread, &data);
+    for(i = 0; i < ARRAY_SIZE(threads); i++)
+        p__Thrd_join(threads[i], NULL);
+    ok(counter == i * data.loops, "counter = %ld\n", counter);
+    r = p__Mtx_trylock(mtx);
+    ok(!r, "_Mtx_trylock returned %d\n", r);
+    p__Mtx_unlock(mtx);
+
+    r = p__Cnd_init(&data.cnd);
+    ok(!r, "failed to init cnd\n");
+
+    /* both threads take turns, so every round trip needs a wakeup */
+    data.turn = 0;
+    data.loops = 1000;
+    p__Thrd_create(&threads[0], cnd_pingpong_thread, &data);
+    p__Mtx_lock(mtx);
+    for(i = 0; i < data.loops; i++)
+    {
+        while(data.turn != 0)
+            p__Cnd_wait(data.cnd, mtx);
+        data.turn = 1;
+        p__Cnd_signal(data.cnd);
+    }
+    while(data.turn != 0)
+        p__Cnd_wait(data.cnd, mtx);
+    p__Mtx_unlock(mtx);
+    p__Thrd_join(threads[0], NULL);
+    ok(!data.turn, "turn = %d\n", data.turn);
+    p__Mtx_destroy(mtx);
+
+    /* a mutex released by a condition variable wait wakes up timed lockers */
+    r = p__Mtx_init(&mtx, 0x4 /* _Mtx_timed */);
+    ok(!r, "failed to init mtx\n");
+    data.mtx = mtx;
+    data.turn = 0;
+    p__Thrd_create(&threads[0], cnd_release_thread, &data);
+    while(!data.turn) Sleep(1);
+
+    start = GetTickCount();
+    p_xtime_get(&xt, 1);
+    xt.sec += 5;
+    r = p__Mtx_timedlock(mtx, &xt);
+    ok(!r, "_Mtx_timedlock returned %d\n", r);
+    ok(GetTickCount() - start < 2000, "_Mtx_timedlock took %lu ms\n", GetTickCount() - start);
+    data.turn = 0;
+    p__Cnd_signal(data.cnd);
+    p__Mtx_unlock(mtx);
+    p__Thrd_join(threads[0], NULL);
+
+    p__Cnd_destroy(data.cnd);
+    p__Mtx_destroy(mtx);
+}
+
 static void test_Copy_file(void)
 {
     WCHAR origin_path[MAX_PATH], temp_path[MAX_PATH];
@@ -1664,6 +1847,7 @@ START_TEST(msvcp140)
     test__Syserror_map();
     test_Equivalent();
     test_cnd();
+    test_mtx();
     test_Copy_file();
     FreeLibrary(msvcp);
 }
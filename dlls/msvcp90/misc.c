@@ -705,6 +705,7 @@ unsigned int __cdecl _Random_device(void)
 #define MTX_TRY 0x2
 #define MTX_TIMED 0x4
 #define MTX_RECURSIVE 0x100
+#define MTX_TIMEDOUT 2
 #define MTX_LOCKED 3
 typedef struct
 {
@@ -724,6 +725,24 @@ typedef _Mtx_t *_Mtx_arg_t;
 #define MTX_T_TO_ARG(m)     (&(m))
 #endif
 
+/* Threads blocked in _Mtx_timedlock() sleep on a single condition variable,
+ * neither lock type supports waiting with a timeout. Mutex releases only
+ * wake them up while there are any. */
+static SRWLOCK timed_lock_guard = SRWLOCK_INIT;
+static CONDITION_VARIABLE timed_lock_cv = CONDITION_VARIABLE_INIT;
+static LONG timed_lock_waiters;
+
+static void wake_timed_lockers(void)
+{
+    if(!ReadNoFence(&timed_lock_waiters))
+        return;
+
+    /* waiters check the mutex while holding the guard */
+    AcquireSRWLockExclusive(&timed_lock_guard);
+    ReleaseSRWLockExclusive(&timed_lock_guard);
+    WakeAllConditionVariable(&timed_lock_cv);
+}
+
 void __cdecl _Mtx_init_in_situ(_Mtx_t mtx, int flags)
 {
     if(flags & ~(MTX_PLAIN | MTX_TRY | MTX_TIMED | MTX_RECURSIVE))
@@ -760,15 +779,17 @@ int __cdecl _Mtx_current_owns(_Mtx_arg_t mtx)
 
 int __cdecl _Mtx_lock(_Mtx_arg_t mtx)
 {
-    if(MTX_T_FROM_ARG(mtx)->thread_id != GetCurrentThreadId()) {
-        cs_lock(&MTX_T_FROM_ARG(mtx)->cs);
-        MTX_T_FROM_ARG(mtx)->thread_id = GetCurrentThreadId();
-    }else if(!(MTX_T_FROM_ARG(mtx)->flags & MTX_RECURSIVE)
-            && MTX_T_FROM_ARG(mtx)->flags != MTX_PLAIN) {
+    _Mtx_t m = MTX_T_FROM_ARG(mtx);
+    DWORD tid = GetCurrentThreadId();
+
+    if(m->thread_id != tid) {
+        cs_lock(&m->cs);
+        m->thread_id = tid;
+    }else if(!(m->flags & MTX_RECURSIVE) && m->flags != MTX_PLAIN) {
         return MTX_LOCKED;
     }
 
-    MTX_T_FROM_ARG(mtx)->count++;
+    m->count++;
     return 0;
 }
 
@@ -779,24 +800,63 @@ int __cdecl _Mtx_unlock(_Mtx_arg_t mtx)
 
     MTX_T_FROM_ARG(mtx)->thread_id = -1;
     cs_unlock(&MTX_T_FROM_ARG(mtx)->cs);
+    wake_timed_lockers();
     return 0;
 }
 
 int __cdecl _Mtx_trylock(_Mtx_arg_t mtx)
 {
-    if(MTX_T_FROM_ARG(mtx)->thread_id != GetCurrentThreadId()) {
-        if(!cs_trylock(&MTX_T_FROM_ARG(mtx)->cs))
+    _Mtx_t m = MTX_T_FROM_ARG(mtx);
+    DWORD tid = GetCurrentThreadId();
+
+    if(m->thread_id != tid) {
+        if(!cs_trylock(&m->cs))
             return MTX_LOCKED;
-        MTX_T_FROM_ARG(mtx)->thread_id = GetCurrentThreadId();
-    }else if(!(MTX_T_FROM_ARG(mtx)->flags & MTX_RECURSIVE)
-            && MTX_T_FROM_ARG(mtx)->flags != MTX_PLAIN) {
+        m->thread_id = tid;
+    }else if(!(m->flags & MTX_RECURSIVE) && m->flags != MTX_PLAIN) {
         return MTX_LOCKED;
     }
 
-    MTX_T_FROM_ARG(mtx)->count++;
+    m->count++;
     return 0;
 }
 
+int __cdecl _Mtx_timedlock(_Mtx_arg_t mtx, const xtime *xt)
+{
+    _Mtx_t m = MTX_T_FROM_ARG(mtx);
+    ULONG timeout;
+    int r;
+
+    TRACE("(%p %p)\n", mtx, xt);
+
+    if((r = _Mtx_trylock(mtx)) != MTX_LOCKED)
+        return r;
+    if(m->thread_id == GetCurrentThreadId())
+        return MTX_TIMEDOUT;
+
+    AcquireSRWLockExclusive(&timed_lock_guard);
+    InterlockedIncrement(&timed_lock_waiters);
+    while((r = _Mtx_trylock(mtx)) == MTX_LOCKED) {
+        if(!(timeout = _Xtime_diff_to_millis(xt))) {
+            r = MTX_TIMEDOUT;
+            break;
+        }
+
+        if(!m->count) {
+            /* the owner is just taking the mutex, or giving it up to wait
+             * on a condition variable; the latter doesn't wake us up */
+            ReleaseSRWLockExclusive(&timed_lock_guard);
+            Sleep(0);
+            AcquireSRWLockExclusive(&timed_lock_guard);
+            continue;
+        }
+        SleepConditionVariableSRW(&timed_lock_cv, &timed_lock_guard, timeout, 0);
+    }
+    InterlockedDecrement(&timed_lock_waiters);
+    ReleaseSRWLockExclusive(&timed_lock_guard);
+    return r;
+}
+
 void* __cdecl _Mtx_getconcrtcs(_Mtx_arg_t mtx)
 {
     return &MTX_T_FROM_ARG(mtx)->cs;
@@ -807,6 +867,7 @@ void __cdecl _Mtx_clear_owner(_Mtx_arg_t mtx)
     _Mtx_t m = MTX_T_FROM_ARG(mtx);
     m->thread_id = -1;
     m->count--;
+    wake_timed_lockers();
 }
 
 void __cdecl _Mtx_reset_owner(_Mtx_arg_t mtx)
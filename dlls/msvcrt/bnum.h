@@ -23,6 +23,13 @@
 #define MANT_BITS 53
 
 static const int p10s[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+static const ULONGLONG p5s[] = {
+    1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625,
+    48828125, 244140625, 1220703125, 6103515625, 30517578125, 152587890625,
+    762939453125, 3814697265625, 19073486328125, 95367431640625,
+    476837158203125, 2384185791015625, 11920928955078125, 59604644775390625,
+    298023223876953125, 1490116119384765625, 7450580596923828125
+};
 
 #define LIMB_DIGITS 9           /* each DWORD stores up to 9 digits */
 #define LIMB_MAX 1000000000     /* 10^9 */
@@ -38,6 +45,18 @@ struct bnum {
     DWORD data[1]; /* circular buffer, base 10 number */
 };
 
+/* Returns low 64 bits of a * b, high 64 bits are stored in hi */
+static inline ULONGLONG mul128(ULONGLONG a, ULONGLONG b, ULONGLONG *hi)
+{
+    ULONGLONG ll = (a & 0xffffffff) * (b & 0xffffffff);
+    ULONGLONG lh = (a & 0xffffffff) * (b >> 32);
+    ULONGLONG hl = (a >> 32) * (b & 0xffffffff);
+    ULONGLONG mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+
+    *hi = (a >> 32) * (b >> 32) + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return (mid << 32) | (ll & 0xffffffff);
+}
+
 static inline int bnum_idx(struct bnum *b, int idx)
 {
     return idx & (b->size - 1);
@@ -89,6 +89,7 @@ static char utf8_bom[3] = { 0xef, 0xbb, 0xbf };
 static char utf16_bom[2] = { 0xff, 0xfe };
 
 #define MSVCRT_INTERNAL_BUFSIZ 4096
+#define MSVCRT_TEXT_WRITE_BUFSIZ 0x10000
 
 enum textmode
 {
@@ -2716,6 +2717,30 @@ int CDECL _rmtmp(void)
   return num_removed;
 }
 
+/* returns the number of leading bytes in s that are different from c1 and c2 */
+static inline DWORD text_span(const char *s, DWORD n, char c1, char c2)
+{
+    const size_t ones = ~(size_t)0 / 0xff, highs = ones << 7;
+    const size_t m1 = ones * (unsigned char)c1, m2 = ones * (unsigned char)c2;
+    size_t x;
+    DWORD i;
+
+    for (i = 0; i < n && (ULONG_PTR)(s + i) % sizeof(size_t); i++)
+        if (s[i] == c1 || s[i] == c2) return i;
+
+    /* check a word at a time, a byte equal to c sets the high bit of (x ^ m) - ones */
+    for (; n - i >= sizeof(size_t); i += sizeof(size_t))
+    {
+        x = *(const size_t *)(s + i);
+        if (((x ^ m1) - ones) & ~(x ^ m1) & highs) break;
+        if (((x ^ m2) - ones) & ~(x ^ m2) & highs) break;
+    }
+
+    for (; i < n; i++)
+        if (s[i] == c1 || s[i] == c2) break;
+    return i;
+}
+
 static inline int get_utf8_char_len(char ch)
 {
     if((ch&0xf8) == 0xf0)
@@ -2984,6 +3009,16 @@ static int read_i(int fd, ioinfo *fdinfo, void *buf, unsigned int count)
 
             for (i=0, j=0; i<num_read; i+=1+utf16)
             {
+                if (!utf16)
+                {
+                    DWORD len = text_span(bufstart + i, num_read - i, '\r', 0x1a);
+
+                    if (i != j) memmove(bufstart + j, bufstart + i, len);
+                    i += len;
+                    j += len;
+                    if (i == num_read) break;
+                }
+
                 /* in text mode, a ctrl-z signals EOF */
                 if (bufstart[i]==0x1a && (!utf16 || bufstart[i+1]==0))
                 {
@@ -3568,6 +3603,49 @@ int CDECL _wutime32(const wchar_t* path, struct __utimbuf32 *t)
         return _wutime64( path, NULL );
 }
 
+/* ANSI text mode write to a file, \n is expanded to \r\n */
+static int write_text_ansi(int fd, ioinfo *info, const char *s, unsigned int count)
+{
+    char stack_buf[2048], *lfbuf = NULL;
+    DWORD size = sizeof(stack_buf), num_written, len, i, j;
+
+    if (count >= sizeof(stack_buf) && (lfbuf = malloc(MSVCRT_TEXT_WRITE_BUFSIZ)))
+        size = MSVCRT_TEXT_WRITE_BUFSIZ;
+    else
+        lfbuf = stack_buf;
+
+    for (i = 0; i < count;)
+    {
+        for (j = 0; i < count && j < size-1;)
+        {
+            len = text_span(s + i, min(count - i, size-1 - j), '\n', '\n');
+            memcpy(lfbuf + j, s + i, len);
+            i += len;
+            j += len;
+
+            if (i < count && j < size-1)
+            {
+                lfbuf[j++] = '\r';
+                lfbuf[j++] = s[i++];
+            }
+        }
+
+        if (!WriteFile(info->handle, lfbuf, j, &num_written, NULL) || num_written != j)
+        {
+            TRACE("WriteFile (fd %d, hand %p) failed-last error (%ld)\n", fd,
+                    info->handle, GetLastError());
+            msvcrt_set_errno(GetLastError());
+            if (GetLastError() == ERROR_ACCESS_DENIED)
+                *_errno() = EBADF;
+            if (lfbuf != stack_buf) free(lfbuf);
+            return -1;
+        }
+    }
+
+    if (lfbuf != stack_buf) free(lfbuf);
+    return count;
+}
+
 /*********************************************************************
  *		_write (MSVCRT.@)
  */
@@ -3614,6 +3692,13 @@ int CDECL _write(int fd, const void* buf, unsigned int count)
     }
 
     if (_isatty(fd)) console = VerifyConsoleIoHandle(hand);
+    if (ioinfo_get_textmode(info) == TEXTMODE_ANSI && !console)
+    {
+        num_written = write_text_ansi(fd, info, buf, count);
+        release_ioinfo(info);
+        return num_written;
+    }
+
     for (i = 0; i < count;)
     {
         const char *s = buf;
@@ -3672,15 +3757,6 @@ int CDECL _write(int fd, const void* buf, unsigned int count)
             }
             j = len * 2;
         }
-        else if (ioinfo_get_textmode(info) == TEXTMODE_ANSI)
-        {
-            for (j = 0; i < count && j < sizeof(lfbuf)-1; i++, j++)
-            {
-                if (s[i] == '\n')
-                    lfbuf[j++] = '\r';
-                lfbuf[j] = s[i];
-            }
-        }
         else if (ioinfo_get_textmode(info) == TEXTMODE_UTF16LE || console)
         {
             for (j = 0; i < count && j < sizeof(lfbuf)-3; i++, j++)
@@ -149,6 +149,82 @@ static inline unsigned int log10i(unsigned int x)
     return t - (x < p10s[t]);
 }
 
+/* Converts m * 2^e to bnum using 64-bit arithmetic. The value is truncated
+ * after p decimal digits and a sticky digit is appended if anything was
+ * cut off, which doesn't change the result of rounding at any position
+ * above the sticky digit. Returns FALSE if the digits needed for rounding
+ * don't fit, the generic conversion needs to be used in that case. */
+static inline BOOL bnum_from_double_fast(struct bnum *b, int *e10, ULONGLONG m,
+        int e, int format, int precision)
+{
+    ULONGLONG q, rem, hi, lo, t;
+    DWORD limbs[3];
+    int p, s, digits, round_pos, pad, i;
+
+    if(e >= 0) {
+        if(e > 64 - MANT_BITS) return FALSE;
+        q = m << e;
+        rem = 0;
+        p = 0;
+    } else {
+        /* m * 2^e * 10^p = m * 5^p / 2^(p-e), p is chosen so the quotient fits in 64 bits */
+        p = (64 - MANT_BITS - e) * 77 / 256;
+        if(p >= ARRAY_SIZE(p5s)) p = ARRAY_SIZE(p5s) - 1;
+        if(p > -e) p = -e;
+        s = -e - p;
+        if(s >= 128) return FALSE;
+
+        lo = mul128(m, p5s[p], &hi);
+
+        if(!s) {
+            if(hi) return FALSE;
+            q = lo;
+            rem = 0;
+        } else if(s < 64) {
+            if(hi >> s) return FALSE;
+            q = (hi << (64 - s)) | (lo >> s);
+            rem = lo & (((ULONGLONG)1 << s) - 1);
+        } else {
+            q = s == 64 ? hi : hi >> (s - 64);
+            rem = lo | (s == 64 ? 0 : hi & (((ULONGLONG)1 << (s - 64)) - 1));
+        }
+    }
+    if(!q) return FALSE;
+
+    limbs[0] = q % LIMB_MAX;
+    limbs[1] = q / LIMB_MAX % LIMB_MAX;
+    limbs[2] = q / LIMB_MAX / LIMB_MAX;
+    for(i = 2; !limbs[i]; i--);
+    digits = i * LIMB_DIGITS + log10i(limbs[i]) + 1;
+
+    if(rem) {
+        round_pos = precision;
+        if(format != 'f' && format != 'F') {
+            if(!precision || format=='e' || format=='E') round_pos++;
+            round_pos -= digits - p;
+        }
+        if(round_pos >= p) return FALSE;
+    }
+
+    /* store q * 10 + sticky digit, aligned so the radix point falls on a limb boundary */
+    pad = (LIMB_DIGITS - (p + 1) % LIMB_DIGITS) % LIMB_DIGITS;
+    t = 0;
+    for(i = 0; i < ARRAY_SIZE(limbs); i++) {
+        t += (ULONGLONG)limbs[i] * p10s[pad + 1];
+        b->data[i] = t % LIMB_MAX;
+        t /= LIMB_MAX;
+    }
+    b->data[i] = t;
+    if(rem) b->data[0] += p10s[pad];
+
+    b->b = 0;
+    b->e = ARRAY_SIZE(limbs) + 1;
+    b->size = BNUM_PREC64;
+    while(!b->data[b->e - 1]) b->e--;
+    *e10 = LIMB_DIGITS * (b->e - 2 - (p + 1 + pad) / LIMB_DIGITS);
+    return TRUE;
+}
+
 #endif
 
 static inline int FUNC_NAME(pf_output_wstr)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx,
@@ -600,6 +676,15 @@ static inline void FUNC_NAME(pf_integer_conv)(APICHAR *buf, pf_flags *flags, LON
     }
 }
 
+/* pf_limb_conv: prints len least significant decimal digits of x to buf */
+static inline void FUNC_NAME(pf_limb_conv)(APICHAR *buf, int len, DWORD x)
+{
+    while(len-- > 0) {
+        buf[len] = '0' + x % 10;
+        x /= 10;
+    }
+}
+
 static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx,
         double v, pf_flags *flags, _locale_t locale, BOOL three_digit_exp,
         BOOL standard_rounding)
@@ -621,22 +706,25 @@ static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *pu
     if(v) {
         m = (ULONGLONG)1 << (MANT_BITS - 1);
         m |= (*(ULONGLONG*)&v & (((ULONGLONG)1 << (MANT_BITS - 1)) - 1));
-        b->b = 0;
-        b->e = 2;
-        b->size = BNUM_PREC64;
-        b->data[0] = m % LIMB_MAX;
-        b->data[1] = m / LIMB_MAX;
         e2 -= MANT_BITS;
 
-        while(e2 > 0) {
-            int shift = e2 > 29 ? 29 : e2;
-            if(bnum_lshift(b, shift)) e10 += LIMB_DIGITS;
-            e2 -= shift;
-        }
-        while(e2 < 0) {
-            int shift = -e2 > 9 ? 9 : -e2;
-            if(bnum_rshift(b, shift)) e10 -= LIMB_DIGITS;
-            e2 += shift;
+        if(!bnum_from_double_fast(b, &e10, m, e2, flags->Format, flags->Precision)) {
+            b->b = 0;
+            b->e = 2;
+            b->size = BNUM_PREC64;
+            b->data[0] = m % LIMB_MAX;
+            b->data[1] = m / LIMB_MAX;
+
+            while(e2 > 0) {
+                int shift = e2 > 29 ? 29 : e2;
+                if(bnum_lshift(b, shift)) e10 += LIMB_DIGITS;
+                e2 -= shift;
+            }
+            while(e2 < 0) {
+                int shift = -e2 > 9 ? 9 : -e2;
+                if(bnum_rshift(b, shift)) e10 -= LIMB_DIGITS;
+                e2 += shift;
+            }
         }
     } else {
         b->b = 0;
@@ -855,7 +943,7 @@ static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *pu
                 limb_len = LIMB_DIGITS;
             }
             radix_pos -= f.Precision;
-            FUNC_NAME(pf_integer_conv)(buf, &f, l);
+            FUNC_NAME(pf_limb_conv)(buf, f.Precision, l);
 
             r = pf_puts(puts_ctx, f.Precision, buf);
             if(r < 0) return r;
@@ -896,7 +984,7 @@ static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *pu
                 limb_len = LIMB_DIGITS;
             }
             prec -= f.Precision;
-            FUNC_NAME(pf_integer_conv)(buf, &f, l);
+            FUNC_NAME(pf_limb_conv)(buf, f.Precision, l);
 
             r = pf_puts(puts_ctx, f.Precision, buf);
             if(r < 0) return r;
@@ -942,7 +1030,7 @@ static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *pu
                 limb_len = LIMB_DIGITS;
             }
             prec -= f.Precision;
-            FUNC_NAME(pf_integer_conv)(buf, &f, l);
+            FUNC_NAME(pf_limb_conv)(buf, f.Precision, l);
 
             r = pf_puts(puts_ctx, f.Precision, buf);
             if(r < 0) return r;
@@ -347,6 +347,19 @@ void CDECL _swab(char* src, char* dst, int len)
   }
 }
 
+static inline int bit_len(ULONGLONG x)
+{
+    ULONG idx;
+
+    if(x >> 32) {
+        _BitScanReverse(&idx, x >> 32);
+        return idx + 33;
+    }
+    if(!x) return 0;
+    _BitScanReverse(&idx, x);
+    return idx + 1;
+}
+
 static struct fpnum fpnum(int sign, int exp, ULONGLONG m, enum fpmod mod)
 {
     struct fpnum ret;
@@ -361,6 +374,7 @@ static struct fpnum fpnum(int sign, int exp, ULONGLONG m, enum fpmod mod)
 int fpnum_double(struct fpnum *fp, double *d)
 {
     ULONGLONG bits = 0;
+    int shift;
 
     if (fp->mod == FP_VAL_INFINITY)
     {
@@ -399,21 +413,22 @@ int fpnum_double(struct fpnum *fp, double *d)
     fp->exp += MANT_BITS - 1;
 
     /* normalize mantissa */
-    while(fp->m < (ULONGLONG)1 << (MANT_BITS-1))
+    shift = bit_len(fp->m) - MANT_BITS;
+    if (shift < 0)
     {
-        fp->m <<= 1;
-        fp->exp--;
+        fp->m <<= -shift;
+        fp->exp += shift;
     }
-    while(fp->m >= (ULONGLONG)1 << MANT_BITS)
+    else if (shift > 0)
     {
-        if (fp->m & 1 || fp->mod != FP_ROUND_ZERO)
-        {
-            if (!(fp->m & 1)) fp->mod = FP_ROUND_DOWN;
-            else if(fp->mod == FP_ROUND_ZERO) fp->mod = FP_ROUND_EVEN;
-            else fp->mod = FP_ROUND_UP;
-        }
-        fp->m >>= 1;
-        fp->exp++;
+        if (fp->m & (((ULONGLONG)1 << (shift - 1)) - 1) && fp->mod == FP_ROUND_ZERO)
+            fp->mod = FP_ROUND_DOWN;
+        if (fp->m >> (shift - 1) & 1)
+            fp->mod = fp->mod == FP_ROUND_ZERO ? FP_ROUND_EVEN : FP_ROUND_UP;
+        else if (fp->mod != FP_ROUND_ZERO)
+            fp->mod = FP_ROUND_DOWN;
+        fp->m >>= shift;
+        fp->exp += shift;
     }
     fp->exp += (1 << (EXP_BITS-1)) - 1;
 
@@ -742,6 +757,75 @@ static inline BOOL bnum_to_mant(struct bnum *b, ULONGLONG *m)
     return TRUE;
 }
 
+/* divides 128-bit number stored in 32-bit words, most significant first */
+static inline DWORD div128(DWORD *words, DWORD d)
+{
+    ULONGLONG r = 0;
+    int i;
+
+    for(i=0; i<4; i++) {
+        r = (r << 32) | words[i];
+        words[i] = r / d;
+        r %= d;
+    }
+    return r;
+}
+
+/* Converts m * 10^exp to fpnum using 64-bit arithmetic when exp is small.
+ * The result is exact, the dropped part is only described by rounding mode. */
+static BOOL fpnum_from_decimal(int sign, ULONGLONG m, int exp, struct fpnum *ret)
+{
+    ULONGLONG hi, lo, r, d;
+    DWORD words[4];
+    int bits, lz;
+
+    if(exp >= 0) {
+        if(exp >= ARRAY_SIZE(p5s)) return FALSE;
+
+        /* m * 10^exp = m * 5^exp * 2^exp */
+        lo = mul128(m, p5s[exp], &hi);
+        if(!hi) {
+            *ret = fpnum(sign, exp, lo, FP_ROUND_ZERO);
+            return TRUE;
+        }
+
+        bits = bit_len(hi);
+        r = lo & (((ULONGLONG)1 << bits) - 1);
+        d = (ULONGLONG)1 << (bits - 1);
+        *ret = fpnum(sign, exp + bits, (hi << (64 - bits)) | (lo >> bits),
+                !r ? FP_ROUND_ZERO : r < d ? FP_ROUND_DOWN : r == d ? FP_ROUND_EVEN : FP_ROUND_UP);
+        return TRUE;
+    }
+
+    /* 5^exp needs to be split into two 32-bit divisors */
+    if(-exp > 26) return FALSE;
+
+    /* m * 10^exp = m * 2^(bits+lz) / 5^-exp * 2^(exp-bits-lz), the quotient
+     * has between 62 and 64 significant bits */
+    d = p5s[-exp];
+    bits = bit_len(d) - 1;
+    lz = 64 - bit_len(m);
+    m <<= lz;
+    hi = m >> (64 - bits);
+    lo = m << bits;
+    words[0] = hi >> 32;
+    words[1] = hi;
+    words[2] = lo >> 32;
+    words[3] = lo;
+
+    if(-exp > 13) {
+        r = div128(words, p5s[13]);
+        r += (ULONGLONG)div128(words, p5s[-exp-13]) * p5s[13];
+    } else {
+        r = div128(words, d);
+    }
+    if(words[0] || words[1]) return FALSE;
+
+    *ret = fpnum(sign, exp - bits - lz, ((ULONGLONG)words[2] << 32) | words[3],
+            !r ? FP_ROUND_ZERO : 2*r < d ? FP_ROUND_DOWN : 2*r == d ? FP_ROUND_EVEN : FP_ROUND_UP);
+    return TRUE;
+}
+
 static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(void *ctx),
         void *ctx, pthreadlocinfo locinfo, BOOL ldouble, struct bnum *b)
 {
@@ -751,11 +835,12 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
     const wchar_t *str_match = NULL;
     int matched=0;
 #endif
-    BOOL found_digit = FALSE, found_dp = FALSE, found_sign = FALSE;
-    int e2 = 0, dp=0, sign=1, off, limb_digits = 0, i;
+    BOOL found_digit = FALSE, found_dp = FALSE, found_sign = FALSE, digits_lost = FALSE;
+    int e2 = 0, dp=0, sign=1, off, limb_digits = 0, digits = 0, i;
     enum fpmod round = FP_ROUND_ZERO;
+    ULONGLONG m, digits_m = 0;
+    struct fpnum ret;
     wchar_t nch;
-    ULONGLONG m;
 
     nch = get(ctx);
     if(nch == '-') {
@@ -826,11 +911,17 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
 
         b->data[bnum_idx(b, b->b)] = b->data[bnum_idx(b, b->b)] * 10 + nch - '0';
         limb_digits++;
+        if(digits < 19) digits_m = digits_m * 10 + nch - '0';
+        else if(nch != '0') digits_lost = TRUE;
+        digits++;
         nch = get(ctx);
         dp++;
     }
     while(nch>='0' && nch<='9') {
-        if(nch != '0') b->data[bnum_idx(b, b->b)] |= 1;
+        if(nch != '0') {
+            b->data[bnum_idx(b, b->b)] |= 1;
+            digits_lost = TRUE;
+        }
         nch = get(ctx);
         dp++;
     }
@@ -862,10 +953,16 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
 
         b->data[bnum_idx(b, b->b)] = b->data[bnum_idx(b, b->b)] * 10 + nch - '0';
         limb_digits++;
+        if(digits < 19) digits_m = digits_m * 10 + nch - '0';
+        else if(nch != '0') digits_lost = TRUE;
+        digits++;
         nch = get(ctx);
     }
     while(nch>='0' && nch<='9') {
-        if(nch != '0') b->data[bnum_idx(b, b->b)] |= 1;
+        if(nch != '0') {
+            b->data[bnum_idx(b, b->b)] |= 1;
+            digits_lost = TRUE;
+        }
         nch = get(ctx);
     }
 
@@ -917,6 +1014,14 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
     if(!b->data[bnum_idx(b, b->e-1)])
         return fpnum(sign, 0, 0, 0);
 
+    /* numbers with up to 19 significant digits don't need bnum arithmetic */
+    if(!ldouble && !digits_lost) {
+        if(digits > 19) digits = 19;
+        if(dp >= digits - 26 && dp <= digits + 27 &&
+                fpnum_from_decimal(sign, digits_m, dp - digits, &ret))
+            return ret;
+    }
+
     /* Fill last limb with 0 if needed */
     if(b->b+1 != b->e) {
         for(; limb_digits != LIMB_DIGITS; limb_digits++)
@@ -1400,6 +1400,56 @@ static void test_file_put_get( void )
   free(tempf);
 }
 
+static void test_text_write_read_large(void)
+{
+    static const char line[] = "0123456789 abcdefghijklmnopqrstuvwxyz";
+    const unsigned int size = 1024 * 1024;
+    unsigned int i, lines = 0;
+    char *buf, *text, *tempf;
+    DWORD start;
+    int fd, ret;
+
+    buf = malloc(size);
+    text = malloc(size * 2);
+    for (i = 0; i < size; i++)
+    {
+        buf[i] = line[i % (sizeof(line) - 1)];
+        if (i % 97 == 96)
+        {
+            buf[i] = '\n';
+            lines++;
+        }
+    }
+
+    tempf = _tempnam(".", "wne");
+    fd = _open(tempf, _O_CREAT | _O_TRUNC | _O_TEXT | _O_RDWR, _S_IREAD | _S_IWRITE);
+    ok(fd != -1, "Can't open '%s': %d\n", tempf, errno);
+    start = GetTickCount();
+    ret = _write(fd, buf, size);
+    trace("text mode _write of %u bytes took %lu ms\n", size, GetTickCount() - start);
+    ok(ret == size, "_write returned %d\n", ret);
+    _close(fd);
+
+    fd = _open(tempf, _O_RDONLY | _O_BINARY);
+    ret = _read(fd, text, size * 2);
+    ok(ret == size + lines, "_read returned %d, expected %u\n", ret, size + lines);
+    ok(!memcmp(text, buf, 96) && !memcmp(text + 96, "\r\n", 2), "unexpected data\n");
+    _close(fd);
+
+    fd = _open(tempf, _O_RDONLY | _O_TEXT);
+    start = GetTickCount();
+    ret = _read(fd, text, size * 2);
+    trace("text mode _read of %u bytes took %lu ms\n", size + lines, GetTickCount() - start);
+    ok(ret == size, "_read returned %d\n", ret);
+    ok(!memcmp(text, buf, size), "unexpected data\n");
+    _close(fd);
+
+    unlink(tempf);
+    free(tempf);
+    free(text);
+    free(buf);
+}
+
 static void test_file_write_read( void )
 {
   char* tempf;
@@ -3085,6 +3135,7 @@ START_TEST(file)
     test_file_inherit(arg_v[0]);
     test_invalid_stdin(arg_v[0]);
     test_file_write_read();
+    test_text_write_read_large();
     test_chsize();
     test_stat();
     test_unlink();
@@ -253,6 +253,17 @@ static void test_sprintf( void )
         { "%.0f", "2", 0, DOUBLE_ARG, 0, 0, 1.5 },
         { "%.30f", "0.333333333333333310000000000000", 0, TODO_FLAG | DOUBLE_ARG, 0, 0, 1.0/3.0 },
         { "%.30lf", "1.414213562373095100000000000000", 0, TODO_FLAG | DOUBLE_ARG, 0, 0, sqrt(2) },
+        { "%.2f", "2.67", 0, DOUBLE_ARG, 0, 0, 2.675 },
+        { "%.1f", "0.3", 0, DOUBLE_ARG, 0, 0, 0.25 },
+        { "%.15f", "0.100000000000000", 0, DOUBLE_ARG, 0, 0, 0.1 },
+        { "%.17g", "0.10000000000000001", 0, DOUBLE_ARG, 0, 0, 0.1 },
+        { "%f", "123456.789000", 0, DOUBLE_ARG, 0, 0, 123456.789 },
+        { "%f", "1000000000000000.000000", 0, DOUBLE_ARG, 0, 0, 1e15 },
+        { "%.3e", "1.235e+004", 0, DOUBLE_ARG, 0, 0, 12345.6789 },
+        { "%e", "1.000000e-007", 0, DOUBLE_ARG, 0, 0, 1e-7 },
+        { "%g", "0.0001234", 0, DOUBLE_ARG, 0, 0, 0.0001234 },
+        { "%.10g", "1234567.891", 0, DOUBLE_ARG, 0, 0, 1234567.891 },
+        { "%g", "1e+016", 0, DOUBLE_ARG, 0, 0, 1e16 },
     };
 
     char buffer[100];
@@ -410,6 +421,40 @@ static void test_sprintf( void )
     ok(!strcmp(buffer, " 7"), "failed: \"%s\"\n", buffer);
 }
 
+static void test_sprintf_round_trip( void )
+{
+    char buffer[64];
+    DWORD start, elapsed;
+    double v, d;
+    unsigned int i, seed = 1;
+    int r;
+
+    start = GetTickCount();
+    for (i = 0; i < 100000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        switch (i % 3)
+        {
+        case 0: v = (seed >> 8) / 1000.0; break;
+        case 1: v = (seed >> 8) * 1e-12; break;
+        default: v = (double)(seed >> 8) * (seed & 0xff) * 1e6; break;
+        }
+
+        r = p_sprintf(buffer, "%.17g", v);
+        d = strtod(buffer, NULL);
+        if (r != strlen(buffer) || d != v)
+        {
+            ok(0, "r = %d, %s doesn't round trip\n", r, buffer);
+            break;
+        }
+
+        p_sprintf(buffer, "%f", v);
+        p_sprintf(buffer, "%e", v);
+    }
+    elapsed = GetTickCount() - start;
+    trace("formatted %u floating point numbers in %lu ms\n", i * 3, elapsed);
+}
+
 static void test_swprintf( void )
 {
     wchar_t buffer[100];
@@ -1103,6 +1148,7 @@ START_TEST(printf)
     init();
 
     test_sprintf();
+    test_sprintf_round_trip();
     test_swprintf();
     test_snprintf();
     test_fprintf();
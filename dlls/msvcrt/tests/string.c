@@ -2100,6 +2100,11 @@ static void test__strtod(void)
         { ".00", 3, 0 },
         { "-0.", 3, 0 },
         { "0e13", 4, 0 },
+        { "123.456e-5", 10, 123.456e-5 },
+        { "0.000001", 8, 0.000001 },
+        { "1234567890123456789", 19, 1234567890123456789.0 },
+        { "-98765.4321", 11, -98765.4321 },
+        { "3.14159265358979323846", 22, 3.14159265358979323846 },
     };
     const char overflow[] = "1d9999999999999999999";
 
@@ -2164,6 +2169,37 @@ static void test__strtod(void)
     ok(errno == ERANGE, "errno = %x\n", errno);
 }
 
+static void test_strtod_throughput(void)
+{
+    static const char *numbers[] =
+    {
+        "0", "1", "-1", "0.5", "12.25", "-273.15", "3.14159", "2.718281828459045",
+        "100000", "1e-3", "6.02214076e23", "1.602176634e-19", "299792458", "0.1",
+        "42.000001", "-0.0001234", "1234567.891", "9.81", "65535", "0.333333333333",
+    };
+    DWORD start, elapsed;
+    unsigned int i, j;
+    char *end;
+    double d, sum = 0;
+
+    start = GetTickCount();
+    for (i = 0; i < 10000; i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(numbers); j++)
+        {
+            d = strtod(numbers[j], &end);
+            if (*end)
+            {
+                ok(0, "%s parsed up to %d\n", numbers[j], (int)(end - numbers[j]));
+                return;
+            }
+            sum += d;
+        }
+    }
+    elapsed = GetTickCount() - start;
+    trace("parsed %u numbers in %lu ms (%g)\n", i * j, elapsed, sum);
+}
+
 static void test_mbstowcs(void)
 {
     static const wchar_t wSimple[] = L"text";
@@ -4810,6 +4846,7 @@ START_TEST(string)
     test_strnlen();
     test__strtoi64();
     test__strtod();
+    test_strtod_throughput();
     test_mbstowcs();
     test__wcstombs_s_l();
     test_gcvt();
@@ -26,6 +26,7 @@
 #include "netiodef.h"
 #include "wine/nsi.h"
 #include "wine/heap.h"
+#include "wine/list.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(nsi);
@@ -33,6 +34,36 @@ WINE_DEFAULT_DEBUG_CHANNEL(nsi);
 static HANDLE nsi_device = INVALID_HANDLE_VALUE;
 static HANDLE nsi_device_async = INVALID_HANDLE_VALUE;
 
+/* Complete enumerations of tables that only change through notifications
+ * reported by nsiproxy; reused while the shared generation is unchanged. */
+struct table_snapshot
+{
+    struct list entry;
+    NPI_MODULEID module;
+    UINT table;
+    UINT first_arg;
+    UINT second_arg;
+    UINT sizes[4];
+    LONG generation;
+    UINT count;
+    BYTE data[1];
+};
+
+#define MAX_TABLE_SNAPSHOTS 16
+
+static struct list table_snapshots = LIST_INIT( table_snapshots );
+static unsigned int table_snapshot_count;
+static const struct nsiproxy_generation *shared_generation;
+
+static CRITICAL_SECTION snapshot_cs;
+static CRITICAL_SECTION_DEBUG snapshot_cs_debug =
+{
+    0, 0, &snapshot_cs,
+    { &snapshot_cs_debug.ProcessLocksList, &snapshot_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": snapshot_cs") }
+};
+static CRITICAL_SECTION snapshot_cs = { &snapshot_cs_debug, -1, 0, 0, 0, 0 };
+
 BOOL WINAPI DllMain(HINSTANCE hinst, DWORD reason, void *reserved)
 {
     switch (reason)
@@ -43,6 +74,14 @@ BOOL WINAPI DllMain(HINSTANCE hinst, DWORD reason, void *reserved)
         case DLL_PROCESS_DETACH:
             if (nsi_device != INVALID_HANDLE_VALUE) CloseHandle( nsi_device );
             if (nsi_device_async != INVALID_HANDLE_VALUE) CloseHandle( nsi_device_async );
+            if (reserved) break;
+            while (!list_empty( &table_snapshots ))
+            {
+                struct table_snapshot *snapshot = LIST_ENTRY( list_head( &table_snapshots ), struct table_snapshot, entry );
+                list_remove( &snapshot->entry );
+                free( snapshot );
+            }
+            if (shared_generation) UnmapViewOfFile( shared_generation );
             break;
     }
     return TRUE;
@@ -64,6 +103,132 @@ static inline HANDLE get_nsi_device( BOOL async )
     return *cached_device;
 }
 
+static const struct nsiproxy_generation *get_shared_generation( void )
+{
+    UNICODE_STRING name = RTL_CONSTANT_STRING( NSIPROXY_WINE_GENERATION_NAME );
+    OBJECT_ATTRIBUTES attr;
+    SIZE_T size = 0;
+    HANDLE section;
+    void *ptr = NULL;
+
+    if (shared_generation) return shared_generation;
+
+    InitializeObjectAttributes( &attr, &name, 0, NULL, NULL );
+    if (NtOpenSection( &section, SECTION_MAP_READ, &attr )) return NULL;
+    if (!NtMapViewOfSection( section, NtCurrentProcess(), &ptr, 0, 0, NULL, &size, ViewShare, 0, PAGE_READONLY )
+        && InterlockedCompareExchangePointer( (void **)&shared_generation, ptr, NULL ))
+        UnmapViewOfFile( ptr );
+    NtClose( section );
+    return shared_generation;
+}
+
+/* Whether the given data of a table only changes along with a notification. */
+static BOOL is_table_cacheable( const struct nsi_enumerate_all_ex *params )
+{
+    if (NmrIsEqualNpiModuleId( params->module, &NPI_MS_NDIS_MODULEID ))
+        return params->table == NSI_NDIS_IFINFO_TABLE && !params->dynamic_size; /* dynamic data holds counters */
+    if (NmrIsEqualNpiModuleId( params->module, &NPI_MS_IPV4_MODULEID ) ||
+        NmrIsEqualNpiModuleId( params->module, &NPI_MS_IPV6_MODULEID ))
+        return params->table == NSI_IP_UNICAST_TABLE || params->table == NSI_IP_FORWARD_TABLE;
+    return FALSE;
+}
+
+static BOOL get_current_generation( LONG *generation )
+{
+    const struct nsiproxy_generation *shared = get_shared_generation();
+
+    if (!shared || !ReadAcquire( &shared->monitoring )) return FALSE;
+    *generation = ReadAcquire( &shared->generation );
+    return TRUE;
+}
+
+static struct table_snapshot *find_snapshot( const struct nsi_enumerate_all_ex *params, LONG generation )
+{
+    struct table_snapshot *snapshot, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( snapshot, next, &table_snapshots, struct table_snapshot, entry )
+    {
+        if (snapshot->generation != generation)
+        {
+            list_remove( &snapshot->entry );
+            table_snapshot_count--;
+            free( snapshot );
+            continue;
+        }
+        if (NmrIsEqualNpiModuleId( &snapshot->module, params->module ) && snapshot->table == params->table &&
+            snapshot->first_arg == params->first_arg && snapshot->second_arg == params->second_arg &&
+            snapshot->sizes[0] == params->key_size && snapshot->sizes[1] == params->rw_size &&
+            snapshot->sizes[2] == params->dynamic_size && snapshot->sizes[3] == params->static_size)
+        {
+            list_remove( &snapshot->entry );
+            list_add_head( &table_snapshots, &snapshot->entry );
+            return snapshot;
+        }
+    }
+    return NULL;
+}
+
+static DWORD copy_snapshot( const struct table_snapshot *snapshot, struct nsi_enumerate_all_ex *params )
+{
+    void *data[4] = { params->key_data, params->rw_data, params->dynamic_data, params->static_data };
+    BOOL want_data = params->key_size || params->rw_size || params->dynamic_size || params->static_size;
+    UINT count = snapshot->count;
+    const BYTE *ptr = snapshot->data;
+    DWORD err = ERROR_SUCCESS;
+    int i;
+
+    if (want_data && count > params->count)
+    {
+        count = params->count;
+        err = ERROR_MORE_DATA;
+    }
+    else params->count = count;
+
+    for (i = 0; i < ARRAY_SIZE(data); i++)
+    {
+        if (snapshot->sizes[i]) memcpy( data[i], ptr, snapshot->sizes[i] * count );
+        ptr += snapshot->sizes[i] * snapshot->count;
+    }
+    return err;
+}
+
+static void add_snapshot( const struct nsi_enumerate_all_ex *params, LONG generation )
+{
+    const void *data[4] = { params->key_data, params->rw_data, params->dynamic_data, params->static_data };
+    UINT sizes[4] = { params->key_size, params->rw_size, params->dynamic_size, params->static_size };
+    BOOL want_data = params->key_size || params->rw_size || params->dynamic_size || params->static_size;
+    UINT count = want_data ? params->count : 0;
+    struct table_snapshot *snapshot;
+    SIZE_T size = 0;
+    BYTE *ptr;
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(sizes); i++) size += (SIZE_T)sizes[i] * count;
+    if (!(snapshot = malloc( FIELD_OFFSET( struct table_snapshot, data[size] ) ))) return;
+
+    snapshot->module = *params->module;
+    snapshot->table = params->table;
+    snapshot->first_arg = params->first_arg;
+    snapshot->second_arg = params->second_arg;
+    memcpy( snapshot->sizes, sizes, sizeof(sizes) );
+    snapshot->generation = generation;
+    snapshot->count = params->count;
+    for (i = 0, ptr = snapshot->data; i < ARRAY_SIZE(sizes); i++)
+    {
+        if (sizes[i]) memcpy( ptr, data[i], sizes[i] * count );
+        ptr += sizes[i] * count;
+    }
+
+    if (table_snapshot_count == MAX_TABLE_SNAPSHOTS)
+    {
+        struct table_snapshot *oldest = LIST_ENTRY( list_tail( &table_snapshots ), struct table_snapshot, entry );
+        list_remove( &oldest->entry );
+        free( oldest );
+    }
+    else table_snapshot_count++;
+    list_add_head( &table_snapshots, &snapshot->entry );
+}
+
 DWORD WINAPI NsiAllocateAndGetTable( DWORD unk, const NPI_MODULEID *module, DWORD table, void **key_data, DWORD key_size,
                                      void **rw_data, DWORD rw_size, void **dynamic_data, DWORD dynamic_size,
                                      void **static_data, DWORD static_size, DWORD *count, DWORD unk2 )
@@ -167,10 +332,27 @@ DWORD WINAPI NsiEnumerateObjectsAllParametersEx( struct nsi_enumerate_all_ex *pa
     DWORD out_size, received, err = ERROR_SUCCESS;
     HANDLE device = get_nsi_device( FALSE );
     struct nsiproxy_enumerate_all in;
+    struct table_snapshot *snapshot;
+    BOOL cacheable = FALSE;
+    LONG generation;
     BYTE *out, *ptr;
 
     if (device == INVALID_HANDLE_VALUE) return GetLastError();
 
+    if (is_table_cacheable( params ) && get_current_generation( &generation ))
+    {
+        cacheable = TRUE;
+        EnterCriticalSection( &snapshot_cs );
+        if ((snapshot = find_snapshot( params, generation )))
+        {
+            TRACE( "using snapshot %p, generation %ld, count %u.\n", snapshot, generation, snapshot->count );
+            err = copy_snapshot( snapshot, params );
+            LeaveCriticalSection( &snapshot_cs );
+            return err;
+        }
+        LeaveCriticalSection( &snapshot_cs );
+    }
+
     out_size = sizeof(DWORD) +
         (params->key_size + params->rw_size + params->dynamic_size + params->static_size) * params->count;
 
@@ -202,6 +384,13 @@ DWORD WINAPI NsiEnumerateObjectsAllParametersEx( struct nsi_enumerate_all_ex *pa
         if (params->static_size) memcpy( params->static_data, ptr, params->static_size * params->count );
     }
 
+    if (cacheable && err == ERROR_SUCCESS)
+    {
+        EnterCriticalSection( &snapshot_cs );
+        add_snapshot( params, generation );
+        LeaveCriticalSection( &snapshot_cs );
+    }
+
     free( out );
 
     return err;
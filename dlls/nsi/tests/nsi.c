@@ -1086,9 +1086,76 @@ void test_change_notifications(void)
     ok( !bret && GetLastError() == ERROR_OPERATION_ABORTED, "got bret %d, err %lu.\n", bret, GetLastError() );
 }
 
+static void test_repeated_enumeration( void )
+{
+    NET_LUID *luid_tbl, *enum_luid_tbl;
+    struct nsi_ndis_ifinfo_static *stat_tbl, *enum_stat_tbl;
+    DWORD err, count, enum_count, i;
+
+    err = NsiAllocateAndGetTable( 1, &NPI_MS_NDIS_MODULEID, NSI_NDIS_IFINFO_TABLE, (void **)&luid_tbl, sizeof(*luid_tbl),
+                                  NULL, 0, NULL, 0, (void **)&stat_tbl, sizeof(*stat_tbl), &count, 0 );
+    ok( !err, "got %ld\n", err );
+    if (err) return;
+
+    enum_luid_tbl = malloc( (count + 1) * sizeof(*enum_luid_tbl) );
+    enum_stat_tbl = malloc( (count + 1) * sizeof(*enum_stat_tbl) );
+
+    /* repeated enumerations of unchanged tables return the same data */
+    for (i = 0; i < 3; i++)
+    {
+        enum_count = count + 1;
+        memset( enum_luid_tbl, 0xcc, (count + 1) * sizeof(*enum_luid_tbl) );
+        memset( enum_stat_tbl, 0xcc, (count + 1) * sizeof(*enum_stat_tbl) );
+        err = NsiEnumerateObjectsAllParameters( 1, 0, &NPI_MS_NDIS_MODULEID, NSI_NDIS_IFINFO_TABLE,
+                                                enum_luid_tbl, sizeof(*enum_luid_tbl), NULL, 0,
+                                                NULL, 0, enum_stat_tbl, sizeof(*enum_stat_tbl), &enum_count );
+        ok( !err, "got %ld\n", err );
+        ok( enum_count == count, "got %lu, expected %lu\n", enum_count, count );
+        if (err || enum_count != count) break;
+        ok( !memcmp( enum_luid_tbl, luid_tbl, count * sizeof(*luid_tbl) ), "%lu: luids mismatch\n", i );
+        ok( !memcmp( enum_stat_tbl, stat_tbl, count * sizeof(*stat_tbl) ), "%lu: static data mismatch\n", i );
+        ok( enum_luid_tbl[count].Value == 0xcccccccccccccccc, "%lu: overflow\n", i );
+    }
+
+    /* a different set of requested data isn't served from the previous enumeration */
+    enum_count = count + 1;
+    memset( enum_luid_tbl, 0xcc, (count + 1) * sizeof(*enum_luid_tbl) );
+    err = NsiEnumerateObjectsAllParameters( 1, 0, &NPI_MS_NDIS_MODULEID, NSI_NDIS_IFINFO_TABLE,
+                                            enum_luid_tbl, sizeof(*enum_luid_tbl), NULL, 0,
+                                            NULL, 0, NULL, 0, &enum_count );
+    ok( !err, "got %ld\n", err );
+    ok( enum_count == count, "got %lu, expected %lu\n", enum_count, count );
+    ok( !memcmp( enum_luid_tbl, luid_tbl, count * sizeof(*luid_tbl) ), "luids mismatch\n" );
+    ok( enum_luid_tbl[count].Value == 0xcccccccccccccccc, "overflow\n" );
+
+    enum_count = 0;
+    err = NsiEnumerateObjectsAllParameters( 1, 0, &NPI_MS_NDIS_MODULEID, NSI_NDIS_IFINFO_TABLE,
+                                            NULL, 0, NULL, 0, NULL, 0, NULL, 0, &enum_count );
+    ok( !err, "got %ld\n", err );
+    ok( enum_count == count, "got %lu, expected %lu\n", enum_count, count );
+
+    if (count > 0)
+    {
+        enum_count = count - 1;
+        memset( enum_luid_tbl, 0xcc, (count + 1) * sizeof(*enum_luid_tbl) );
+        err = NsiEnumerateObjectsAllParameters( 1, 0, &NPI_MS_NDIS_MODULEID, NSI_NDIS_IFINFO_TABLE,
+                                                enum_luid_tbl, sizeof(*enum_luid_tbl), NULL, 0,
+                                                NULL, 0, enum_stat_tbl, sizeof(*enum_stat_tbl), &enum_count );
+        ok( err == ERROR_MORE_DATA, "got %ld\n", err );
+        ok( enum_count == count - 1, "mismatch\n" );
+        ok( !memcmp( enum_luid_tbl, luid_tbl, enum_count * sizeof(*luid_tbl) ), "luids mismatch\n" );
+        ok( enum_luid_tbl[enum_count].Value == 0xcccccccccccccccc, "overflow\n" );
+    }
+
+    free( enum_luid_tbl );
+    free( enum_stat_tbl );
+    NsiFreeTable( luid_tbl, NULL, NULL, stat_tbl );
+}
+
 START_TEST( nsi )
 {
     test_nsi_api();
+    test_repeated_enumeration();
 
     test_ndis_ifinfo();
     test_ndis_index_luid();
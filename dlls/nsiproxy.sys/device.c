@@ -38,6 +38,7 @@
 WINE_DEFAULT_DEBUG_CHANNEL(nsi);
 
 static HANDLE request_event;
+static struct nsiproxy_generation *generation;
 
 #define DECLARE_CRITICAL_SECTION(cs)                                    \
     static CRITICAL_SECTION cs;                                         \
@@ -72,6 +73,7 @@ enum unix_calls
     nsi_get_all_parameters_ex,
     nsi_get_parameter_ex,
     nsi_get_notification,
+    nsi_init_notifications,
 };
 
 static NTSTATUS nsiproxy_enumerate_all( IRP *irp )
@@ -488,6 +490,8 @@ static DWORD WINAPI notification_thread_proc( void *arg )
 
     while (!(status = nsiproxy_call( nsi_get_notification, &params )))
     {
+        if (generation) InterlockedIncrement( &generation->generation );
+
         EnterCriticalSection( &nsiproxy_cs );
         for (entry = notification_queue.Flink; entry != &notification_queue; entry = next)
         {
@@ -515,9 +519,41 @@ static DWORD WINAPI notification_thread_proc( void *arg )
     }
 
     WARN( "nsi_get_notification failed, status %#lx.\n", status );
+    if (generation) InterlockedExchange( &generation->monitoring, 0 );
     return 0;
 }
 
+/* publish the change counter once changes are monitored, so that clients
+ * never reuse data which may have changed unnoticed */
+static void create_generation_section(void)
+{
+    UNICODE_STRING name = RTL_CONSTANT_STRING( NSIPROXY_WINE_GENERATION_NAME );
+    OBJECT_ATTRIBUTES attr;
+    LARGE_INTEGER size;
+    SIZE_T view_size = 0;
+    HANDLE section;
+    void *ptr = NULL;
+    NTSTATUS status;
+
+    InitializeObjectAttributes( &attr, &name, 0, NULL, NULL );
+    size.QuadPart = sizeof(*generation);
+    if ((status = NtCreateSection( &section, SECTION_ALL_ACCESS, &attr, &size, PAGE_READWRITE, SEC_COMMIT, NULL )))
+    {
+        WARN( "failed to create generation section, status %#lx.\n", status );
+        return;
+    }
+    if ((status = NtMapViewOfSection( section, NtCurrentProcess(), &ptr, 0, 0, NULL, &view_size,
+                                      ViewShare, 0, PAGE_READWRITE )))
+    {
+        WARN( "failed to map generation section, status %#lx.\n", status );
+        NtClose( section );
+        return;
+    }
+    /* the section handle is kept open for the lifetime of the driver */
+    generation = ptr;
+    generation->monitoring = 1;
+}
+
 NTSTATUS WINAPI DriverEntry( DRIVER_OBJECT *driver, UNICODE_STRING *path )
 {
     NTSTATUS status;
@@ -535,6 +571,7 @@ NTSTATUS WINAPI DriverEntry( DRIVER_OBJECT *driver, UNICODE_STRING *path )
     request_event = CreateEventW( NULL, FALSE, FALSE, NULL );
     thread = CreateThread( NULL, 0, request_thread_proc, NULL, 0, NULL );
     CloseHandle( thread );
+    if (!nsiproxy_call( nsi_init_notifications, NULL )) create_generation_section();
     thread = CreateThread( NULL, 0, notification_thread_proc, NULL, 0, NULL );
     CloseHandle( thread );
 
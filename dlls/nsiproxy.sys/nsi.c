@@ -182,35 +182,41 @@ static NTSTATUS add_notification( const NPI_MODULEID *module, UINT32 table )
     return STATUS_SUCCESS;
 }
 
+static int netlink_fd = -1;
+
+static NTSTATUS open_netlink(void)
+{
+    struct sockaddr_nl addr;
+
+    if (netlink_fd != -1) return STATUS_SUCCESS;
+
+    if ((netlink_fd = socket( PF_NETLINK, SOCK_RAW, NETLINK_ROUTE )) == -1)
+    {
+        ERR( "netlink socket creation failed, errno %d.\n", errno );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    memset( &addr, 0, sizeof(addr) );
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR | RTMGRP_LINK | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+    if (bind( netlink_fd, (struct sockaddr *)&addr, sizeof(addr) ) == -1)
+    {
+        close( netlink_fd );
+        netlink_fd = -1;
+        ERR( "bind failed, errno %d.\n", errno );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    return STATUS_SUCCESS;
+}
+
 static NTSTATUS poll_netlink(void)
 {
-    static int netlink_fd = -1;
-    char buffer[PIPE_BUF];
+    char buffer[16384];
     struct nlmsghdr *nlh;
     NTSTATUS status;
     int len;
 
-    if (netlink_fd == -1)
-    {
-        struct sockaddr_nl addr;
-
-        if ((netlink_fd = socket( PF_NETLINK, SOCK_RAW, NETLINK_ROUTE )) == -1)
-        {
-            ERR( "netlink socket creation failed, errno %d.\n", errno );
-            return STATUS_NOT_IMPLEMENTED;
-        }
-
-        memset( &addr, 0, sizeof(addr) );
-        addr.nl_family = AF_NETLINK;
-        addr.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
-        if (bind( netlink_fd, (struct sockaddr *)&addr, sizeof(addr) ) == -1)
-        {
-            close( netlink_fd );
-            netlink_fd = -1;
-            ERR( "bind failed, errno %d.\n", errno );
-            return STATUS_NOT_IMPLEMENTED;
-        }
-    }
+    if ((status = open_netlink())) return status;
 
     while (1)
     {
@@ -238,12 +244,31 @@ static NTSTATUS poll_netlink(void)
                 }
                 if ((status = add_notification( module, NSI_IP_UNICAST_TABLE))) return status;
             }
+            else if (nlh->nlmsg_type == RTM_NEWLINK || nlh->nlmsg_type == RTM_DELLINK)
+            {
+                if ((status = add_notification( &NPI_MS_NDIS_MODULEID, NSI_NDIS_IFINFO_TABLE ))) return status;
+            }
+            else if (nlh->nlmsg_type == RTM_NEWROUTE || nlh->nlmsg_type == RTM_DELROUTE)
+            {
+                struct rtmsg *rtmsg = (struct rtmsg *)(nlh + 1);
+                const NPI_MODULEID *module;
+
+                if (rtmsg->rtm_family == AF_INET)       module = &NPI_MS_IPV4_MODULEID;
+                else if (rtmsg->rtm_family == AF_INET6) module = &NPI_MS_IPV6_MODULEID;
+                else continue;
+                if ((status = add_notification( module, NSI_IP_FORWARD_TABLE ))) return status;
+            }
         }
         if (queued_notification_count) break;
     }
     return STATUS_SUCCESS;
 }
 
+static NTSTATUS unix_nsi_init_notifications( void *args )
+{
+    return open_netlink();
+}
+
 static NTSTATUS unix_nsi_get_notification( void *args )
 {
     struct nsi_get_notification_params *params = (struct nsi_get_notification_params *)args;
@@ -258,6 +283,11 @@ static NTSTATUS unix_nsi_get_notification( void *args )
     return STATUS_SUCCESS;
 }
 #else
+static NTSTATUS unix_nsi_init_notifications( void *args )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
 static NTSTATUS unix_nsi_get_notification( void *args )
 {
     return STATUS_NOT_IMPLEMENTED;
@@ -274,4 +304,5 @@ const unixlib_entry_t __wine_unix_call_funcs[] =
     unix_nsi_get_all_parameters_ex,
     unix_nsi_get_parameter_ex,
     unix_nsi_get_notification,
+    unix_nsi_init_notifications,
 };
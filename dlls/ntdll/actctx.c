@@ -34,6 +34,7 @@
 #include "ntdll_misc.h"
 #include "wine/exception.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(actctx);
 
@@ -924,6 +925,154 @@ static void free_entity_array(struct entity_array *array)
     RtlFreeHeap( GetProcessHeap(), 0, array->base );
 }
 
+static WCHAR *copy_string( const WCHAR *str, BOOL *ok )
+{
+    WCHAR *ret;
+
+    if (!str) return NULL;
+    if (!(ret = strdupW( str ))) *ok = FALSE;
+    return ret;
+}
+
+static BOOL copy_assembly_identity( struct assembly_identity *dst, const struct assembly_identity *src )
+{
+    BOOL ok = TRUE;
+
+    *dst = *src;
+    dst->name       = copy_string( src->name, &ok );
+    dst->arch       = copy_string( src->arch, &ok );
+    dst->public_key = copy_string( src->public_key, &ok );
+    dst->language   = copy_string( src->language, &ok );
+    dst->type       = copy_string( src->type, &ok );
+    return ok;
+}
+
+static BOOL copy_entity_array( struct entity_array *dst, const struct entity_array *src )
+{
+    unsigned int i, j;
+    BOOL ok = TRUE;
+
+    if (!src->num) return TRUE;
+    if (!(dst->base = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, src->num * sizeof(*dst->base) )))
+        return FALSE;
+    dst->allocated = src->num;
+
+    for (i = 0; i < src->num && ok; i++)
+    {
+        const struct entity *from = &src->base[i];
+        struct entity *to = &dst->base[dst->num++];
+
+        to->kind = from->kind;
+        switch (from->kind)
+        {
+        case ACTIVATION_CONTEXT_SECTION_COM_SERVER_REDIRECTION:
+            to->u.comclass.model               = from->u.comclass.model;
+            to->u.comclass.miscstatus          = from->u.comclass.miscstatus;
+            to->u.comclass.miscstatuscontent   = from->u.comclass.miscstatuscontent;
+            to->u.comclass.miscstatusthumbnail = from->u.comclass.miscstatusthumbnail;
+            to->u.comclass.miscstatusicon      = from->u.comclass.miscstatusicon;
+            to->u.comclass.miscstatusdocprint  = from->u.comclass.miscstatusdocprint;
+            to->u.comclass.clsid   = copy_string( from->u.comclass.clsid, &ok );
+            to->u.comclass.tlbid   = copy_string( from->u.comclass.tlbid, &ok );
+            to->u.comclass.progid  = copy_string( from->u.comclass.progid, &ok );
+            to->u.comclass.name    = copy_string( from->u.comclass.name, &ok );
+            to->u.comclass.version = copy_string( from->u.comclass.version, &ok );
+            if (!from->u.comclass.progids.num) break;
+            if (!(to->u.comclass.progids.progids = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                    from->u.comclass.progids.num * sizeof(WCHAR *) )))
+            {
+                ok = FALSE;
+                break;
+            }
+            to->u.comclass.progids.allocated = from->u.comclass.progids.num;
+            for (j = 0; j < from->u.comclass.progids.num; j++)
+                to->u.comclass.progids.progids[to->u.comclass.progids.num++] =
+                    copy_string( from->u.comclass.progids.progids[j], &ok );
+            break;
+        case ACTIVATION_CONTEXT_SECTION_COM_INTERFACE_REDIRECTION:
+            to->u.ifaceps.mask       = from->u.ifaceps.mask;
+            to->u.ifaceps.nummethods = from->u.ifaceps.nummethods;
+            to->u.ifaceps.iid  = copy_string( from->u.ifaceps.iid, &ok );
+            to->u.ifaceps.base = copy_string( from->u.ifaceps.base, &ok );
+            to->u.ifaceps.tlib = copy_string( from->u.ifaceps.tlib, &ok );
+            to->u.ifaceps.name = copy_string( from->u.ifaceps.name, &ok );
+            to->u.ifaceps.ps32 = copy_string( from->u.ifaceps.ps32, &ok );
+            break;
+        case ACTIVATION_CONTEXT_SECTION_COM_TYPE_LIBRARY_REDIRECTION:
+            to->u.typelib.flags   = from->u.typelib.flags;
+            to->u.typelib.major   = from->u.typelib.major;
+            to->u.typelib.minor   = from->u.typelib.minor;
+            to->u.typelib.tlbid   = copy_string( from->u.typelib.tlbid, &ok );
+            to->u.typelib.helpdir = copy_string( from->u.typelib.helpdir, &ok );
+            break;
+        case ACTIVATION_CONTEXT_SECTION_WINDOW_CLASS_REDIRECTION:
+            to->u.class.versioned = from->u.class.versioned;
+            to->u.class.name      = copy_string( from->u.class.name, &ok );
+            break;
+        case ACTIVATION_CONTEXT_SECTION_CLR_SURROGATES:
+            to->u.clrsurrogate.name    = copy_string( from->u.clrsurrogate.name, &ok );
+            to->u.clrsurrogate.clsid   = copy_string( from->u.clrsurrogate.clsid, &ok );
+            to->u.clrsurrogate.version = copy_string( from->u.clrsurrogate.version, &ok );
+            break;
+        case ACTIVATION_CONTEXT_SECTION_APPLICATION_SETTINGS:
+            to->u.settings.name  = copy_string( from->u.settings.name, &ok );
+            to->u.settings.value = copy_string( from->u.settings.value, &ok );
+            to->u.settings.ns    = copy_string( from->u.settings.ns, &ok );
+            break;
+        case ACTIVATION_CONTEXT_SECTION_WINRT_ACTIVATABLE_CLASSES:
+            to->u.activatable_class.threading_model = from->u.activatable_class.threading_model;
+            to->u.activatable_class.name = copy_string( from->u.activatable_class.name, &ok );
+            break;
+        }
+    }
+    return ok;
+}
+
+/* copy a parsed assembly; on failure the partial copy can be freed with free_assembly() */
+static BOOL copy_assembly( struct assembly *dst, const struct assembly *src )
+{
+    unsigned int i;
+    BOOL ok = TRUE;
+
+    dst->type          = src->type;
+    dst->manifest.type = src->manifest.type;
+    dst->no_inherit    = src->no_inherit;
+    dst->run_level     = src->run_level;
+    dst->ui_access     = src->ui_access;
+    dst->manifest.info = copy_string( src->manifest.info, &ok );
+    dst->directory     = copy_string( src->directory, &ok );
+    if (!copy_assembly_identity( &dst->id, &src->id )) ok = FALSE;
+
+    if (src->num_compat_contexts)
+    {
+        if (!(dst->compat_contexts = RtlAllocateHeap( GetProcessHeap(), 0,
+                src->num_compat_contexts * sizeof(*src->compat_contexts) ))) return FALSE;
+        memcpy( dst->compat_contexts, src->compat_contexts,
+                src->num_compat_contexts * sizeof(*src->compat_contexts) );
+        dst->num_compat_contexts = src->num_compat_contexts;
+    }
+
+    if (src->num_dlls)
+    {
+        if (!(dst->dlls = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                           src->num_dlls * sizeof(*src->dlls) ))) return FALSE;
+        dst->allocated_dlls = src->num_dlls;
+        for (i = 0; i < src->num_dlls && ok; i++)
+        {
+            const struct dll_redirect *from = &src->dlls[i];
+            struct dll_redirect *to = &dst->dlls[dst->num_dlls++];
+
+            to->name      = copy_string( from->name, &ok );
+            to->load_from = copy_string( from->load_from, &ok );
+            to->hash      = copy_string( from->hash, &ok );
+            if (!copy_entity_array( &to->entities, &from->entities )) ok = FALSE;
+        }
+    }
+
+    if (!copy_entity_array( &dst->entities, &src->entities )) ok = FALSE;
+    return ok;
+}
+
 static BOOL is_matching_string( const WCHAR *str1, const WCHAR *str2 )
 {
     if (!str1) return !str2;
@@ -1095,30 +1244,33 @@ static inline void actctx_addref( ACTIVATION_CONTEXT *actctx )
     InterlockedIncrement( &actctx->ref_count );
 }
 
+static void free_assembly( struct assembly *assembly )
+{
+    unsigned int i;
+
+    for (i = 0; i < assembly->num_dlls; i++)
+    {
+        struct dll_redirect *dll = &assembly->dlls[i];
+        free_entity_array( &dll->entities );
+        RtlFreeHeap( GetProcessHeap(), 0, dll->name );
+        RtlFreeHeap( GetProcessHeap(), 0, dll->load_from );
+        RtlFreeHeap( GetProcessHeap(), 0, dll->hash );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, assembly->dlls );
+    RtlFreeHeap( GetProcessHeap(), 0, assembly->manifest.info );
+    RtlFreeHeap( GetProcessHeap(), 0, assembly->directory );
+    RtlFreeHeap( GetProcessHeap(), 0, assembly->compat_contexts );
+    free_entity_array( &assembly->entities );
+    free_assembly_identity(&assembly->id);
+}
+
 static void actctx_release( ACTIVATION_CONTEXT *actctx )
 {
     if (!InterlockedDecrement( &actctx->ref_count ))
     {
-        unsigned int i, j;
+        unsigned int i;
 
-        for (i = 0; i < actctx->num_assemblies; i++)
-        {
-            struct assembly *assembly = &actctx->assemblies[i];
-            for (j = 0; j < assembly->num_dlls; j++)
-            {
-                struct dll_redirect *dll = &assembly->dlls[j];
-                free_entity_array( &dll->entities );
-                RtlFreeHeap( GetProcessHeap(), 0, dll->name );
-                RtlFreeHeap( GetProcessHeap(), 0, dll->load_from );
-                RtlFreeHeap( GetProcessHeap(), 0, dll->hash );
-            }
-            RtlFreeHeap( GetProcessHeap(), 0, assembly->dlls );
-            RtlFreeHeap( GetProcessHeap(), 0, assembly->manifest.info );
-            RtlFreeHeap( GetProcessHeap(), 0, assembly->directory );
-            RtlFreeHeap( GetProcessHeap(), 0, assembly->compat_contexts );
-            free_entity_array( &assembly->entities );
-            free_assembly_identity(&assembly->id);
-        }
+        for (i = 0; i < actctx->num_assemblies; i++) free_assembly( &actctx->assemblies[i] );
         RtlFreeHeap( GetProcessHeap(), 0, actctx->config.info );
         RtlFreeHeap( GetProcessHeap(), 0, actctx->appdir.info );
         RtlFreeHeap( GetProcessHeap(), 0, actctx->assemblies );
@@ -2691,6 +2843,14 @@ static void parse_trust_info_elem( xmlbuf_t *xmlbuf, struct assembly *assembly,
     }
 }
 
+static BOOL is_matching_shared_version( const struct assembly_version *version,
+                                        const struct assembly_version *expected )
+{
+    if (version->major != expected->major || version->minor != expected->minor) return FALSE;
+    if (version->build != expected->build) return version->build > expected->build;
+    return version->revision >= expected->revision;
+}
+
 static void parse_assembly_elem( xmlbuf_t *xmlbuf, struct assembly* assembly,
                                  struct actctx_loader* acl, const struct xml_elem *parent,
                                  struct assembly_identity* expected_ai)
@@ -2784,11 +2944,7 @@ static void parse_assembly_elem( xmlbuf_t *xmlbuf, struct assembly* assembly,
                     set_error( xmlbuf );
                 }
                 else if (assembly->type == ASSEMBLY_SHARED_MANIFEST &&
-                         (assembly->id.version.major != expected_ai->version.major ||
-                          assembly->id.version.minor != expected_ai->version.minor ||
-                          assembly->id.version.build < expected_ai->version.build ||
-                          (assembly->id.version.build == expected_ai->version.build &&
-                           assembly->id.version.revision < expected_ai->version.revision)))
+                         !is_matching_shared_version( &assembly->id.version, &expected_ai->version ))
                 {
                     FIXME("wrong version for shared assembly manifest\n");
                     set_error( xmlbuf );
@@ -2926,6 +3082,135 @@ static NTSTATUS parse_manifest( struct actctx_loader* acl, struct assembly_ident
     return status;
 }
 
+/* parsed shared assembly manifests, reused by further activation contexts of the process
+ *
+ * The cache is private to each process and keyed on the manifest contents, so that
+ * a rewritten manifest is parsed again. Sharing parsed manifests across processes
+ * would need a serialized form of the assembly data; this is not implemented. */
+struct manifest_cache_entry
+{
+    struct list          entry;
+    SIZE_T               size;       /* size of the manifest contents */
+    ULONG                hash;       /* hash of the manifest contents */
+    ACTIVATION_CONTEXT   actctx;     /* context holding the parsed assembly */
+    struct actctx_loader acl;        /* dependencies found while parsing */
+};
+
+#define MANIFEST_CACHE_MAX_ENTRIES 32
+
+static struct list manifest_cache = LIST_INIT( manifest_cache );
+static unsigned int manifest_cache_count;
+
+static RTL_CRITICAL_SECTION manifest_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG manifest_cache_debug =
+{
+    0, 0, &manifest_cache_section,
+    { &manifest_cache_debug.ProcessLocksList, &manifest_cache_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": manifest_cache_section") }
+};
+static RTL_CRITICAL_SECTION manifest_cache_section = { &manifest_cache_debug, -1, 0, 0, 0, 0 };
+
+static ULONG hash_manifest( const void *buffer, SIZE_T size )
+{
+    const BYTE *ptr = buffer, *end = ptr + size;
+    ULONG hash = 0x811c9dc5;
+
+    while (ptr < end) hash = (hash ^ *ptr++) * 0x01000193;
+    return hash;
+}
+
+static void free_manifest_cache_entry( struct manifest_cache_entry *cache )
+{
+    unsigned int i;
+
+    for (i = 0; i < cache->actctx.num_assemblies; i++) free_assembly( &cache->actctx.assemblies[i] );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->actctx.assemblies );
+    free_depend_manifests( &cache->acl );
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+}
+
+/* add a copy of a cached assembly and of its dependencies to the context being built */
+static NTSTATUS add_cached_manifest( struct actctx_loader *acl, struct assembly_identity *ai,
+                                     const struct manifest_cache_entry *cache )
+{
+    const struct assembly *src = &cache->actctx.assemblies[0];
+    struct assembly_identity id;
+    struct assembly *assembly;
+    unsigned int i, count;
+
+    if (ai && !is_matching_shared_version( &src->id.version, &ai->version ))
+    {
+        FIXME("wrong version for shared assembly manifest\n");
+        return STATUS_SXS_CANT_GEN_ACTCTX;
+    }
+    if (!(assembly = add_assembly( acl->actctx, ASSEMBLY_SHARED_MANIFEST ))) return STATUS_SXS_CANT_GEN_ACTCTX;
+    if (!copy_assembly( assembly, src )) return STATUS_NO_MEMORY;
+    acl->actctx->sections |= cache->actctx.sections;
+
+    for (i = 0; i < cache->acl.num_dependencies; i++)
+    {
+        if (!copy_assembly_identity( &id, &cache->acl.dependencies[i] ))
+        {
+            free_assembly_identity( &id );
+            return STATUS_NO_MEMORY;
+        }
+        count = acl->num_dependencies;
+        if (!add_dependent_assembly_id( acl, &id ))
+        {
+            free_assembly_identity( &id );
+            return STATUS_SXS_CANT_GEN_ACTCTX;
+        }
+        if (acl->num_dependencies == count) free_assembly_identity( &id );
+    }
+    return STATUS_SUCCESS;
+}
+
+/* parse a winsxs manifest, reusing the result of a previous parse of the same file contents */
+static NTSTATUS parse_shared_manifest( struct actctx_loader *acl, struct assembly_identity *ai,
+                                       LPCWSTR filename, LPCWSTR directory, const void *buffer, SIZE_T size )
+{
+    struct manifest_cache_entry *cache;
+    ULONG hash = hash_manifest( buffer, size );
+    NTSTATUS status;
+
+    RtlEnterCriticalSection( &manifest_cache_section );
+    LIST_FOR_EACH_ENTRY( cache, &manifest_cache, struct manifest_cache_entry, entry )
+    {
+        if (cache->size != size || cache->hash != hash) continue;
+        if (wcscmp( cache->actctx.assemblies[0].manifest.info, filename + 4 /* skip \??\ prefix */ )) continue;
+        TRACE( "reusing parsed manifest %s\n", debugstr_w(filename) );
+        list_remove( &cache->entry );
+        list_add_head( &manifest_cache, &cache->entry );
+        status = add_cached_manifest( acl, ai, cache );
+        RtlLeaveCriticalSection( &manifest_cache_section );
+        return status;
+    }
+    RtlLeaveCriticalSection( &manifest_cache_section );
+
+    if (!(cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache) ))) return STATUS_NO_MEMORY;
+    cache->size = size;
+    cache->hash = hash;
+    cache->acl.actctx = &cache->actctx;
+    if ((status = parse_manifest( &cache->acl, ai, filename, NULL, directory, TRUE, buffer, size )))
+    {
+        free_manifest_cache_entry( cache );
+        return status;
+    }
+    status = add_cached_manifest( acl, ai, cache );
+
+    RtlEnterCriticalSection( &manifest_cache_section );
+    list_add_head( &manifest_cache, &cache->entry );
+    if (++manifest_cache_count > MANIFEST_CACHE_MAX_ENTRIES)
+    {
+        cache = LIST_ENTRY( list_tail( &manifest_cache ), struct manifest_cache_entry, entry );
+        list_remove( &cache->entry );
+        manifest_cache_count--;
+        free_manifest_cache_entry( cache );
+    }
+    RtlLeaveCriticalSection( &manifest_cache_section );
+    return status;
+}
+
 static NTSTATUS open_nt_file( HANDLE *handle, UNICODE_STRING *name )
 {
     OBJECT_ATTRIBUTES attr;
@@ -3101,7 +3386,12 @@ static NTSTATUS get_manifest_in_manifest_file( struct actctx_loader* acl, struct
 
     status = NtQueryInformationFile( file, &io, &info, sizeof(info), FileEndOfFileInformation );
     if (status == STATUS_SUCCESS)
-        status = parse_manifest(acl, ai, filename, NULL, directory, shared, base, info.EndOfFile.QuadPart);
+    {
+        if (shared)
+            status = parse_shared_manifest( acl, ai, filename, directory, base, info.EndOfFile.QuadPart );
+        else
+            status = parse_manifest( acl, ai, filename, NULL, directory, shared, base, info.EndOfFile.QuadPart );
+    }
 
     NtUnmapViewOfSection( GetCurrentProcess(), base );
     return status;
@@ -330,6 +330,11 @@ C_ASSERT( HEAP_MIN_LARGE_BLOCK_SIZE <= HEAP_INITIAL_GROW_SIZE );
 
 static struct heap *process_heap;  /* main process heap */
 
+/* allocation counters, only updated once statistics have been queried */
+static LONG heap_stats_enabled;
+static LONG64 heap_alloc_count;
+static LONG64 heap_lfh_alloc_count;
+
 static NTSTATUS heap_free_block_lfh( struct heap *heap, ULONG flags, struct block *block );
 
 /* check if memory range a contains memory range b */
@@ -2057,7 +2062,10 @@ void *WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE handle, ULONG flags, SIZE
     else if (block_size >= HEAP_MIN_LARGE_BLOCK_SIZE)
         status = heap_allocate_large( heap, heap_flags, block_size, size, &ptr );
     else if (heap->bins && !heap_allocate_block_lfh( heap, heap_flags, block_size, size, &ptr ))
+    {
         status = STATUS_SUCCESS;
+        if (ReadNoFence( &heap_stats_enabled )) InterlockedIncrement64( &heap_lfh_alloc_count );
+    }
     else
     {
         heap_lock( heap, heap_flags );
@@ -2072,7 +2080,11 @@ void *WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE handle, ULONG flags, SIZE
         }
     }
 
-    if (!status) valgrind_notify_alloc( ptr, size, flags & HEAP_ZERO_MEMORY );
+    if (!status)
+    {
+        valgrind_notify_alloc( ptr, size, flags & HEAP_ZERO_MEMORY );
+        if (ReadNoFence( &heap_stats_enabled )) InterlockedIncrement64( &heap_alloc_count );
+    }
 
     TRACE( "handle %p, flags %#lx, size %#Ix, return %p, status %#lx.\n", handle, flags, size, ptr, status );
     heap_set_status( heap, flags, status );
@@ -2560,6 +2572,52 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
     return total;
 }
 
+static void heap_add_stats( const struct heap *heap, struct wine_runtime_stats *stats )
+{
+    const ARENA_LARGE *large;
+    const SUBHEAP *subheap;
+    const struct entry *entry;
+
+    LIST_FOR_EACH_ENTRY( subheap, &heap->subheap_list, SUBHEAP, entry )
+        stats->heap_committed += (const char *)subheap_commit_end( subheap ) - (const char *)subheap_base( subheap );
+    LIST_FOR_EACH_ENTRY( large, &heap->large_list, ARENA_LARGE, entry )
+        stats->heap_committed += large->block_size;
+
+    LIST_FOR_EACH_ENTRY( entry, &heap->free_lists[0].entry, struct entry, entry )
+    {
+        if (block_get_flags( &entry->block ) == BLOCK_FLAG_FREE_LINK) continue;
+        stats->heap_free += block_get_size( &entry->block ) - block_get_overhead( &entry->block );
+    }
+    stats->heap_count++;
+}
+
+/***********************************************************************
+ *           heap_get_stats
+ *
+ * Fill the heap part of the runtime statistics. The first call enables the
+ * allocation counters.
+ */
+void heap_get_stats( struct wine_runtime_stats *stats )
+{
+    struct heap *heap;
+
+    InterlockedExchange( &heap_stats_enabled, 1 );
+    stats->heap_allocs = InterlockedCompareExchange64( &heap_alloc_count, 0, 0 );
+    stats->heap_lfh_allocs = InterlockedCompareExchange64( &heap_lfh_alloc_count, 0, 0 );
+
+    RtlEnterCriticalSection( &process_heap->cs );
+    heap_add_stats( process_heap, stats );
+    LIST_FOR_EACH_ENTRY( heap, &process_heap->entry, struct heap, entry )
+    {
+        /* don't wait for other heaps while holding the process heap lock */
+        if (heap->flags & HEAP_NO_SERIALIZE) continue;
+        if (!RtlTryEnterCriticalSection( &heap->cs )) continue;
+        heap_add_stats( heap, stats );
+        RtlLeaveCriticalSection( &heap->cs );
+    }
+    RtlLeaveCriticalSection( &process_heap->cs );
+}
+
 /***********************************************************************
  *           RtlQueryHeapInformation    (NTDLL.@)
  */
@@ -39,6 +39,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(module);
 WINE_DECLARE_DEBUG_CHANNEL(relay);
+WINE_DECLARE_DEBUG_CHANNEL(relaystats);
 WINE_DECLARE_DEBUG_CHANNEL(snoop);
 WINE_DECLARE_DEBUG_CHANNEL(loaddll);
 WINE_DECLARE_DEBUG_CHANNEL(imports);
@@ -132,6 +133,13 @@ struct file_id
     BYTE ObjectId[16];
 };
 
+/* resolved forwarded export */
+struct cached_export
+{
+    DWORD                 rva;           /* forward string the export was resolved from */
+    FARPROC               proc;          /* final address of the export */
+};
+
 /* internal representation of loaded modules */
 typedef struct _wine_modref
 {
@@ -139,6 +147,7 @@ typedef struct _wine_modref
     struct file_id        id;
     ULONG                 CheckSum;
     BOOL                  system;
+    struct cached_export *export_cache;  /* resolved forwarded exports, indexed by ordinal - base */
 } WINE_MODREF;
 
 static UINT tls_module_count;      /* number of modules with TLS directory */
@@ -195,6 +204,10 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
                                     DWORD exp_size, DWORD ordinal, LPCWSTR load_path );
 static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
                                   DWORD exp_size, const char *name, int hint, LPCWSTR load_path );
+static int find_named_ordinal( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+                               const char *name, int hint );
+static FARPROC find_cached_export( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports,
+                                   DWORD exp_size, DWORD ordinal, LPCWSTR load_path );
 
 /* convert PE image VirtualAddress to Real Address */
 static inline void *get_rva( HMODULE module, DWORD va )
@@ -946,12 +959,14 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
                                                  IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size )))
     {
         const char *name = end + 1;
+        int ordinal;
 
-        if (*name == '#') { /* ordinal */
-            proc = find_ordinal_export( wm->ldr.DllBase, exports, exp_size,
-                                        atoi(name+1) - exports->Base, load_path );
-        } else
-            proc = find_named_export( wm->ldr.DllBase, exports, exp_size, name, -1, load_path );
+        if (*name == '#') /* ordinal */
+            ordinal = atoi(name+1) - exports->Base;
+        else
+            ordinal = find_named_ordinal( wm->ldr.DllBase, exports, name, -1 );
+        if (ordinal != -1)
+            proc = find_cached_export( wm, exports, exp_size, ordinal, load_path );
     }
 
     if (!proc)
@@ -997,7 +1012,7 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
         const WCHAR *user = current_modref ? current_modref->ldr.BaseDllName.Buffer : NULL;
         proc = SNOOP_GetProcAddress( module, exports, exp_size, proc, ordinal, user );
     }
-    if (TRACE_ON(relay))
+    if (TRACE_ON(relay) || TRACE_ON(relaystats))
     {
         const WCHAR *user = current_modref ? current_modref->ldr.BaseDllName.Buffer : NULL;
         proc = RELAY_GetProcAddress( module, exports, exp_size, proc, ordinal, user );
@@ -1030,30 +1045,109 @@ static int find_name_in_exports( HMODULE module, const IMAGE_EXPORT_DIRECTORY *e
 
 
 /*************************************************************************
- *		find_named_export
+ *		find_named_ordinal
  *
- * Find an exported function by name.
- * The loader_section must be locked while calling this function.
+ * Find the ordinal of an exported function by name, trying the hint first.
+ * The returned ordinal has the exports base already subtracted.
  */
-static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
-                                  DWORD exp_size, const char *name, int hint, LPCWSTR load_path )
+static int find_named_ordinal( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+                               const char *name, int hint )
 {
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
-    int ordinal;
 
     /* first check the hint */
     if (hint >= 0 && hint < exports->NumberOfNames)
     {
         char *ename = get_rva( module, names[hint] );
-        if (!strcmp( ename, name ))
-            return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
+        if (!strcmp( ename, name )) return ordinals[hint];
     }
 
     /* then do a binary search */
-    if ((ordinal = find_name_in_exports( module, exports, name )) == -1) return NULL;
+    return find_name_in_exports( module, exports, name );
+}
+
+
+/*************************************************************************
+ *		find_named_export
+ *
+ * Find an exported function by name.
+ * The loader_section must be locked while calling this function.
+ */
+static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+                                  DWORD exp_size, const char *name, int hint, LPCWSTR load_path )
+{
+    int ordinal;
+
+    if ((ordinal = find_named_ordinal( module, exports, name, hint )) == -1) return NULL;
     return find_ordinal_export( module, exports, exp_size, ordinal, load_path );
+}
 
+
+/*************************************************************************
+ *		find_cached_export
+ *
+ * Find an exported function by ordinal, remembering the result in the
+ * exporting module if it is a forward, so that forwarder chains and api set
+ * redirections are only resolved once per process, however many modules
+ * import the function. The entry is checked against the export table on
+ * each lookup, so that patched exports are picked up.
+ * The exports base must have been subtracted from the ordinal already.
+ * The loader_section must be locked while calling this function.
+ */
+static FARPROC find_cached_export( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports,
+                                   DWORD exp_size, DWORD ordinal, LPCWSTR load_path )
+{
+    const DWORD *functions = get_rva( wm->ldr.DllBase, exports->AddressOfFunctions );
+    DWORD rva, exports_rva = (const char *)exports - (const char *)wm->ldr.DllBase;
+    FARPROC proc;
+
+    /* relay and snoop thunks depend on the importing module, don't share them */
+    if (TRACE_ON(relay) || TRACE_ON(relaystats) || TRACE_ON(snoop) || ordinal >= exports->NumberOfFunctions)
+        return find_ordinal_export( wm->ldr.DllBase, exports, exp_size, ordinal, load_path );
+
+    /* other exports are found directly in the export table */
+    rva = functions[ordinal];
+    if (rva < exports_rva || rva >= exports_rva + exp_size)
+        return find_ordinal_export( wm->ldr.DllBase, exports, exp_size, ordinal, load_path );
+
+    if (wm->export_cache && wm->export_cache[ordinal].rva == rva && wm->export_cache[ordinal].proc)
+        return wm->export_cache[ordinal].proc;
+
+    if (!(proc = find_ordinal_export( wm->ldr.DllBase, exports, exp_size, ordinal, load_path )))
+        return NULL;
+
+    /* resolving a forward may have loaded or unloaded modules, so check again */
+    if (!wm->export_cache)
+        wm->export_cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                            exports->NumberOfFunctions * sizeof(*wm->export_cache) );
+    if (wm->export_cache)
+    {
+        wm->export_cache[ordinal].rva = rva;
+        wm->export_cache[ordinal].proc = proc;
+    }
+    return proc;
+}
+
+
+/*************************************************************************
+ *		flush_export_caches
+ *
+ * Forget all resolved exports, since some of them may point into a module
+ * that is being unloaded.
+ * The loader_section must be locked while calling this function.
+ */
+static void flush_export_caches(void)
+{
+    PLIST_ENTRY mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList, entry;
+    WINE_MODREF *wm;
+
+    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+    {
+        wm = CONTAINING_RECORD( entry, WINE_MODREF, ldr.InLoadOrderLinks );
+        RtlFreeHeap( GetProcessHeap(), 0, wm->export_cache );
+        wm->export_cache = NULL;
+    }
 }
 
 
@@ -1177,8 +1271,8 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         {
             int ordinal = IMAGE_ORDINAL(import_list->u1.Ordinal);
 
-            thunk_list->u1.Function = (ULONG_PTR)find_ordinal_export( imp_mod, exports, exp_size,
-                                                                      ordinal - exports->Base, load_path );
+            thunk_list->u1.Function = (ULONG_PTR)find_cached_export( wmImp, exports, exp_size,
+                                                                     ordinal - exports->Base, load_path );
             if (!thunk_list->u1.Function)
             {
                 thunk_list->u1.Function = allocate_stub( name, IntToPtr(ordinal) );
@@ -1191,10 +1285,14 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         else  /* import by name */
         {
             IMAGE_IMPORT_BY_NAME *pe_name;
+            int ordinal;
+
             pe_name = get_rva( module, (DWORD)import_list->u1.AddressOfData );
-            thunk_list->u1.Function = (ULONG_PTR)find_named_export( imp_mod, exports, exp_size,
-                                                                    (const char*)pe_name->Name,
-                                                                    pe_name->Hint, load_path );
+            ordinal = find_named_ordinal( imp_mod, exports, (const char *)pe_name->Name, pe_name->Hint );
+            thunk_list->u1.Function = 0;
+            if (ordinal != -1)
+                thunk_list->u1.Function = (ULONG_PTR)find_cached_export( wmImp, exports, exp_size,
+                                                                         ordinal, load_path );
             if (!thunk_list->u1.Function)
             {
                 thunk_list->u1.Function = allocate_stub( name, (const char*)pe_name->Name );
@@ -2242,7 +2340,7 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
 
     if (is_builtin)
     {
-        if (TRACE_ON(relay)) RELAY_SetupDLL( *module );
+        if (TRACE_ON(relay) || TRACE_ON(relaystats)) RELAY_SetupDLL( *module );
     }
     else
     {
@@ -2278,7 +2376,7 @@ static void build_ntdll_module(void)
     assert( wm );
     wm->ldr.Flags &= ~LDR_DONT_RESOLVE_REFS;
     node_ntdll = wm->ldr.DdagNode;
-    if (TRACE_ON(relay)) RELAY_SetupDLL( module );
+    if (TRACE_ON(relay) || TRACE_ON(relaystats)) RELAY_SetupDLL( module );
 }
 
 
@@ -3820,6 +3918,9 @@ void WINAPI LdrShutdownProcess(void)
         RtlProcessFlsData( NtCurrentTeb()->FlsSlots, 1 );
 
     process_detach();
+    __wine_dbg_dump_lock_stats();
+    __wine_dbg_dump_relay_stats();
+    __wine_dbg_dump_syscall_stats();
 }
 
 
@@ -3909,6 +4010,9 @@ static void free_modref( WINE_MODREF *wm )
     if (wm->ldr.InInitializationOrderLinks.Flink)
         RemoveEntryList(&wm->ldr.InInitializationOrderLinks);
 
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_cache );
+    flush_export_caches();
+
     while ((entry = wm->ldr.DdagNode->Dependencies.Tail))
     {
         dep = CONTAINING_RECORD( entry, LDR_DEPENDENCY, dependency_to_entry );
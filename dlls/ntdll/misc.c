@@ -501,3 +501,29 @@ ULONG WINAPIV EtwTraceMessage( TRACEHANDLE handle, ULONG flags, LPGUID guid, /*U
     va_end( valist );
     return ret;
 }
+
+/*********************************************************************
+ *                  __wine_get_runtime_stats   (NTDLL.@)
+ */
+NTSTATUS WINAPI __wine_get_runtime_stats( struct wine_runtime_stats *stats, ULONG size )
+{
+    NTSTATUS status;
+
+    if (size != sizeof(*stats)) return STATUS_INFO_LENGTH_MISMATCH;
+
+    memset( stats, 0, sizeof(*stats) );
+    if ((status = WINE_UNIX_CALL( unix_get_runtime_stats, stats ))) return status;
+    heap_get_stats( stats );
+    threadpool_get_stats( stats );
+    return STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ *                  __wine_dbg_dump_syscall_stats   (NTDLL.@)
+ *
+ * Dump the syscall statistics collected with WINEDEBUG=+syscallstats.
+ */
+void __cdecl __wine_dbg_dump_syscall_stats(void)
+{
+    WINE_UNIX_CALL( unix_dump_syscall_stats, NULL );
+}
@@ -1723,6 +1723,10 @@
 @ cdecl -norelay __wine_dbg_header(long long str)
 @ cdecl -norelay __wine_dbg_output(str)
 @ cdecl -norelay __wine_dbg_strdup(str)
+@ cdecl -norelay __wine_dbg_dump_lock_stats()
+@ cdecl -norelay __wine_dbg_dump_relay_stats()
+@ cdecl -norelay __wine_dbg_dump_syscall_stats()
+@ stdcall __wine_get_runtime_stats(ptr long)
 
 # Version
 @ cdecl wine_get_version()
@@ -29,6 +29,7 @@
 #include "winternl.h"
 #include "unixlib.h"
 #include "wine/asm.h"
+#include "wine/perfstats.h"
 
 #define DECLARE_CRITICAL_SECTION(cs) \
     static RTL_CRITICAL_SECTION cs; \
@@ -66,6 +67,9 @@ extern RUNTIME_FUNCTION *lookup_function_info( ULONG_PTR pc, ULONG_PTR *base, LD
 extern LPCSTR debugstr_us( const UNICODE_STRING *str );
 extern const char *debugstr_exception_code( DWORD code );
 extern void set_native_thread_name( DWORD tid, const char *name );
+extern void __cdecl __wine_dbg_dump_lock_stats(void);
+extern void __cdecl __wine_dbg_dump_relay_stats(void);
+extern void __cdecl __wine_dbg_dump_syscall_stats(void);
 
 /* init routines */
 extern void loader_init( CONTEXT *context, void **entry );
@@ -131,6 +135,10 @@ static inline void ascii_to_unicode( WCHAR *dst, const char *src, size_t len )
 extern TEB_FLS_DATA *fls_alloc_data(void);
 extern void heap_thread_detach(void);
 
+/* runtime statistics */
+extern void heap_get_stats( struct wine_runtime_stats *stats );
+extern void threadpool_get_stats( struct wine_runtime_stats *stats );
+
 #ifdef __arm64ec__
 
 extern void *__os_arm64x_check_call;
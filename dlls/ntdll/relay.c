@@ -33,6 +33,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(relay);
+WINE_DECLARE_DEBUG_CHANNEL(relaystats);
 
 #if (defined(__i386__) || defined(__x86_64__) || defined(__arm__) || defined(__aarch64__)) && !defined(__arm64ec__)
 
@@ -63,12 +64,26 @@ struct relay_entry_point
     const char *name;         /* function name (if any) */
 };
 
+#define RELAY_STATS_BUCKETS 20  /* log2 of the call duration in microseconds */
+#define RELAY_STATS_DEPTH   64  /* nested relayed calls timed per thread */
+
+struct relay_stats
+{
+    char     name[48];                     /* function name, copied in case the dll is unloaded */
+    LONG     calls;                        /* number of calls */
+    LONGLONG time;                         /* inclusive time, in performance counter ticks */
+    LONG     hist[RELAY_STATS_BUCKETS];    /* number of returns per duration bucket */
+};
+
 struct relay_private_data
 {
-    HMODULE                  module;            /* module handle of this dll */
-    unsigned int             base;              /* ordinal base */
-    char                     dllname[40];       /* dll name (without .dll extension) */
-    struct relay_entry_point entry_points[1];   /* list of dll entry points */
+    HMODULE                    module;            /* module handle of this dll */
+    unsigned int               base;              /* ordinal base */
+    char                       dllname[40];       /* dll name (without .dll extension) */
+    struct relay_private_data *next;              /* next dll with statistics */
+    struct relay_stats        *stats;             /* per entry point statistics, if enabled */
+    unsigned int               count;             /* number of entry points */
+    struct relay_entry_point   entry_points[1];   /* list of dll entry points */
 };
 
 static const WCHAR **debug_relay_excludelist;
@@ -82,6 +97,10 @@ static const WCHAR **debug_from_snoop_includelist;
 
 static RTL_RUN_ONCE init_once = RTL_RUN_ONCE_INIT;
 
+static struct relay_private_data *relay_stats_dlls;
+static ULONG relay_stats_tls = TLS_OUT_OF_INDEXES;
+static LARGE_INTEGER relay_stats_freq;
+
 /* compare an ASCII and a Unicode string without depending on the current codepage */
 static inline int strcmpAW( const char *strA, const WCHAR *strW )
 {
@@ -168,6 +187,24 @@ static DWORD WINAPI init_debug_lists( RTL_RUN_ONCE *once, void *param, void **co
     UNICODE_STRING name = RTL_CONSTANT_STRING( L"Software\\Wine\\Debug" );
     HANDLE root, hkey;
 
+    if (TRACE_ON(relaystats))
+    {
+        PEB *peb = NtCurrentTeb()->Peb;
+        ULONG index;
+
+        RtlQueryPerformanceFrequency( &relay_stats_freq );
+        RtlAcquirePebLock();
+        index = RtlFindClearBitsAndSet( peb->TlsBitmap, 1, 1 );
+        if (index != ~0U)
+        {
+            NtCurrentTeb()->TlsSlots[index] = 0;
+            relay_stats_tls = index;
+        }
+        RtlReleasePebLock();
+        if (relay_stats_tls == TLS_OUT_OF_INDEXES)
+            WARN_(relaystats)( "no TLS slot available, call times won't be recorded\n" );
+    }
+
     RtlOpenCurrentUser( KEY_ALL_ACCESS, &root );
     attr.Length = sizeof(attr);
     attr.RootDirectory = root;
@@ -302,6 +339,137 @@ static void trace_string_w( INT_PTR ptr )
     else TRACE( "%08Ix", ptr );
 }
 
+
+/***********************************************************************
+ * Relay call statistics
+ *
+ * Enabled with WINEDEBUG=+relaystats; the relay thunks are installed as
+ * for +relay, using the same include and exclude lists, but instead of
+ * tracing each call they count calls and returns per entry point. Call
+ * times are matched up using a small per-thread stack of pending calls.
+ ***********************************************************************/
+
+struct relay_stats_frame
+{
+    const struct relay_descr *descr;
+    ULONG_PTR                 retaddr;
+    unsigned int              ordinal;
+    LONGLONG                  start;
+};
+
+struct relay_stats_stack
+{
+    unsigned int             depth;
+    struct relay_stats_frame frames[RELAY_STATS_DEPTH];
+};
+
+static struct relay_stats_stack *get_relay_stats_stack(void)
+{
+    struct relay_stats_stack *stack;
+
+    if (relay_stats_tls == TLS_OUT_OF_INDEXES) return NULL;
+    if (!(stack = NtCurrentTeb()->TlsSlots[relay_stats_tls]))
+    {
+        /* never freed, this is a debugging aid */
+        stack = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*stack) );
+        NtCurrentTeb()->TlsSlots[relay_stats_tls] = stack;
+    }
+    return stack;
+}
+
+static void relay_stats_entry( const struct relay_descr *descr, unsigned int ordinal, ULONG_PTR retaddr )
+{
+    struct relay_private_data *data = descr->private;
+    struct relay_stats_stack *stack;
+    struct relay_stats_frame *frame;
+    LARGE_INTEGER now;
+
+    if (!data->stats) return;
+    InterlockedIncrement( &data->stats[ordinal].calls );
+
+    if (!(stack = get_relay_stats_stack())) return;
+    if (stack->depth++ >= RELAY_STATS_DEPTH) return;
+
+    RtlQueryPerformanceCounter( &now );
+    frame = &stack->frames[stack->depth - 1];
+    frame->descr = descr;
+    frame->retaddr = retaddr;
+    frame->ordinal = ordinal;
+    frame->start = now.QuadPart;
+}
+
+static void relay_stats_exit( const struct relay_descr *descr, unsigned int ordinal, ULONG_PTR retaddr )
+{
+    struct relay_private_data *data = descr->private;
+    struct relay_stats_stack *stack;
+    struct relay_stats *stats;
+    LARGE_INTEGER now;
+    LONGLONG time, usecs;
+    unsigned int i, bucket;
+
+    if (!data->stats || relay_stats_tls == TLS_OUT_OF_INDEXES) return;
+    if (!(stack = NtCurrentTeb()->TlsSlots[relay_stats_tls]) || !stack->depth) return;
+
+    RtlQueryPerformanceCounter( &now );
+    if (stack->depth > RELAY_STATS_DEPTH)
+    {
+        stack->depth--;
+        return;
+    }
+
+    /* skip calls that were unwound by an exception */
+    for (i = stack->depth; i > 0; i--)
+    {
+        const struct relay_stats_frame *frame = &stack->frames[i - 1];
+        if (frame->descr == descr && frame->ordinal == ordinal && frame->retaddr == retaddr) break;
+    }
+    if (!i) return;
+    stack->depth = i - 1;
+
+    stats = &data->stats[ordinal];
+    time = now.QuadPart - stack->frames[i - 1].start;
+    usecs = time * 1000000 / relay_stats_freq.QuadPart;
+    for (bucket = 0; usecs && bucket < RELAY_STATS_BUCKETS - 1; bucket++) usecs >>= 1;
+
+    InterlockedExchangeAdd64( &stats->time, time );
+    InterlockedIncrement( &stats->hist[bucket] );
+}
+
+/***********************************************************************
+ *      __wine_dbg_dump_relay_stats   (NTDLL.@)
+ *
+ * Dump the relay call statistics collected so far, for each called function.
+ * Times are in microseconds; bucket n of the histogram counts the calls
+ * that took less than 2^n microseconds.
+ */
+void __cdecl __wine_dbg_dump_relay_stats(void)
+{
+    const struct relay_private_data *data;
+    unsigned int i, j;
+
+    if (!TRACE_ON(relaystats)) return;
+
+    for (data = relay_stats_dlls; data; data = data->next)
+    {
+        for (i = 0; i < data->count; i++)
+        {
+            const struct relay_stats *stats = &data->stats[i];
+            char buffer[RELAY_STATS_BUCKETS * 12], *p = buffer;
+
+            if (!stats->calls) continue;
+            for (j = 0; j < RELAY_STATS_BUCKETS; j++)
+                p += sprintf( p, j ? ",%ld" : "%ld", stats->hist[j] );
+
+            if (stats->name[0])
+                TRACE_(relaystats)( "%s.%s calls %ld time %I64d hist %s\n", data->dllname, stats->name,
+                                    stats->calls, stats->time * 1000000 / relay_stats_freq.QuadPart, buffer );
+            else
+                TRACE_(relaystats)( "%s.%u calls %ld time %I64d hist %s\n", data->dllname, data->base + i,
+                                    stats->calls, stats->time * 1000000 / relay_stats_freq.QuadPart, buffer );
+        }
+    }
+}
+
 #ifdef __i386__
 
 /***********************************************************************
@@ -357,6 +525,7 @@ void * WINAPI relay_trace_entry( struct relay_descr *descr, unsigned int idx,
         if (arg_types[1] == 't') *nb_args |= 0x40000000;  /* fastcall */
     }
     TRACE( ") ret=%08lx\n", stack[-1] );
+    if (TRACE_ON(relaystats)) relay_stats_entry( descr, ordinal, stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -368,6 +537,8 @@ void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (TRACE_ON(relaystats)) relay_stats_exit( descr, LOWORD(idx), (ULONG_PTR)retaddr );
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -521,6 +692,7 @@ void * WINAPI relay_trace_entry( struct relay_descr *descr, unsigned int idx,
 #endif
     *nb_args = pos;
     TRACE( ") ret=%08lx\n", stack[-1] );
+    if (TRACE_ON(relaystats)) relay_stats_entry( descr, ordinal, stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -532,6 +704,8 @@ void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (TRACE_ON(relaystats)) relay_stats_exit( descr, LOWORD(idx), (ULONG_PTR)retaddr );
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -630,6 +804,7 @@ void * WINAPI relay_trace_entry( struct relay_descr *descr, unsigned int idx,
     }
     *nb_args = i;
     TRACE( ") ret=%08Ix\n", stack[-1] );
+    if (TRACE_ON(relaystats)) relay_stats_entry( descr, ordinal, stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -639,6 +814,8 @@ void * WINAPI relay_trace_entry( struct relay_descr *descr, unsigned int idx,
 void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (TRACE_ON(relaystats)) relay_stats_exit( descr, LOWORD(idx), (ULONG_PTR)retaddr );
+
     TRACE( "\1Ret  %s() retval=%08Ix ret=%08Ix\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -736,6 +913,7 @@ void * WINAPI relay_trace_entry( struct relay_descr *descr, unsigned int idx,
     }
     *nb_args = i;
     TRACE( ") ret=%08Ix\n", stack[-1] );
+    if (TRACE_ON(relaystats)) relay_stats_entry( descr, ordinal, stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -745,6 +923,8 @@ void * WINAPI relay_trace_entry( struct relay_descr *descr, unsigned int idx,
 void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (TRACE_ON(relaystats)) relay_stats_exit( descr, LOWORD(idx), (ULONG_PTR)retaddr );
+
     TRACE( "\1Ret  %s() retval=%08Ix ret=%08Ix\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -910,6 +1090,21 @@ void RELAY_SetupDLL( HMODULE module )
         data->entry_points[*ordptr].name = (const char *)module + name_rva;
     }
 
+    data->count = exports->NumberOfFunctions;
+    if (TRACE_ON(relaystats) &&
+        (data->stats = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                        exports->NumberOfFunctions * sizeof(*data->stats) )))
+    {
+        for (i = 0; i < exports->NumberOfFunctions; i++)
+        {
+            if (!data->entry_points[i].name) continue;
+            len = min( strlen( data->entry_points[i].name ), sizeof(data->stats[i].name) - 1 );
+            memcpy( data->stats[i].name, data->entry_points[i].name, len );
+        }
+        data->next = relay_stats_dlls;
+        relay_stats_dlls = data;
+    }
+
     /* patch the functions in the export table to point to the relay thunks */
 
     funcs = (DWORD *)((char *)module + exports->AddressOfFunctions);
@@ -943,6 +1138,10 @@ void RELAY_SetupDLL( HMODULE module )
 {
 }
 
+void __cdecl __wine_dbg_dump_relay_stats(void)
+{
+}
+
 #endif  /* __i386__ || __x86_64__ || __arm__ || __aarch64__ */
 
 
@@ -2120,7 +2120,7 @@ void WINAPI RtlGetCurrentProcessorNumberEx(PROCESSOR_NUMBER *processor)
 {
     FIXME("(%p) :semi-stub\n", processor);
     processor->Group = 0;
-    processor->Number = NtGetCurrentProcessorNumber();
+    processor->Number = WINE_UNIX_CALL( unix_fast_NtGetCurrentProcessorNumber, NULL );
     processor->Reserved = 0;
 }
 
@@ -38,6 +38,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(sync);
 WINE_DECLARE_DEBUG_CHANNEL(relay);
+WINE_DECLARE_DEBUG_CHANNEL(lockprof);
 
 static const char *debugstr_timeout( const LARGE_INTEGER *timeout )
 {
@@ -45,6 +46,9 @@ static const char *debugstr_timeout( const LARGE_INTEGER *timeout )
     return wine_dbgstr_longlong( timeout->QuadPart );
 }
 
+static NTSTATUS wait_on_address( const void *addr, const void *cmp, SIZE_T size,
+                                 const LARGE_INTEGER *timeout, BOOL host_futex );
+
 /******************************************************************
  *              RtlRunOnceInitialize (NTDLL.@)
  */
@@ -142,6 +146,116 @@ DWORD WINAPI RtlRunOnceComplete( RTL_RUN_ONCE *once, ULONG flags, void *context
 }
 
 
+/***********************************************************************
+ * Lock contention statistics
+ *
+ * Enabled with WINEDEBUG=+lockprof; only contended acquisitions are
+ * recorded, so the uncontended paths are not affected.
+ *
+ * Statistics are keyed by lock address, so a lock that is deleted and then
+ * reinitialized at the same address shares the entry of its predecessor.
+ * SRW locks don't record their owner, so it is only known for critical
+ * sections.
+ ***********************************************************************/
+
+#define LOCK_STATS_SIZE   1024
+#define LOCK_STATS_PROBES 16
+#define LOCK_STATS_FRAMES 8
+
+struct lock_stats
+{
+    const void *lock;
+    char        name[64];
+    LONG        count;                        /* number of contended acquisitions */
+    LONGLONG    wait;                         /* total time spent waiting */
+    LONGLONG    max_wait;                     /* longest single wait */
+    DWORD       max_owner;                    /* owner during the longest wait, if known */
+    void       *max_stack[LOCK_STATS_FRAMES]; /* waiter backtrace for the longest wait */
+};
+
+static struct lock_stats lock_stats[LOCK_STATS_SIZE];
+
+static struct lock_stats *get_lock_stats( const void *lock )
+{
+    unsigned int i, hash = ((ULONG_PTR)lock >> 4) % LOCK_STATS_SIZE;
+
+    for (i = 0; i < LOCK_STATS_PROBES; i++)
+    {
+        struct lock_stats *stats = &lock_stats[(hash + i) % LOCK_STATS_SIZE];
+        const void *prev;
+
+        if (stats->lock == lock) return stats;
+        if (!(prev = InterlockedCompareExchangePointer( (void **)&stats->lock, (void *)lock, NULL ))
+            || prev == lock)
+            return stats;
+    }
+    return NULL;
+}
+
+static inline void start_lock_wait( LARGE_INTEGER *start )
+{
+    start->QuadPart = 0;
+    if (TRACE_ON(lockprof)) NtQueryPerformanceCounter( start, NULL );
+}
+
+static void end_lock_wait( const LARGE_INTEGER *start, const void *lock, const char *name, DWORD owner )
+{
+    struct lock_stats *stats;
+    LARGE_INTEGER now;
+    LONGLONG wait;
+
+    if (!start->QuadPart || !(stats = get_lock_stats( lock ))) return;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    wait = now.QuadPart - start->QuadPart;
+
+    if (!stats->name[0] && name) memcpy( stats->name, name, min( strlen( name ), sizeof(stats->name) - 1 ));
+    InterlockedIncrement( &stats->count );
+    InterlockedExchangeAdd64( &stats->wait, wait );
+    if (wait > stats->max_wait)
+    {
+        /* not atomic, but good enough for statistics */
+        stats->max_wait = wait;
+        stats->max_owner = owner;
+        memset( stats->max_stack, 0, sizeof(stats->max_stack) );
+        RtlCaptureStackBackTrace( 2, LOCK_STATS_FRAMES, stats->max_stack, NULL );
+    }
+}
+
+/***********************************************************************
+ *      __wine_dbg_dump_lock_stats   (NTDLL.@)
+ *
+ * Dump the contention statistics collected so far; tools/lockprof-report
+ * ranks them. Times are in microseconds, an unknown owner is printed as "-".
+ */
+void __cdecl __wine_dbg_dump_lock_stats(void)
+{
+    LARGE_INTEGER freq, now;
+    unsigned int i, j;
+
+    if (!TRACE_ON(lockprof)) return;
+
+    NtQueryPerformanceCounter( &now, &freq );
+    for (i = 0; i < LOCK_STATS_SIZE; i++)
+    {
+        const struct lock_stats *stats = &lock_stats[i];
+        char owner[12] = "-", stack[LOCK_STATS_FRAMES * 20], *p = stack;
+
+        if (!stats->count) continue;
+
+        if (stats->max_owner) sprintf( owner, "%04lx", stats->max_owner );
+        *p = 0;
+        for (j = 0; j < LOCK_STATS_FRAMES && stats->max_stack[j]; j++)
+            p += sprintf( p, j ? ",%p" : "%p", stats->max_stack[j] );
+
+        TRACE_(lockprof)( "lock %p %s count %ld wait %I64d max %I64d owner %s stack %s\n",
+                          stats->lock, debugstr_a(stats->name), stats->count,
+                          stats->wait * 1000000 / freq.QuadPart,
+                          stats->max_wait * 1000000 / freq.QuadPart, owner, stack );
+    }
+}
+
+
 /***********************************************************************
  * Critical sections
  ***********************************************************************/
@@ -193,7 +307,7 @@ static inline NTSTATUS wait_semaphore( RTL_CRITICAL_SECTION *crit, int timeout )
         {
             static const LONG zero;
             /* this may wait longer than specified in case of multiple wake-ups */
-            if (RtlWaitOnAddress( lock, &zero, sizeof(LONG), &time ) == STATUS_TIMEOUT)
+            if (wait_on_address( lock, &zero, sizeof(LONG), &time, TRUE ) == STATUS_TIMEOUT)
                 return STATUS_TIMEOUT;
         }
         return STATUS_WAIT_0;
@@ -300,6 +414,8 @@ NTSTATUS WINAPI RtlDeleteCriticalSection( RTL_CRITICAL_SECTION *crit )
 NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
     unsigned int timeout = 5;
+    DWORD owner = HandleToULong( crit->OwningThread );
+    LARGE_INTEGER start;
 
     /* Don't allow blocking on a critical section during process termination */
     if (RtlDllShutdownInProgress())
@@ -309,6 +425,7 @@ NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
         return STATUS_SUCCESS;
     }
 
+    start_lock_wait( &start );
     for (;;)
     {
         NTSTATUS status = wait_semaphore( crit, timeout );
@@ -321,6 +438,7 @@ NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
              crit, debugstr_a(crit_section_get_name(crit)), GetCurrentThreadId(), HandleToULong(crit->OwningThread), timeout );
     }
     if (crit_section_has_debuginfo( crit )) crit->DebugInfo->ContentionCount++;
+    end_lock_wait( &start, crit, crit_section_get_name( crit ), owner );
     return STATUS_SUCCESS;
 }
 
@@ -517,6 +635,7 @@ void WINAPI RtlInitializeSRWLock( RTL_SRWLOCK *lock )
 void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 {
     union { RTL_SRWLOCK *rtl; struct srw_lock *s; LONG *l; } u = { lock };
+    LARGE_INTEGER start = {{0}};
 
     InterlockedExchangeAdd16( &u.s->exclusive_waiters, 2 );
 
@@ -544,9 +663,12 @@ void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
             }
         } while (InterlockedCompareExchange( u.l, new.l, old.l ) != old.l);
 
-        if (!wait) return;
-        RtlWaitOnAddress( &u.s->owners, &new.s.owners, sizeof(short), NULL );
+        if (!wait) break;
+        if (!start.QuadPart) start_lock_wait( &start );
+        wait_on_address( &u.s->owners, &new.s.owners, sizeof(short), NULL, TRUE );
     }
+
+    end_lock_wait( &start, lock, "SRW lock", 0 );
 }
 
 /***********************************************************************
@@ -559,6 +681,7 @@ void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
 {
     union { RTL_SRWLOCK *rtl; struct srw_lock *s; LONG *l; } u = { lock };
+    LARGE_INTEGER start = {{0}};
 
     for (;;)
     {
@@ -583,9 +706,12 @@ void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
             }
         } while (InterlockedCompareExchange( u.l, new.l, old.l ) != old.l);
 
-        if (!wait) return;
-        RtlWaitOnAddress( u.s, &new.s, sizeof(struct srw_lock), NULL );
+        if (!wait) break;
+        if (!start.QuadPart) start_lock_wait( &start );
+        wait_on_address( u.s, &new.s, sizeof(struct srw_lock), NULL, TRUE );
     }
+
+    end_lock_wait( &start, lock, "SRW lock", 0 );
 }
 
 /***********************************************************************
@@ -770,7 +896,7 @@ NTSTATUS WINAPI RtlSleepConditionVariableCS( RTL_CONDITION_VARIABLE *variable, R
     NTSTATUS status;
 
     RtlLeaveCriticalSection( crit );
-    status = RtlWaitOnAddress( &variable->Ptr, &value, sizeof(value), timeout );
+    status = wait_on_address( &variable->Ptr, &value, sizeof(value), timeout, TRUE );
     RtlEnterCriticalSection( crit );
     return status;
 }
@@ -805,7 +931,7 @@ NTSTATUS WINAPI RtlSleepConditionVariableSRW( RTL_CONDITION_VARIABLE *variable,
     else
         RtlReleaseSRWLockExclusive( lock );
 
-    status = RtlWaitOnAddress( &variable->Ptr, &value, sizeof(value), timeout );
+    status = wait_on_address( &variable->Ptr, &value, sizeof(value), timeout, TRUE );
 
     if (flags & RTL_CONDITION_VARIABLE_LOCKMODE_SHARED)
         RtlAcquireSRWLockShared( lock );
@@ -823,6 +949,14 @@ NTSTATUS WINAPI RtlSleepConditionVariableSRW( RTL_CONDITION_VARIABLE *variable,
  * NtWaitForAlertByThreadId, which manipulate a single flag (similar to an
  * auto-reset event) per thread. This can be tested by attempting to wake a
  * thread waiting in RtlWaitOnAddress() via NtAlertThreadByThreadId.
+ *
+ * Our own locks and condition variables wait on the address itself with host
+ * futexes instead where the host supports it, so that waking doesn't need one
+ * call per waiter. Such waits can't be interrupted by NtAlertThreadByThreadId,
+ * which is fine for internal waits that recheck their condition anyway, so
+ * RtlWaitOnAddress() itself always uses the queues below. They are also used
+ * for addresses the unix side can't handle. Wakers skip all the work when
+ * there are no waiters hashed to the same queue.
  */
 
 struct futex_entry
@@ -836,8 +970,11 @@ struct futex_queue
 {
     struct list queue;
     LONG lock;
+    LONG waiters;
 };
 
+static BOOL use_unix_futexes = TRUE;
+
 static struct futex_queue futex_queues[256];
 
 static struct futex_queue *get_futex_queue( const void *addr )
@@ -875,11 +1012,27 @@ static BOOL compare_addr( const void *addr, const void *cmp, SIZE_T size )
     return FALSE;
 }
 
-/***********************************************************************
- *           RtlWaitOnAddress   (NTDLL.@)
- */
-NTSTATUS WINAPI RtlWaitOnAddress( const void *addr, const void *cmp, SIZE_T size,
-                                  const LARGE_INTEGER *timeout )
+static BOOL has_futex_waiters( struct futex_queue *queue )
+{
+    /* order the caller's store to the address before reading the count */
+    MemoryBarrier();
+    return ReadNoFence( &queue->waiters ) != 0;
+}
+
+static void wake_unix_futex( const void *addr, BOOL all )
+{
+    struct wake_address_params params;
+
+    if (!use_unix_futexes) return;
+
+    params.addr = (ULONG_PTR)addr;
+    params.all  = all;
+    if (WINE_UNIX_CALL( unix_wake_address, &params ) == STATUS_NOT_IMPLEMENTED)
+        use_unix_futexes = FALSE;
+}
+
+static NTSTATUS wait_on_address( const void *addr, const void *cmp, SIZE_T size,
+                                 const LARGE_INTEGER *timeout, BOOL host_futex )
 {
     struct futex_queue *queue = get_futex_queue( addr );
     struct futex_entry entry;
@@ -890,6 +1043,36 @@ NTSTATUS WINAPI RtlWaitOnAddress( const void *addr, const void *cmp, SIZE_T size
     if (size != 1 && size != 2 && size != 4 && size != 8)
         return STATUS_INVALID_PARAMETER;
 
+    /* this must be visible to wakers before we look at the value */
+    InterlockedIncrement( &queue->waiters );
+
+    if (host_futex && use_unix_futexes)
+    {
+        struct wait_on_address_params params;
+
+        if (!compare_addr( addr, cmp, size ))
+        {
+            InterlockedDecrement( &queue->waiters );
+            return STATUS_SUCCESS;
+        }
+
+        params.addr     = (ULONG_PTR)addr;
+        params.value    = 0;
+        memcpy( &params.value, cmp, size );
+        params.size     = size;
+        params.infinite = !timeout;
+        params.timeout  = timeout ? timeout->QuadPart : 0;
+
+        ret = WINE_UNIX_CALL( unix_wait_on_address, &params );
+        if (ret == STATUS_NOT_IMPLEMENTED) use_unix_futexes = FALSE;
+        else if (ret != STATUS_NOT_SUPPORTED)
+        {
+            InterlockedDecrement( &queue->waiters );
+            TRACE("returning %#lx\n", ret);
+            return ret;
+        }
+    }
+
     entry.addr = addr;
     entry.tid = GetCurrentThreadId();
 
@@ -900,6 +1083,7 @@ NTSTATUS WINAPI RtlWaitOnAddress( const void *addr, const void *cmp, SIZE_T size
     if (!compare_addr( addr, cmp, size ))
     {
         spin_unlock( &queue->lock );
+        InterlockedDecrement( &queue->waiters );
         return STATUS_SUCCESS;
     }
 
@@ -916,6 +1100,7 @@ NTSTATUS WINAPI RtlWaitOnAddress( const void *addr, const void *cmp, SIZE_T size
     if (entry.addr)
         list_remove( &entry.entry );
     spin_unlock( &queue->lock );
+    InterlockedDecrement( &queue->waiters );
 
     TRACE("returning %#lx\n", ret);
 
@@ -923,6 +1108,15 @@ NTSTATUS WINAPI RtlWaitOnAddress( const void *addr, const void *cmp, SIZE_T size
     return ret;
 }
 
+/***********************************************************************
+ *           RtlWaitOnAddress   (NTDLL.@)
+ */
+NTSTATUS WINAPI RtlWaitOnAddress( const void *addr, const void *cmp, SIZE_T size,
+                                  const LARGE_INTEGER *timeout )
+{
+    return wait_on_address( addr, cmp, size, timeout, FALSE );
+}
+
 /***********************************************************************
  *           RtlWakeAddressAll    (NTDLL.@)
  */
@@ -935,7 +1129,9 @@ void WINAPI RtlWakeAddressAll( const void *addr )
 
     TRACE("%p\n", addr);
 
-    if (!addr) return;
+    if (!addr || !has_futex_waiters( queue )) return;
+
+    wake_unix_futex( addr, TRUE );
 
     spin_lock( &queue->lock );
 
@@ -972,7 +1168,11 @@ void WINAPI RtlWakeAddressSingle( const void *addr )
 
     TRACE("%p\n", addr);
 
-    if (!addr) return;
+    if (!addr || !has_futex_waiters( queue )) return;
+
+    /* if there are both host futex and queued waiters for this address, this
+     * may wake one of each, which is harmless */
+    wake_unix_futex( addr, FALSE );
 
     spin_lock( &queue->lock );
 
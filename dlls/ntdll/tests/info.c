@@ -1457,7 +1457,7 @@ static void test_query_logicalprocex(void)
 static void test_query_cpusetinfo(void)
 {
     SYSTEM_CPU_SET_INFORMATION *info;
-    unsigned int i, cpu_count;
+    unsigned int i, cpu_count, unparked;
     ULONG len, expected_len;
     NTSTATUS status;
     SYSTEM_INFO si;
@@ -1522,7 +1522,7 @@ static void test_query_cpusetinfo(void)
     ok(status == STATUS_SUCCESS, "Got unexpected status %#lx.\n", status);
     ok(len == expected_len, "Got unexpected length %lu.\n", len);
 
-    for (i = 0; i < cpu_count; ++i)
+    for (i = unparked = 0; i < cpu_count; ++i)
     {
         SYSTEM_CPU_SET_INFORMATION *d = &info[i];
 
@@ -1532,8 +1532,18 @@ static void test_query_cpusetinfo(void)
         ok(!d->CpuSet.Group, "Got unexpected Group %u, i %u.\n", d->CpuSet.Group, i);
         ok(d->CpuSet.LogicalProcessorIndex == i, "Got unexpected LogicalProcessorIndex %u, i %u.\n",
                 d->CpuSet.LogicalProcessorIndex, i);
-        ok(!d->CpuSet.AllFlags, "Got unexpected AllFlags %#x, i %u.\n", d->CpuSet.AllFlags, i);
+        /* parked CPUs are reported for container limits on Linux and core parking on Windows */
+        ok(!(d->CpuSet.AllFlags & ~1), "Got unexpected AllFlags %#x, i %u.\n", d->CpuSet.AllFlags, i);
+        if (!d->CpuSet.Parked) ++unparked;
     }
+    ok(unparked, "All CPUs are parked.\n");
+
+    /* the result is cached, a second query returns the same data */
+    memset(info, 0xcc, expected_len);
+    status = pNtQuerySystemInformationEx(SystemCpuSetInformation, &process, sizeof(process), info, expected_len, &len);
+    ok(status == STATUS_SUCCESS, "Got unexpected status %#lx.\n", status);
+    for (i = 0; i < cpu_count; ++i)
+        ok(info[i].CpuSet.Id == 0x100 + i, "Got unexpected Id %#lx, i %u.\n", info[i].CpuSet.Id, i);
     free(info);
 }
 
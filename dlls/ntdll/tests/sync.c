@@ -192,6 +192,102 @@ static DWORD WINAPI keyed_event_thread( void *arg )
     return 0;
 }
 
+static DWORD WINAPI default_keyed_event_thread( void *arg )
+{
+    LONG count = PtrToLong( arg );
+    NTSTATUS status;
+    LONG i;
+
+    for (i = 0; i < count; i++)
+    {
+        status = pNtWaitForKeyedEvent( NULL, (void *)0x100, 0, NULL );
+        ok( status == STATUS_SUCCESS, "%ld: NtWaitForKeyedEvent %lx\n", i, status );
+        status = pNtReleaseKeyedEvent( NULL, (void *)0x200, 0, NULL );
+        ok( status == STATUS_SUCCESS, "%ld: NtReleaseKeyedEvent %lx\n", i, status );
+    }
+    return 0;
+}
+
+static void CALLBACK keyed_event_apc( ULONG_PTR arg )
+{
+    *(BOOL *)arg = TRUE;
+}
+
+static HANDLE keyed_event_apc_done;
+
+static DWORD WINAPI alertable_keyed_event_thread( void *arg )
+{
+    NTSTATUS status;
+
+    /* the APC is queued by the main thread while we wait */
+    status = pNtWaitForKeyedEvent( NULL, (void *)0x300, TRUE, NULL );
+    ok( status == STATUS_USER_APC, "NtWaitForKeyedEvent %lx\n", status );
+    ok( *(BOOL *)arg, "APC not called\n" );
+    SetEvent( keyed_event_apc_done );
+
+    status = pNtWaitForKeyedEvent( NULL, (void *)0x300, TRUE, NULL );
+    ok( status == STATUS_SUCCESS, "NtWaitForKeyedEvent %lx\n", status );
+    return 0;
+}
+
+static void test_default_keyed_event(void)
+{
+    static const LONG count = 1000;
+    LARGE_INTEGER timeout;
+    BOOL apc_called = FALSE;
+    NTSTATUS status;
+    HANDLE thread;
+    LONG i;
+
+    if (!pNtWaitForKeyedEvent)
+    {
+        win_skip( "Keyed events not supported\n" );
+        return;
+    }
+
+    timeout.QuadPart = 0;
+    status = pNtWaitForKeyedEvent( NULL, (void *)0x100, 0, &timeout );
+    ok( status == STATUS_TIMEOUT, "NtWaitForKeyedEvent %lx\n", status );
+    status = pNtReleaseKeyedEvent( NULL, (void *)0x100, 0, &timeout );
+    ok( status == STATUS_TIMEOUT, "NtReleaseKeyedEvent %lx\n", status );
+
+    timeout.QuadPart = -10000;
+    QueueUserAPC( keyed_event_apc, GetCurrentThread(), (ULONG_PTR)&apc_called );
+    status = pNtWaitForKeyedEvent( NULL, (void *)0x100, TRUE, &timeout );
+    ok( status == STATUS_USER_APC, "NtWaitForKeyedEvent %lx\n", status );
+    ok( apc_called, "APC not called\n" );
+    status = pNtWaitForKeyedEvent( NULL, (void *)0x100, TRUE, &timeout );
+    ok( status == STATUS_TIMEOUT, "NtWaitForKeyedEvent %lx\n", status );
+
+    thread = CreateThread( NULL, 0, default_keyed_event_thread, LongToPtr( count ), 0, NULL );
+    for (i = 0; i < count; i++)
+    {
+        status = pNtReleaseKeyedEvent( NULL, (void *)0x100, 0, NULL );
+        ok( status == STATUS_SUCCESS, "%ld: NtReleaseKeyedEvent %lx\n", i, status );
+        status = pNtWaitForKeyedEvent( NULL, (void *)0x200, 0, NULL );
+        ok( status == STATUS_SUCCESS, "%ld: NtWaitForKeyedEvent %lx\n", i, status );
+    }
+    ok( WaitForSingleObject( thread, 30000 ) == 0, "wait failed\n" );
+    CloseHandle( thread );
+
+    /* alertable waits without a timeout still get user APCs, and can be paired */
+    apc_called = FALSE;
+    keyed_event_apc_done = CreateEventW( NULL, FALSE, FALSE, NULL );
+    thread = CreateThread( NULL, 0, alertable_keyed_event_thread, &apc_called, 0, NULL );
+    ok( WaitForSingleObject( thread, 100 ) == WAIT_TIMEOUT, "thread exited\n" );
+    QueueUserAPC( keyed_event_apc, thread, (ULONG_PTR)&apc_called );
+    ok( !WaitForSingleObject( keyed_event_apc_done, 1000 ), "wait failed\n" );
+    status = pNtReleaseKeyedEvent( NULL, (void *)0x300, 0, NULL );
+    ok( status == STATUS_SUCCESS, "NtReleaseKeyedEvent %lx\n", status );
+    ok( WaitForSingleObject( thread, 1000 ) == 0, "wait failed\n" );
+    CloseHandle( thread );
+    CloseHandle( keyed_event_apc_done );
+
+    timeout.QuadPart = -100000;
+    status = pNtWaitForKeyedEvent( NULL, (void *)0x100, 0, &timeout );
+    ok( status == STATUS_TIMEOUT, "NtWaitForKeyedEvent %lx\n", status );
+}
+
 static void test_keyed_events(void)
 {
     OBJECT_ATTRIBUTES attr;
@@ -603,6 +699,129 @@ static void test_wait_on_address(void)
     ok(address == 0, "got %s\n", wine_dbgstr_longlong(address));
 }
 
+static BYTE wait_bytes[8];
+
+static DWORD WINAPI wait_byte_thread(void *arg)
+{
+    BYTE *addr = arg, compare = 0;
+    NTSTATUS status;
+
+    while (*addr == compare)
+    {
+        status = pRtlWaitOnAddress(addr, &compare, 1, NULL);
+        ok(!status, "got 0x%08lx\n", status);
+    }
+    return 0;
+}
+
+static void test_wait_on_address_sharing(void)
+{
+    HANDLE threads[4];
+    unsigned int i;
+    DWORD ret;
+
+    if (!pRtlWaitOnAddress)
+    {
+        win_skip("RtlWaitOnAddress not supported, skipping test\n");
+        return;
+    }
+
+    /* waiters on neighbouring bytes are independent */
+    memset(wait_bytes, 0, sizeof(wait_bytes));
+    threads[0] = CreateThread(NULL, 0, wait_byte_thread, &wait_bytes[0], 0, NULL);
+    threads[1] = CreateThread(NULL, 0, wait_byte_thread, &wait_bytes[1], 0, NULL);
+    Sleep(100);
+
+    wait_bytes[1] = 1;
+    pRtlWakeAddressSingle(&wait_bytes[1]);
+    ret = WaitForSingleObject(threads[1], 1000);
+    ok(!ret, "got %lu\n", ret);
+    ret = WaitForSingleObject(threads[0], 100);
+    ok(ret == WAIT_TIMEOUT, "got %lu\n", ret);
+
+    wait_bytes[0] = 1;
+    pRtlWakeAddressSingle(&wait_bytes[0]);
+    ret = WaitForSingleObject(threads[0], 1000);
+    ok(!ret, "got %lu\n", ret);
+    CloseHandle(threads[0]);
+    CloseHandle(threads[1]);
+
+    /* wake all */
+    memset(wait_bytes, 0, sizeof(wait_bytes));
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+        threads[i] = CreateThread(NULL, 0, wait_byte_thread, &wait_bytes[2], 0, NULL);
+    Sleep(100);
+
+    wait_bytes[2] = 1;
+    pRtlWakeAddressAll(&wait_bytes[2]);
+    ret = WaitForMultipleObjects(ARRAY_SIZE(threads), threads, TRUE, 1000);
+    ok(!ret, "got %lu\n", ret);
+    for (i = 0; i < ARRAY_SIZE(threads); i++) CloseHandle(threads[i]);
+}
+
+#define CONTENTION_THREADS    4
+#define CONTENTION_ITERATIONS 20000
+
+static SRWLOCK contention_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE contention_cv = CONDITION_VARIABLE_INIT;
+static LONG contention_counter, contention_turn;
+
+static DWORD WINAPI srw_contention_thread(void *arg)
+{
+    unsigned int i;
+
+    for (i = 0; i < CONTENTION_ITERATIONS; i++)
+    {
+        AcquireSRWLockExclusive(&contention_lock);
+        contention_counter++;
+        ReleaseSRWLockExclusive(&contention_lock);
+    }
+    return 0;
+}
+
+static DWORD WINAPI cv_contention_thread(void *arg)
+{
+    LONG id = (LONG_PTR)arg;
+    unsigned int i;
+
+    /* threads take turns, so every iteration wakes all of them */
+    for (i = 0; i < CONTENTION_ITERATIONS / 10; i++)
+    {
+        AcquireSRWLockExclusive(&contention_lock);
+        while (contention_turn % CONTENTION_THREADS != id)
+            SleepConditionVariableSRW(&contention_cv, &contention_lock, INFINITE, 0);
+        contention_turn++;
+        contention_counter++;
+        ReleaseSRWLockExclusive(&contention_lock);
+        WakeAllConditionVariable(&contention_cv);
+    }
+    return 0;
+}
+
+static void test_lock_contention(void)
+{
+    HANDLE threads[CONTENTION_THREADS];
+    unsigned int i;
+    DWORD ret;
+
+    contention_counter = 0;
+    for (i = 0; i < CONTENTION_THREADS; i++)
+        threads[i] = CreateThread(NULL, 0, srw_contention_thread, NULL, 0, NULL);
+    ret = WaitForMultipleObjects(CONTENTION_THREADS, threads, TRUE, 30000);
+    ok(!ret, "got %lu\n", ret);
+    for (i = 0; i < CONTENTION_THREADS; i++) CloseHandle(threads[i]);
+    ok(contention_counter == CONTENTION_THREADS * CONTENTION_ITERATIONS, "got %ld\n", contention_counter);
+
+    contention_counter = contention_turn = 0;
+    for (i = 0; i < CONTENTION_THREADS; i++)
+        threads[i] = CreateThread(NULL, 0, cv_contention_thread, (void *)(LONG_PTR)i, 0, NULL);
+    ret = WaitForMultipleObjects(CONTENTION_THREADS, threads, TRUE, 30000);
+    ok(!ret, "got %lu\n", ret);
+    for (i = 0; i < CONTENTION_THREADS; i++) CloseHandle(threads[i]);
+    ok(contention_counter == CONTENTION_THREADS * (CONTENTION_ITERATIONS / 10), "got %ld\n", contention_counter);
+    ok(contention_turn == contention_counter, "got %ld\n", contention_turn);
+}
+
 static HANDLE thread_ready, thread_done;
 
 static DWORD WINAPI resource_shared_thread(void *arg)
@@ -769,6 +988,19 @@ static DWORD WINAPI tid_alert_thread( void *arg )
     return 0;
 }
 
+static LONG tid_alert_address;
+
+static DWORD WINAPI tid_alert_wait_thread( void *arg )
+{
+    LONG compare = 0;
+    NTSTATUS ret;
+
+    ret = pRtlWaitOnAddress( &tid_alert_address, &compare, sizeof(compare), NULL );
+    ok(!ret, "got %#lx\n", ret);
+    ok(!tid_alert_address, "got %ld\n", tid_alert_address);
+    return 0;
+}
+
 static void test_tid_alert( char **argv )
 {
     LARGE_INTEGER timeout = {{0}};
@@ -827,6 +1059,20 @@ static void test_tid_alert( char **argv )
 
     CloseHandle(thread);
 
+    if (pRtlWaitOnAddress)
+    {
+        /* RtlWaitOnAddress() returns when the thread is alerted, even if the
+         * value didn't change */
+        thread = CreateThread( NULL, 0, tid_alert_wait_thread, NULL, 0, &tid );
+        ret = WaitForSingleObject( thread, 100 );
+        ok(ret == WAIT_TIMEOUT, "got %ld\n", ret);
+        ret = pNtAlertThreadByThreadId( (HANDLE)(DWORD_PTR)tid );
+        ok(!ret, "got %#lx\n", ret);
+        ret = WaitForSingleObject( thread, 1000 );
+        ok(!ret, "got %ld\n", ret);
+        CloseHandle(thread);
+    }
+
     sprintf( cmdline, "%s %s subprocess", argv[0], argv[1] );
     ret = CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
     ok(ret, "failed to create process, error %lu\n", GetLastError());
@@ -878,10 +1124,13 @@ START_TEST(sync)
     pRtlWakeAddressSingle           = (void *)GetProcAddress(module, "RtlWakeAddressSingle");
 
     test_wait_on_address();
+    test_wait_on_address_sharing();
+    test_lock_contention();
     test_event();
     test_mutant();
     test_semaphore();
     test_keyed_events();
+    test_default_keyed_event();
     test_resource();
     test_tid_alert( argv );
 }
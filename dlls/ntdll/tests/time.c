@@ -125,6 +125,36 @@ static void test_NtQueryPerformanceCounter(void)
     ok(status == STATUS_SUCCESS, "expected STATUS_SUCCESS, got %08lx\n", status);
 }
 
+static void test_performance_counter_order(void)
+{
+    LARGE_INTEGER frequency, nt_frequency, nt_counter, rtl_counter, prev;
+    unsigned int i;
+
+    if (!pRtlQueryPerformanceCounter || !pRtlQueryPerformanceFrequency)
+    {
+        win_skip( "RtlQueryPerformanceCounter/Frequency not available, skipping tests\n" );
+        return;
+    }
+
+    pRtlQueryPerformanceFrequency( &frequency );
+    pNtQueryPerformanceCounter( &prev, &nt_frequency );
+    ok( frequency.QuadPart == nt_frequency.QuadPart, "got frequency %I64d, expected %I64d\n",
+        frequency.QuadPart, nt_frequency.QuadPart );
+
+    /* both functions read the same counter */
+    for (i = 0; i < 1000; i++)
+    {
+        pRtlQueryPerformanceCounter( &rtl_counter );
+        ok( rtl_counter.QuadPart >= prev.QuadPart, "%u: counter went backwards, %I64d < %I64d\n",
+            i, rtl_counter.QuadPart, prev.QuadPart );
+        pNtQueryPerformanceCounter( &nt_counter, NULL );
+        ok( nt_counter.QuadPart >= rtl_counter.QuadPart, "%u: counter went backwards, %I64d < %I64d\n",
+            i, nt_counter.QuadPart, rtl_counter.QuadPart );
+        if (rtl_counter.QuadPart < prev.QuadPart || nt_counter.QuadPart < rtl_counter.QuadPart) break;
+        prev = nt_counter;
+    }
+}
+
 #if defined(__i386__) || defined(__x86_64__)
 
 struct hypervisor_shared_data
@@ -492,6 +522,7 @@ START_TEST(time)
     else
         win_skip("Required time conversion functions are not available\n");
     test_NtQueryPerformanceCounter();
+    test_performance_counter_order();
     test_RtlQueryTimeZoneInformation();
     test_user_shared_data_time();
 #if defined(__i386__) || defined(__x86_64__)
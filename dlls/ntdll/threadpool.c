@@ -102,6 +102,7 @@ struct timer_queue
 /* internal threadpool representation */
 struct threadpool
 {
+    struct list             entry;
     LONG                    refcount;
     LONG                    objcount;
     BOOL                    shutdown;
@@ -368,6 +369,10 @@ static void tp_object_prepare_shutdown( struct threadpool_object *object );
 static BOOL tp_object_release( struct threadpool_object *object );
 static struct threadpool *default_threadpool = NULL;
 
+/* list of all thread pools, for statistics */
+static struct list threadpools = LIST_INIT( threadpools );
+static RTL_SRWLOCK threadpools_lock = RTL_SRWLOCK_INIT;
+
 static BOOL array_reserve(void **elements, unsigned int *capacity, unsigned int count, unsigned int size)
 {
     unsigned int new_capacity, max_capacity;
@@ -1689,6 +1694,10 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     pool->stack_info.StackReserve = nt->OptionalHeader.SizeOfStackReserve;
     pool->stack_info.StackCommit  = nt->OptionalHeader.SizeOfStackCommit;
 
+    RtlAcquireSRWLockExclusive( &threadpools_lock );
+    list_add_tail( &threadpools, &pool->entry );
+    RtlReleaseSRWLockExclusive( &threadpools_lock );
+
     TRACE( "allocated threadpool %p\n", pool );
 
     *out = pool;
@@ -1729,6 +1738,10 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
     for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
         assert( list_empty( &pool->pools[i] ) );
 
+    RtlAcquireSRWLockExclusive( &threadpools_lock );
+    list_remove( &pool->entry );
+    RtlReleaseSRWLockExclusive( &threadpools_lock );
+
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
 
@@ -3355,3 +3368,29 @@ NTSTATUS WINAPI RtlDeregisterWait(HANDLE WaitHandle)
 {
     return RtlDeregisterWaitEx(WaitHandle, NULL);
 }
+
+/***********************************************************************
+ *           threadpool_get_stats
+ *
+ * Fill the thread pool part of the runtime statistics.
+ */
+void threadpool_get_stats( struct wine_runtime_stats *stats )
+{
+    struct threadpool_object *object;
+    struct threadpool *pool;
+    unsigned int i;
+
+    RtlAcquireSRWLockShared( &threadpools_lock );
+    LIST_FOR_EACH_ENTRY( pool, &threadpools, struct threadpool, entry )
+    {
+        RtlEnterCriticalSection( &pool->cs );
+        stats->threadpool_count++;
+        stats->threadpool_workers += pool->num_workers;
+        stats->threadpool_busy_workers += pool->num_busy_workers;
+        for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+            LIST_FOR_EACH_ENTRY( object, &pool->pools[i], struct threadpool_object, pool_entry )
+                stats->threadpool_queued += object->num_pending_callbacks;
+        RtlLeaveCriticalSection( &pool->cs );
+    }
+    RtlReleaseSRWLockShared( &threadpools_lock );
+}
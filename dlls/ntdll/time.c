@@ -382,7 +382,9 @@ LONGLONG WINAPI RtlGetSystemTimePrecise( void )
  */
 BOOL WINAPI DECLSPEC_HOTPATCH RtlQueryPerformanceCounter( LARGE_INTEGER *counter )
 {
-    NtQueryPerformanceCounter( counter, NULL );
+    ULONG64 args[] = { (ULONG_PTR)counter, 0 };
+
+    WINE_UNIX_CALL( unix_fast_NtQueryPerformanceCounter, args );
     return TRUE;
 }
 
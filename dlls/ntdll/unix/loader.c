@@ -27,6 +27,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <signal.h>
@@ -93,6 +94,7 @@ extern char **environ;
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(module);
+WINE_DECLARE_DEBUG_CHANNEL(syscallstats);
 
 #ifdef __i386__
 static const char so_dir[] = "/i386-unix";
@@ -138,6 +140,17 @@ static BYTE syscall_args[ARRAY_SIZE(syscalls)] =
 #undef SYSCALL_ENTRY
 };
 
+static const char * const syscall_names[ARRAY_SIZE(syscalls)] =
+{
+#define SYSCALL_ENTRY(id,name,args) #name,
+#ifdef _WIN64
+    ALL_SYSCALLS64
+#else
+    ALL_SYSCALLS32
+#endif
+#undef SYSCALL_ENTRY
+};
+
 SYSTEM_SERVICE_TABLE KeServiceDescriptorTable[4] =
 {
     { (ULONG_PTR *)syscalls, NULL, ARRAY_SIZE(syscalls), syscall_args }
@@ -640,6 +653,240 @@ BOOLEAN KeAddSystemServiceTable( ULONG_PTR *funcs, ULONG_PTR *counters, ULONG li
 }
 
 
+/***********************************************************************
+ * Syscall statistics
+ *
+ * With WINEDEBUG=+syscallstats, the syscall dispatcher times every call
+ * and reports it to record_syscall_stats(). Each thread accumulates its
+ * counters in its own buffer without any locking; buffers of exited
+ * threads are folded into a common one. When the channel is disabled the
+ * dispatcher never calls in here.
+ */
+
+#define SYSCALL_STATS_BUCKETS 16
+
+struct syscall_stats
+{
+    ULONG64 calls;
+    ULONG64 time;                         /* total time in ticks */
+    ULONG   hist[SYSCALL_STATS_BUCKETS];  /* bucket n counts calls shorter than 2^n us */
+};
+
+struct thread_syscall_stats
+{
+    struct list           entry;
+    DWORD                 tid;
+    ULONG                 limit[ARRAY_SIZE(KeServiceDescriptorTable)];
+    struct syscall_stats *tables[ARRAY_SIZE(KeServiceDescriptorTable)];
+};
+
+static struct list syscall_stats_threads = LIST_INIT( syscall_stats_threads );
+static struct thread_syscall_stats syscall_stats_exited;
+static pthread_mutex_t syscall_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ULONG64 syscall_stats_freq;  /* ticks per microsecond */
+
+/***********************************************************************
+ *           init_syscall_stats
+ *
+ * Called by the platform code when it enables the instrumented dispatcher.
+ */
+void init_syscall_stats( ULONG64 frequency )
+{
+    syscall_stats_freq = max( frequency / 1000000, 1 );
+}
+
+static struct thread_syscall_stats *alloc_thread_syscall_stats(void)
+{
+    struct thread_syscall_stats *thread_stats;
+
+    if (!(thread_stats = calloc( 1, sizeof(*thread_stats) ))) return NULL;
+    thread_stats->tid = HandleToULong( NtCurrentTeb()->ClientId.UniqueThread );
+    pthread_mutex_lock( &syscall_stats_mutex );
+    list_add_tail( &syscall_stats_threads, &thread_stats->entry );
+    pthread_mutex_unlock( &syscall_stats_mutex );
+    ntdll_get_thread_data()->syscall_stats = thread_stats;
+    return thread_stats;
+}
+
+/***********************************************************************
+ *           record_syscall_stats
+ *
+ * Called from the syscall dispatcher after each system call.
+ */
+void record_syscall_stats( const SYSTEM_SERVICE_TABLE *table, ULONG id, ULONG64 ticks )
+{
+    struct thread_syscall_stats *thread_stats = ntdll_get_thread_data()->syscall_stats;
+    unsigned int index = table - KeServiceDescriptorTable, bucket = 0;
+    ULONG64 usecs = ticks / syscall_stats_freq;
+    struct syscall_stats *stats;
+
+    if (index >= ARRAY_SIZE(KeServiceDescriptorTable)) return;
+    if (!thread_stats && !(thread_stats = alloc_thread_syscall_stats())) return;
+    if (!(stats = thread_stats->tables[index]))
+    {
+        if (!(stats = calloc( table->ServiceLimit, sizeof(*stats) ))) return;
+        thread_stats->limit[index] = table->ServiceLimit;
+        thread_stats->tables[index] = stats;
+    }
+    if (id >= thread_stats->limit[index]) return;
+
+    while (bucket < SYSCALL_STATS_BUCKETS - 1 && usecs >> bucket) bucket++;
+    stats[id].calls++;
+    stats[id].time += ticks;
+    stats[id].hist[bucket]++;
+}
+
+static void add_syscall_stats( struct thread_syscall_stats *dst, const struct thread_syscall_stats *src )
+{
+    unsigned int i, j, k;
+
+    for (i = 0; i < ARRAY_SIZE(src->tables); i++)
+    {
+        if (!src->tables[i]) continue;
+        if (!dst->tables[i])
+        {
+            if (!(dst->tables[i] = calloc( src->limit[i], sizeof(*dst->tables[i]) ))) continue;
+            dst->limit[i] = src->limit[i];
+        }
+        for (j = 0; j < min( src->limit[i], dst->limit[i] ); j++)
+        {
+            dst->tables[i][j].calls += src->tables[i][j].calls;
+            dst->tables[i][j].time += src->tables[i][j].time;
+            for (k = 0; k < SYSCALL_STATS_BUCKETS; k++)
+                dst->tables[i][j].hist[k] += src->tables[i][j].hist[k];
+        }
+    }
+}
+
+static void get_syscall_stats_totals( const struct thread_syscall_stats *thread_stats,
+                                      ULONG64 *calls, ULONG64 *time )
+{
+    unsigned int i, j;
+
+    *calls = *time = 0;
+    for (i = 0; i < ARRAY_SIZE(thread_stats->tables); i++)
+    {
+        if (!thread_stats->tables[i]) continue;
+        for (j = 0; j < thread_stats->limit[i]; j++)
+        {
+            *calls += thread_stats->tables[i][j].calls;
+            *time += thread_stats->tables[i][j].time;
+        }
+    }
+}
+
+/***********************************************************************
+ *           free_syscall_stats
+ *
+ * Fold the statistics of an exited thread into the common buffer.
+ */
+void free_syscall_stats( struct ntdll_thread_data *thread_data )
+{
+    struct thread_syscall_stats *thread_stats = thread_data->syscall_stats;
+    unsigned int i;
+
+    if (!thread_stats) return;
+    thread_data->syscall_stats = NULL;
+
+    pthread_mutex_lock( &syscall_stats_mutex );
+    list_remove( &thread_stats->entry );
+    add_syscall_stats( &syscall_stats_exited, thread_stats );
+    pthread_mutex_unlock( &syscall_stats_mutex );
+
+    for (i = 0; i < ARRAY_SIZE(thread_stats->tables); i++) free( thread_stats->tables[i] );
+    free( thread_stats );
+}
+
+struct syscall_stats_entry
+{
+    const struct syscall_stats *stats;
+    unsigned int                index;
+    unsigned int                id;
+};
+
+static int compare_syscall_stats( const void *a, const void *b )
+{
+    const struct syscall_stats_entry *entry1 = a, *entry2 = b;
+
+    if (entry1->stats->time == entry2->stats->time) return 0;
+    return entry1->stats->time < entry2->stats->time ? 1 : -1;
+}
+
+/***********************************************************************
+ *           dump_syscall_stats
+ *
+ * Dump the syscall statistics collected so far, per thread and per
+ * syscall ordered by total time. Times are in microseconds.
+ */
+NTSTATUS dump_syscall_stats( void *args )
+{
+    struct thread_syscall_stats total, *thread_stats;
+    struct syscall_stats_entry *entries;
+    unsigned int i, j, k, count = 0, max = 0;
+    ULONG64 calls, time;
+
+    if (!TRACE_ON(syscallstats) || !syscall_stats_freq) return STATUS_SUCCESS;
+
+    memset( &total, 0, sizeof(total) );
+    pthread_mutex_lock( &syscall_stats_mutex );
+    LIST_FOR_EACH_ENTRY( thread_stats, &syscall_stats_threads, struct thread_syscall_stats, entry )
+    {
+        get_syscall_stats_totals( thread_stats, &calls, &time );
+        TRACE_(syscallstats)( "thread %04x calls %llu time %llu\n", (UINT)thread_stats->tid,
+                              (unsigned long long)calls, (unsigned long long)(time / syscall_stats_freq) );
+        add_syscall_stats( &total, thread_stats );
+    }
+    get_syscall_stats_totals( &syscall_stats_exited, &calls, &time );
+    if (calls) TRACE_(syscallstats)( "exited threads calls %llu time %llu\n", (unsigned long long)calls,
+                                     (unsigned long long)(time / syscall_stats_freq) );
+    add_syscall_stats( &total, &syscall_stats_exited );
+    pthread_mutex_unlock( &syscall_stats_mutex );
+
+    for (i = 0; i < ARRAY_SIZE(total.tables); i++)
+        if (total.tables[i]) for (j = 0; j < total.limit[i]; j++) if (total.tables[i][j].calls) max++;
+
+    if (max && (entries = malloc( max * sizeof(*entries) )))
+    {
+        for (i = 0; i < ARRAY_SIZE(total.tables); i++)
+        {
+            if (!total.tables[i]) continue;
+            for (j = 0; j < total.limit[i]; j++)
+            {
+                if (!total.tables[i][j].calls) continue;
+                entries[count].stats = &total.tables[i][j];
+                entries[count].index = i;
+                entries[count].id = j;
+                count++;
+            }
+        }
+        qsort( entries, count, sizeof(*entries), compare_syscall_stats );
+
+        TRACE_(syscallstats)( "%u syscalls used\n", count );
+        for (i = 0; i < count; i++)
+        {
+            const struct syscall_stats *stats = entries[i].stats;
+            char buffer[SYSCALL_STATS_BUCKETS * 12], *p = buffer;
+            const char *name;
+
+            for (k = 0; k < SYSCALL_STATS_BUCKETS; k++)
+                p += sprintf( p, k ? ",%u" : "%u", (UINT)stats->hist[k] );
+
+            if (!entries[i].index && entries[i].id < ARRAY_SIZE(syscall_names))
+                name = syscall_names[entries[i].id];
+            else
+                name = wine_dbg_sprintf( "%04x", (entries[i].index << 12) | entries[i].id );
+
+            TRACE_(syscallstats)( "%s calls %llu time %llu hist %s\n", name, (unsigned long long)stats->calls,
+                                  (unsigned long long)(stats->time / syscall_stats_freq), buffer );
+        }
+        free( entries );
+    }
+
+    for (i = 0; i < ARRAY_SIZE(total.tables); i++) free( total.tables[i] );
+    return STATUS_SUCCESS;
+}
+
+
 /*************************************************************************
  *		map_so_dll
  *
@@ -973,6 +1220,17 @@ static NTSTATUS load_so_dll( void *args )
 }
 
 
+/* entry points for ALL_FAST_SYSCALLS */
+#define FAST_SYSCALL_ARG(n) (void *)(ULONG_PTR)((const ULONG64 *)params)[n]
+#define FAST_SYSCALL_ARGS0
+#define FAST_SYSCALL_ARGS1 FAST_SYSCALL_ARG(0)
+#define FAST_SYSCALL_ARGS2 FAST_SYSCALL_ARGS1, FAST_SYSCALL_ARG(1)
+#define FAST_SYSCALL(name,args) \
+    static NTSTATUS fast_##name( void *params ) { return name( FAST_SYSCALL_ARGS##args ); }
+ALL_FAST_SYSCALLS
+#undef FAST_SYSCALL
+
+
 static const unixlib_entry_t unix_call_funcs[] =
 {
     load_so_dll,
@@ -983,6 +1241,13 @@ static const unixlib_entry_t unix_call_funcs[] =
     unixcall_wine_server_handle_to_fd,
     unixcall_wine_spawnvp,
     system_time_precise,
+    wait_on_address,
+    wake_address,
+    get_runtime_stats,
+    dump_syscall_stats,
+#define FAST_SYSCALL(name,args) fast_##name,
+    ALL_FAST_SYSCALLS
+#undef FAST_SYSCALL
 };
 
 
@@ -1001,6 +1266,13 @@ const unixlib_entry_t unix_call_wow64_funcs[] =
     wow64_wine_server_handle_to_fd,
     wow64_wine_spawnvp,
     system_time_precise,
+    wait_on_address,
+    wake_address,
+    get_runtime_stats,
+    dump_syscall_stats,
+#define FAST_SYSCALL(name,args) fast_##name,
+    ALL_FAST_SYSCALLS
+#undef FAST_SYSCALL
 };
 
 #endif  /* _WIN64 */
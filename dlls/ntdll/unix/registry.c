@@ -25,8 +25,12 @@
 #pragma makedep unix
 #endif
 
+#include <pthread.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -40,6 +44,164 @@ WINE_DEFAULT_DEBUG_CHANNEL(reg);
 #define MAX_VALUE_LENGTH (16383 * sizeof(WCHAR))
 
 
+/* Value cache, enabled per process with WINEREGCACHE=machine,user. The
+ * server returns the index and current value of a change serial with each
+ * queried value, and bumps that serial in a shared mapping whenever the key
+ * is modified, so a cached value can be validated without a server call. */
+
+#define REG_CACHE_SIZE     256   /* number of cached values */
+#define REG_CACHE_MAX_NAME 64    /* longer value names are not cached */
+#define REG_CACHE_MAX_DATA 1024  /* larger values are not cached */
+
+struct reg_cache_entry
+{
+    HANDLE       key;
+    unsigned int serial_index;
+    unsigned int serial;
+    unsigned int status;  /* STATUS_SUCCESS or STATUS_OBJECT_NAME_NOT_FOUND */
+    int          type;
+    data_size_t  total;
+    USHORT       name_len;
+    WCHAR        name[REG_CACHE_MAX_NAME];  /* upper-cased */
+    BYTE         data[REG_CACHE_MAX_DATA];
+};
+
+static pthread_mutex_t reg_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct reg_cache_entry *reg_cache;
+static const volatile unsigned int *reg_serials;
+static int reg_cache_hives = -1;
+
+static BOOL map_registry_serials(void)
+{
+    static const WCHAR nameW[] = {'\\','K','e','r','n','e','l','O','b','j','e','c','t','s',
+                                  '\\','_','_','w','i','n','e','_','r','e','g','i','s','t','r','y','_','s','e','r','i','a','l','s',0};
+    UNICODE_STRING name_str = RTL_CONSTANT_STRING( nameW );
+    OBJECT_ATTRIBUTES attr = { sizeof(attr), 0, &name_str };
+    HANDLE section;
+    void *ptr = MAP_FAILED;
+    int fd, needs_close;
+
+    if (NtOpenSection( &section, SECTION_MAP_READ, &attr )) return FALSE;
+    if (!server_get_unix_fd( section, 0, &fd, &needs_close, NULL, NULL ))
+    {
+        ptr = mmap( NULL, REG_SERIAL_COUNT * sizeof(*reg_serials), PROT_READ, MAP_SHARED, fd, 0 );
+        if (needs_close) close( fd );
+    }
+    NtClose( section );
+    if (ptr == MAP_FAILED) return FALSE;
+    reg_serials = ptr;
+    return TRUE;
+}
+
+/* reg_cache_mutex must be held */
+static unsigned int get_reg_cache_hives(void)
+{
+    if (reg_cache_hives == -1)
+    {
+        const char *str = getenv( "WINEREGCACHE" );
+        unsigned int hives = 0;
+
+        if (str && strstr( str, "machine" )) hives |= REG_CACHE_MACHINE;
+        if (str && strstr( str, "user" )) hives |= REG_CACHE_USER;
+        if (hives && (!map_registry_serials() || !(reg_cache = calloc( REG_CACHE_SIZE, sizeof(*reg_cache) ))))
+            hives = 0;
+        if (hives) TRACE( "caching values for hives %x\n", hives );
+        reg_cache_hives = hives;
+    }
+    return reg_cache_hives;
+}
+
+static BOOL get_reg_cache_name( const UNICODE_STRING *name, WCHAR *buffer, unsigned int *hash )
+{
+    unsigned int i, len = name->Length / sizeof(WCHAR);
+
+    if (len > REG_CACHE_MAX_NAME) return FALSE;
+    for (i = 0; i < len; i++)
+    {
+        buffer[i] = ntdll_towupper( name->Buffer[i] );
+        *hash = *hash * 31 + buffer[i];
+    }
+    return TRUE;
+}
+
+/* reg_cache_mutex must be held */
+static struct reg_cache_entry *get_reg_cache_entry( HANDLE key, const UNICODE_STRING *name, WCHAR *buffer )
+{
+    unsigned int hash = HandleToULong( key );
+
+    if (!get_reg_cache_name( name, buffer, &hash )) return NULL;
+    return &reg_cache[hash % REG_CACHE_SIZE];
+}
+
+/* look up a value in the cache, returns FALSE if it needs to be queried from the server */
+static BOOL get_cached_value( HANDLE key, const UNICODE_STRING *name, void *data, data_size_t size,
+                              int *type, data_size_t *total, unsigned int *status )
+{
+    WCHAR buffer[REG_CACHE_MAX_NAME];
+    struct reg_cache_entry *entry;
+    BOOL ret = FALSE;
+
+    pthread_mutex_lock( &reg_cache_mutex );
+    if (get_reg_cache_hives() && (entry = get_reg_cache_entry( key, name, buffer )) &&
+        entry->key == key && entry->name_len == name->Length &&
+        !memcmp( entry->name, buffer, name->Length ) &&
+        reg_serials[entry->serial_index] == entry->serial)
+    {
+        *type = entry->type;
+        *total = entry->total;
+        *status = entry->status;
+        if (data) memcpy( data, entry->data, min( size, entry->total ));
+        ret = TRUE;
+    }
+    pthread_mutex_unlock( &reg_cache_mutex );
+    return ret;
+}
+
+/* store a value returned by the server in the cache */
+static void cache_value( HANDLE key, const UNICODE_STRING *name, const void *data, data_size_t size,
+                         int type, data_size_t total, unsigned int status,
+                         unsigned int serial_index, unsigned int serial )
+{
+    WCHAR buffer[REG_CACHE_MAX_NAME];
+    struct reg_cache_entry *entry;
+
+    if (!serial_index || serial_index >= REG_SERIAL_COUNT) return;
+    if (status == STATUS_OBJECT_NAME_NOT_FOUND) type = total = 0;
+    else if (status || total > size || total > REG_CACHE_MAX_DATA) return;
+
+    pthread_mutex_lock( &reg_cache_mutex );
+    if ((entry = get_reg_cache_entry( key, name, buffer )))
+    {
+        entry->key = key;
+        entry->serial_index = serial_index;
+        entry->serial = serial;
+        entry->status = status;
+        entry->type = type;
+        entry->total = total;
+        entry->name_len = name->Length;
+        memcpy( entry->name, buffer, name->Length );
+        if (total) memcpy( entry->data, data, total );
+    }
+    pthread_mutex_unlock( &reg_cache_mutex );
+}
+
+/***********************************************************************
+ *           reg_cache_close_handle
+ *
+ * Drop the cached values of a key handle that is being closed.
+ */
+void reg_cache_close_handle( HANDLE handle )
+{
+    unsigned int i;
+
+    if (reg_cache_hives <= 0) return;
+
+    pthread_mutex_lock( &reg_cache_mutex );
+    for (i = 0; i < REG_CACHE_SIZE; i++) if (reg_cache[i].key == handle) reg_cache[i].key = 0;
+    pthread_mutex_unlock( &reg_cache_mutex );
+}
+
+
 NTSTATUS open_hkcu_key( const char *path, HANDLE *key )
 {
     NTSTATUS status;
@@ -494,6 +656,8 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
     unsigned int ret;
     UCHAR *data_ptr;
     unsigned int fixed_size, min_size;
+    data_size_t data_size, total;
+    int type;
 
     TRACE( "(%p,%s,%d,%p,%d)\n", handle, debugstr_us(name), info_class, info, (int)length );
 
@@ -539,21 +703,32 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
         return STATUS_INVALID_PARAMETER;
     }
 
-    SERVER_START_REQ( get_key_value )
+    data_size = (length > fixed_size && data_ptr) ? length - fixed_size : 0;
+
+    if (!get_cached_value( handle, name, data_ptr, data_size, &type, &total, &ret ))
     {
-        req->hkey = wine_server_obj_handle( handle );
-        wine_server_add_data( req, name->Buffer, name->Length );
-        if (length > fixed_size && data_ptr) wine_server_set_reply( req, data_ptr, length - fixed_size );
-        if (!(ret = wine_server_call( req )))
+        SERVER_START_REQ( get_key_value )
         {
-            copy_key_value_info( info_class, info, length, reply->type,
-                                 name->Length, reply->total );
-            *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : reply->total);
-            if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
-            else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
+            req->hkey = wine_server_obj_handle( handle );
+            req->cache = reg_cache_hives > 0 ? reg_cache_hives : 0;
+            wine_server_add_data( req, name->Buffer, name->Length );
+            if (data_size) wine_server_set_reply( req, data_ptr, data_size );
+            ret = wine_server_call( req );
+            type = reply->type;
+            total = reply->total;
+            cache_value( handle, name, data_ptr, data_size, type, total, ret,
+                         reply->serial_index, reply->serial );
         }
+        SERVER_END_REQ;
+    }
+
+    if (!ret)
+    {
+        copy_key_value_info( info_class, info, length, type, name->Length, total );
+        *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : total);
+        if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
+        else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
     }
-    SERVER_END_REQ;
     return ret;
 }
 
@@ -78,6 +78,7 @@
 #include "winioctl.h"
 #include "wine/server.h"
 #include "wine/debug.h"
+#include "wine/perfstats.h"
 #include "unix_private.h"
 #include "ddk/wdm.h"
 
@@ -105,6 +106,10 @@ static int initial_cwd = -1;
 static pid_t server_pid;
 static pthread_mutex_t fd_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+C_ASSERT( REQ_NB_REQUESTS <= WINE_STATS_MAX_REQUESTS );
+static LONG64 server_request_counts[REQ_NB_REQUESTS];  /* number of calls per request type */
+static LONG server_request_stats_enabled;  /* counts are only kept once they have been queried */
+
 /* atomically exchange a 64-bit value */
 static inline LONG64 interlocked_xchg64( LONG64 *dest, LONG64 val )
 {
@@ -261,11 +266,31 @@ unsigned int server_call_unlocked( void *req_ptr )
     struct __server_request_info * const req = req_ptr;
     unsigned int ret;
 
+    if (ReadNoFence( &server_request_stats_enabled ) && req->u.req.request_header.req < REQ_NB_REQUESTS)
+        InterlockedIncrement64( &server_request_counts[req->u.req.request_header.req] );
     if ((ret = send_request( req ))) return ret;
     return wait_reply( req );
 }
 
 
+/***********************************************************************
+ *           get_runtime_stats
+ *
+ * Fill the Unix side part of the runtime statistics.
+ */
+NTSTATUS get_runtime_stats( void *args )
+{
+    struct wine_runtime_stats *stats = args;
+    unsigned int i;
+
+    InterlockedExchange( &server_request_stats_enabled, 1 );
+    for (i = 0; i < REQ_NB_REQUESTS; i++)
+        stats->server_requests[i] = InterlockedCompareExchange64( &server_request_counts[i], 0, 0 );
+    stats->virtual_views = virtual_get_view_count();
+    return STATUS_SUCCESS;
+}
+
+
 /***********************************************************************
  *           wine_server_call
  *
@@ -1779,7 +1804,12 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     if (options & DUPLICATE_CLOSE_SOURCE)
+    {
         fd = remove_fd_from_cache( source );
+        /* the batch belongs to this process, even if the source process is a real handle */
+        if (source_process == NtCurrentProcess()) sock_release_recv_batch( source );
+        reg_cache_close_handle( source );
+    }
 
     SERVER_START_REQ( dup_handle )
     {
@@ -1840,6 +1870,8 @@ NTSTATUS WINAPI NtClose( HANDLE handle )
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     fd = remove_fd_from_cache( handle );
+    sock_release_recv_batch( handle );
+    reg_cache_close_handle( handle );
 
     SERVER_START_REQ( close_handle )
     {
@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -73,10 +74,12 @@
 #include "wine/list.h"
 #include "wine/asm.h"
 #include "unix_private.h"
+#include "ntsyscalls.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(unwind);
 WINE_DECLARE_DEBUG_CHANNEL(seh);
+WINE_DECLARE_DEBUG_CHANNEL(syscallstats);
 
 #include "dwarf.h"
 
@@ -393,9 +396,32 @@ C_ASSERT( sizeof(struct callback_stack_layout) == 0x58 );
 #define SYSCALL_HAVE_XSAVEC      2
 #define SYSCALL_HAVE_PTHREAD_TEB 4
 #define SYSCALL_HAVE_WRFSGSBASE  8
+#define SYSCALL_TRACE_STATS     16
 
 static unsigned int syscall_flags;
 
+enum syscall_ids
+{
+#define SYSCALL_ENTRY(id,name,args) __id_##name = id,
+    ALL_SYSCALLS64
+#undef SYSCALL_ENTRY
+};
+
+/* Leaf syscalls (ALL_FAST_SYSCALLS) don't touch the floating point state and
+ * never call back into PE code, so the dispatcher only saves the non-volatile
+ * part of it for them. The rest of the frame save area is left over from a
+ * previous syscall, which is fine since the volatile registers are undefined
+ * across a syscall anyway. */
+static const ULONG leaf_syscalls[] =
+{
+#define FAST_SYSCALL(name,args) __id_##name,
+    ALL_FAST_SYSCALLS
+#undef FAST_SYSCALL
+};
+
+#define LEAF_SYSCALL_LIMIT 0x200
+UINT64 leaf_syscall_mask[LEAF_SYSCALL_LIMIT / 64];  /* used by __wine_syscall_dispatcher */
+
 struct syscall_frame
 {
     ULONG64               rax;           /* 0000 */
@@ -2379,6 +2405,27 @@ static void *mac_thread_gsbase(void)
 #endif
 
 
+/**********************************************************************
+ *		get_tsc_frequency
+ *
+ * Estimate the TSC frequency used to convert the syscall statistics.
+ */
+static ULONG64 get_tsc_frequency(void)
+{
+    struct timespec start, now;
+    ULONG64 start_tsc, elapsed;
+
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    start_tsc = __builtin_ia32_rdtsc();
+    do
+    {
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        elapsed = (now.tv_sec - start.tv_sec) * (ULONG64)1000000000 + now.tv_nsec - start.tv_nsec;
+    } while (elapsed < 10000000);
+    return (__builtin_ia32_rdtsc() - start_tsc) * 1000000000 / elapsed;
+}
+
+
 /**********************************************************************
  *		signal_init_process
  */
@@ -2387,6 +2434,7 @@ void signal_init_process(void)
     struct sigaction sig_act;
     WOW_TEB *wow_teb = get_wow_teb( NtCurrentTeb() );
     void *ptr, *kernel_stack = (char *)ntdll_get_thread_data()->kernel_stack + kernel_stack_size;
+    unsigned int i;
 
     amd64_thread_data()->syscall_frame = (struct syscall_frame *)kernel_stack - 1;
 
@@ -2397,6 +2445,14 @@ void signal_init_process(void)
 
     if (cpu_info.ProcessorFeatureBits & CPU_FEATURE_XSAVE) syscall_flags |= SYSCALL_HAVE_XSAVE;
     if (xstate_compaction_enabled) syscall_flags |= SYSCALL_HAVE_XSAVEC;
+    for (i = 0; i < ARRAY_SIZE(leaf_syscalls); i++)
+        if (leaf_syscalls[i] < LEAF_SYSCALL_LIMIT)
+            leaf_syscall_mask[leaf_syscalls[i] / 64] |= (UINT64)1 << (leaf_syscalls[i] % 64);
+    if (TRACE_ON(syscallstats))
+    {
+        init_syscall_stats( get_tsc_frequency() );
+        syscall_flags |= SYSCALL_TRACE_STATS;
+    }
 
 #ifdef __linux__
     if (wow_teb)
@@ -2634,7 +2690,11 @@ __ASM_GLOBAL_FUNC( __wine_syscall_dispatcher,
                     * depends on us returning to it. Adjust the return address accordingly. */
                    "subq $0xb,0x70(%rcx)\n\t"
                    "movl 0xb0(%rcx),%r14d\n\t"     /* frame->syscall_flags */
-                   "testl $3,%r14d\n\t"            /* SYSCALL_HAVE_XSAVE | SYSCALL_HAVE_XSAVEC */
+                   "cmpl $0x200,%eax\n\t"          /* LEAF_SYSCALL_LIMIT */
+                   "jae 1f\n\t"
+                   "btl %eax," __ASM_NAME("leaf_syscall_mask") "(%rip)\n\t"
+                   "jc 7f\n"
+                   "1:\ttestl $3,%r14d\n\t"        /* SYSCALL_HAVE_XSAVE | SYSCALL_HAVE_XSAVEC */
                    "jz 2f\n\t"
                    "movl $7,%eax\n\t"
                    "xorl %edx,%edx\n\t"
@@ -2654,6 +2714,21 @@ __ASM_GLOBAL_FUNC( __wine_syscall_dispatcher,
                    "jmp 3f\n"
                    "1:\txsave64 0xc0(%rcx)\n\t"
                    "jmp 3f\n"
+                   /* leaf syscall, only save the non-volatile state */
+                   "7:\tfnstcw 0xc0(%rcx)\n\t"      /* frame->xsave.ControlWord */
+                   "stmxcsr 0xd8(%rcx)\n\t"        /* frame->xsave.MxCsr */
+                   "orq $3,0x2c0(%rcx)\n\t"        /* frame->xstate.Mask |= XSTATE_MASK_LEGACY */
+                   "movaps %xmm6,0x1c0(%rcx)\n\t"
+                   "movaps %xmm7,0x1d0(%rcx)\n\t"
+                   "movaps %xmm8,0x1e0(%rcx)\n\t"
+                   "movaps %xmm9,0x1f0(%rcx)\n\t"
+                   "movaps %xmm10,0x200(%rcx)\n\t"
+                   "movaps %xmm11,0x210(%rcx)\n\t"
+                   "movaps %xmm12,0x220(%rcx)\n\t"
+                   "movaps %xmm13,0x230(%rcx)\n\t"
+                   "movaps %xmm14,0x240(%rcx)\n\t"
+                   "movaps %xmm15,0x250(%rcx)\n\t"
+                   "jmp 3f\n"
                    "2:\tfxsave64 0xc0(%rcx)\n"
                    "3:\tleaq 0x98(%rcx),%rbp\n\t"
                    __ASM_CFI_CFA_IS_AT1(rbp, 0x70)
@@ -2729,6 +2804,8 @@ __ASM_GLOBAL_FUNC( __wine_syscall_dispatcher,
                    "movq %r12,%r8\n\t"             /* 5th argument */
                    "movq %r13,%r9\n\t"             /* 6th argument */
                    "movq (%rbx),%r10\n\t"          /* table->ServiceTable */
+                   "testl $16,%r14d\n\t"           /* SYSCALL_TRACE_STATS */
+                   "jnz 6f\n\t"
                    "callq *(%r10,%rax,8)\n\t"
                    "leaq -0x98(%rbp),%rcx\n\t"
                    __ASM_LOCAL_LABEL("__wine_syscall_dispatcher_return") ":\n\t"
@@ -2821,6 +2898,26 @@ __ASM_GLOBAL_FUNC( __wine_syscall_dispatcher,
                    __ASM_CFI("\t.cfi_restore_state\n")
                    "5:\tmovl $0xc000000d,%eax\n\t" /* STATUS_INVALID_PARAMETER */
                    "movq %rsp,%rcx\n\t"
+                   "jmp " __ASM_LOCAL_LABEL("__wine_syscall_dispatcher_return") "\n"
+                   /* instrumented call, see record_syscall_stats */
+                   "6:\tmovq %rax,%r12\n\t"        /* syscall number */
+                   "movq %rbx,%r15\n\t"            /* syscall table */
+                   "movq %rdx,%r13\n\t"
+                   "rdtsc\n\t"
+                   "shlq $32,%rdx\n\t"
+                   "leaq (%rax,%rdx),%rbx\n\t"     /* start time */
+                   "movq %r13,%rdx\n\t"            /* 3rd argument */
+                   "callq *(%r10,%r12,8)\n\t"
+                   "movq %rax,%r13\n\t"            /* status */
+                   "rdtsc\n\t"
+                   "shlq $32,%rdx\n\t"
+                   "leaq (%rax,%rdx),%rdx\n\t"
+                   "subq %rbx,%rdx\n\t"            /* elapsed time */
+                   "movq %r15,%rdi\n\t"
+                   "movl %r12d,%esi\n\t"
+                   "call " __ASM_NAME("record_syscall_stats") "\n\t"
+                   "movq %r13,%rax\n\t"
+                   "leaq -0x98(%rbp),%rcx\n\t"
                    "jmp " __ASM_LOCAL_LABEL("__wine_syscall_dispatcher_return") "\n\t"
                    ".globl " __ASM_NAME("__wine_syscall_dispatcher_return") "\n"
                    __ASM_NAME("__wine_syscall_dispatcher_return") ":\n\t"
@@ -28,6 +28,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <unistd.h>
 #ifdef HAVE_IFADDRS_H
 # include <ifaddrs.h>
@@ -95,6 +96,9 @@ WINE_DEFAULT_DEBUG_CHANNEL(winsock);
 
 #define u64_to_user_ptr(u) ((void *)(uintptr_t)(u))
 
+/* maximum number of sockets polled on the client side */
+#define SOCK_FAST_POLL_MAX_COUNT   64
+
 union unix_sockaddr
 {
     struct sockaddr addr;
@@ -719,7 +723,345 @@ static ssize_t fixup_icmp_over_dgram( struct msghdr *hdr, union unix_sockaddr *u
     return recv_len;
 }
 
-static NTSTATUS try_recv( int fd, struct async_recv_ioctl *async, ULONG_PTR *size )
+#ifdef linux
+
+/* Datagrams prefetched with recvmmsg(). Batching is enabled by setting
+ * WINESOCKBATCH to the number of datagrams to fetch at once. The batch buffer
+ * is allocated on the first fill and kept until the handle is closed. The
+ * server is told when prefetched data is pending so that it can report the
+ * socket as readable; it only allows filling a batch if the socket has a
+ * single handle and no event or message select. */
+
+#define RECV_BATCH_MAX_COUNT 32
+#define RECV_BATCH_SLOT_SIZE 65536  /* enough for any UDP datagram */
+#define RECV_BATCH_HASH_SIZE 64
+
+struct recv_batch_msg
+{
+    unsigned int len;
+    int flags;
+    socklen_t addr_len;
+    size_t control_len;
+    union unix_sockaddr addr;
+    char control[512];
+};
+
+struct recv_batch
+{
+    struct recv_batch *next;  /* next batch in the hash chain */
+    HANDLE handle;
+    char *data;               /* RECV_BATCH_SLOT_SIZE bytes per datagram */
+    unsigned int head;        /* index of the first queued datagram */
+    unsigned int count;       /* number of queued datagrams */
+    BOOL selected;            /* event or message select is used, receive through the server */
+    struct recv_batch_msg msgs[RECV_BATCH_MAX_COUNT];
+};
+
+enum recv_batch_mode
+{
+    RECV_BATCH_NONE,  /* use queued datagrams if there are any, else receive directly */
+    RECV_BATCH_ONLY,  /* only use queued datagrams, the server handles anything else */
+    RECV_BATCH_FILL,  /* fill the batch if it is empty */
+};
+
+static pthread_mutex_t recv_batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct recv_batch *recv_batches[RECV_BATCH_HASH_SIZE];
+static LONG recv_batch_count;  /* number of allocated batches */
+static int recv_batch_size = -1;
+
+static unsigned int get_recv_batch_size(void)
+{
+    if (recv_batch_size == -1)
+    {
+        const char *str = getenv( "WINESOCKBATCH" );
+        int size = str ? atoi( str ) : 0;
+
+        if (size < 2) size = 0;
+        recv_batch_size = min( size, RECV_BATCH_MAX_COUNT );
+        if (recv_batch_size) TRACE( "batching up to %d datagrams\n", recv_batch_size );
+    }
+    return recv_batch_size;
+}
+
+static inline unsigned int recv_batch_hash( HANDLE handle )
+{
+    return (HandleToULong( handle ) >> 2) % RECV_BATCH_HASH_SIZE;
+}
+
+/* recv_batch_mutex must be held */
+static struct recv_batch **find_recv_batch( HANDLE handle )
+{
+    struct recv_batch **batch;
+
+    for (batch = &recv_batches[recv_batch_hash( handle )]; *batch; batch = &(*batch)->next)
+        if ((*batch)->handle == handle) break;
+    return batch;
+}
+
+/* recv_batch_mutex must be held */
+static struct recv_batch *alloc_recv_batch( HANDLE handle )
+{
+    struct recv_batch *batch, **ptr = find_recv_batch( handle );
+
+    if (!(batch = calloc( 1, sizeof(*batch) ))) return NULL;
+    if (!(batch->data = malloc( (size_t)get_recv_batch_size() * RECV_BATCH_SLOT_SIZE )))
+    {
+        free( batch );
+        return NULL;
+    }
+    batch->handle = handle;
+    *ptr = batch;
+    InterlockedIncrement( &recv_batch_count );
+    return batch;
+}
+
+/* Tell the server whether the handle has queued datagrams. This is called
+ * with recv_batch_mutex held, so that updates reach the server in order. */
+static void set_socket_buffered( HANDLE handle, int delta )
+{
+    SERVER_START_REQ( set_socket_buffered )
+    {
+        req->handle = wine_server_obj_handle( handle );
+        req->delta  = delta;
+        wine_server_call( req );
+    }
+    SERVER_END_REQ;
+}
+
+/* called on handle close; the server forgets about the buffered data itself */
+void sock_release_recv_batch( HANDLE handle )
+{
+    struct recv_batch **ptr, *batch = NULL;
+
+    if (!ReadNoFence( &recv_batch_count )) return;
+
+    mutex_lock( &recv_batch_mutex );
+    if ((batch = *(ptr = find_recv_batch( handle ))))
+    {
+        *ptr = batch->next;
+        InterlockedDecrement( &recv_batch_count );
+    }
+    mutex_unlock( &recv_batch_mutex );
+
+    if (!batch) return;
+    if (batch->count) WARN( "dropping %u prefetched datagrams\n", batch->count );
+    free( batch->data );
+    free( batch );
+}
+
+/* the server has to see the receives to re-enable FD_READ once the socket is selected */
+static void sock_select_recv_batch( HANDLE handle )
+{
+    struct recv_batch *batch;
+
+    if (!ReadNoFence( &recv_batch_count )) return;
+
+    mutex_lock( &recv_batch_mutex );
+    if ((batch = *find_recv_batch( handle ))) batch->selected = TRUE;
+    mutex_unlock( &recv_batch_mutex );
+}
+
+/* check whether the next receive may be done from queued datagrams without the server;
+ * this is only a hint, recv_batch_read() checks again */
+static BOOL has_recv_batch_data( HANDLE handle )
+{
+    struct recv_batch *batch;
+    BOOL ret;
+
+    if (!ReadNoFence( &recv_batch_count )) return FALSE;
+
+    mutex_lock( &recv_batch_mutex );
+    ret = (batch = *find_recv_batch( handle )) && batch->count && !batch->selected;
+    mutex_unlock( &recv_batch_mutex );
+    return ret;
+}
+
+/* FIONREAD has to report the size of the next queued datagram */
+static BOOL get_recv_batch_next_size( HANDLE handle, int *size )
+{
+    struct recv_batch *batch;
+    BOOL ret;
+
+    if (!ReadNoFence( &recv_batch_count )) return FALSE;
+
+    mutex_lock( &recv_batch_mutex );
+    if ((ret = (batch = *find_recv_batch( handle )) && batch->count))
+        *size = batch->msgs[batch->head].len;
+    mutex_unlock( &recv_batch_mutex );
+    return ret;
+}
+
+/* fill the batch with as many datagrams as are available */
+static int fill_recv_batch( struct recv_batch *batch, int fd )
+{
+    struct mmsghdr msgs[RECV_BATCH_MAX_COUNT];
+    struct iovec iov[RECV_BATCH_MAX_COUNT];
+    unsigned int i, count = get_recv_batch_size();
+    int ret;
+
+    memset( msgs, 0, count * sizeof(*msgs) );
+    for (i = 0; i < count; ++i)
+    {
+        iov[i].iov_base = batch->data + i * RECV_BATCH_SLOT_SIZE;
+        iov[i].iov_len = RECV_BATCH_SLOT_SIZE;
+        msgs[i].msg_hdr.msg_name = &batch->msgs[i].addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(batch->msgs[i].addr);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = batch->msgs[i].control;
+        msgs[i].msg_hdr.msg_controllen = sizeof(batch->msgs[i].control);
+    }
+
+    errno = 0;
+    while ((ret = recvmmsg( fd, msgs, count, MSG_DONTWAIT, NULL )) < 0 && errno == EINTR);
+    if (ret <= 0) return ret;
+
+    TRACE( "prefetched %d datagrams\n", ret );
+    for (i = 0; i < ret; ++i)
+    {
+        batch->msgs[i].len = msgs[i].msg_len;
+        batch->msgs[i].flags = msgs[i].msg_hdr.msg_flags;
+        batch->msgs[i].addr_len = msgs[i].msg_hdr.msg_namelen;
+        batch->msgs[i].control_len = msgs[i].msg_hdr.msg_controllen;
+    }
+    batch->head = 0;
+    batch->count = ret;
+    return ret;
+}
+
+/* Returns FALSE if the receive should be done directly on the socket. A batch
+ * is only filled if the server allowed it, which also means that no other
+ * receive can be queued ahead of this one. In RECV_BATCH_ONLY mode, the
+ * receive fails with EWOULDBLOCK if no datagram is queued. */
+static BOOL recv_batch_read( int fd, struct async_recv_ioctl *async, enum recv_batch_mode mode,
+                             struct msghdr *hdr, ssize_t *ret )
+{
+    HANDLE handle = async->io.handle;
+    struct recv_batch *batch;
+    const struct recv_batch_msg *msg;
+    const char *data;
+    unsigned int i, len;
+    BOOL filled = FALSE;
+
+    if (!get_recv_batch_size() || async->icmp_over_dgram || (async->unix_flags & ~MSG_PEEK))
+        goto not_batched;
+    if (mode != RECV_BATCH_FILL && !ReadNoFence( &recv_batch_count )) goto not_batched;
+
+    mutex_lock( &recv_batch_mutex );
+
+    batch = *find_recv_batch( handle );
+    if (mode == RECV_BATCH_ONLY && batch && batch->selected) batch = NULL;
+    if (!batch || !batch->count)
+    {
+        if (mode != RECV_BATCH_FILL || (async->unix_flags & MSG_PEEK) ||
+            (!batch && !(batch = alloc_recv_batch( handle ))))
+        {
+            mutex_unlock( &recv_batch_mutex );
+            goto not_batched;
+        }
+        if (fill_recv_batch( batch, fd ) <= 0)
+        {
+            mutex_unlock( &recv_batch_mutex );
+            if (!errno) errno = EWOULDBLOCK;
+            *ret = -1;
+            return TRUE;
+        }
+        filled = TRUE;
+    }
+
+    msg = &batch->msgs[batch->head];
+    data = batch->data + batch->head * RECV_BATCH_SLOT_SIZE;
+    *ret = 0;
+
+    for (i = 0, len = 0; i < async->count && len < msg->len; ++i)
+    {
+        size_t size = min( async->iov[i].iov_len, msg->len - len );
+
+        if (virtual_uninterrupted_write_memory( async->iov[i].iov_base, data + len, size ))
+        {
+            errno = EFAULT;
+            *ret = -1;
+            break;
+        }
+        len += size;
+    }
+
+    if (!*ret)
+    {
+        hdr->msg_flags = msg->flags;
+        if (len < msg->len) hdr->msg_flags |= MSG_TRUNC;
+        if (hdr->msg_name)
+        {
+            hdr->msg_namelen = min( hdr->msg_namelen, msg->addr_len );
+            memcpy( hdr->msg_name, &msg->addr, hdr->msg_namelen );
+        }
+        if (hdr->msg_control)
+        {
+            if (msg->control_len > hdr->msg_controllen) hdr->msg_flags |= MSG_CTRUNC;
+            hdr->msg_controllen = min( hdr->msg_controllen, msg->control_len );
+            memcpy( hdr->msg_control, msg->control, hdr->msg_controllen );
+        }
+        *ret = len;
+
+        if (!(async->unix_flags & MSG_PEEK))
+        {
+            batch->head++;
+            batch->count--;
+        }
+    }
+
+    if (filled && batch->count) set_socket_buffered( handle, 1 );
+    else if (!filled && !batch->count) set_socket_buffered( handle, -1 );
+
+    mutex_unlock( &recv_batch_mutex );
+    return TRUE;
+
+not_batched:
+    if (mode != RECV_BATCH_ONLY) return FALSE;
+    errno = EWOULDBLOCK;
+    *ret = -1;
+    return TRUE;
+}
+
+#else
+
+enum recv_batch_mode
+{
+    RECV_BATCH_NONE,
+    RECV_BATCH_ONLY,
+    RECV_BATCH_FILL,
+};
+
+void sock_release_recv_batch( HANDLE handle )
+{
+}
+
+static void sock_select_recv_batch( HANDLE handle )
+{
+}
+
+static BOOL has_recv_batch_data( HANDLE handle )
+{
+    return FALSE;
+}
+
+static BOOL get_recv_batch_next_size( HANDLE handle, int *size )
+{
+    return FALSE;
+}
+
+static BOOL recv_batch_read( int fd, struct async_recv_ioctl *async, enum recv_batch_mode mode,
+                             struct msghdr *hdr, ssize_t *ret )
+{
+    if (mode != RECV_BATCH_ONLY) return FALSE;
+    errno = EWOULDBLOCK;
+    *ret = -1;
+    return TRUE;
+}
+
+#endif
+
+static NTSTATUS try_recv( int fd, struct async_recv_ioctl *async, enum recv_batch_mode mode, ULONG_PTR *size )
 {
 #ifndef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
     char control_buffer[512];
@@ -741,7 +1083,8 @@ static NTSTATUS try_recv( int fd, struct async_recv_ioctl *async, ULONG_PTR *siz
     hdr.msg_control = control_buffer;
     hdr.msg_controllen = sizeof(control_buffer);
 #endif
-    while ((ret = virtual_locked_recvmsg( fd, &hdr, async->unix_flags )) < 0 && errno == EINTR);
+    if (!recv_batch_read( fd, async, mode, &hdr, &ret ))
+        while ((ret = virtual_locked_recvmsg( fd, &hdr, async->unix_flags )) < 0 && errno == EINTR);
 
     if (ret < 0)
     {
@@ -822,7 +1165,7 @@ static BOOL async_recv_proc( void *user, ULONG_PTR *info, unsigned int *status )
         if ((*status = server_get_unix_fd( async->io.handle, 0, &fd, &needs_close, NULL, NULL )))
             return TRUE;
 
-        *status = try_recv( fd, async, info );
+        *status = try_recv( fd, async, RECV_BATCH_NONE, info );
         TRACE( "got status %#x, %#lx bytes read\n", *status, *info );
         if (needs_close) close( fd );
 
@@ -850,11 +1193,23 @@ static BOOL is_icmp_over_dgram( int fd )
 #endif
 }
 
+static void complete_async( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
+                            IO_STATUS_BLOCK *io, NTSTATUS status, ULONG_PTR information )
+{
+    ULONG_PTR iosb_ptr = iosb_client_ptr(io);
+
+    io->Status = status;
+    io->Information = information;
+    if (event) NtSetEvent( event, NULL );
+    if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc, (ULONG_PTR)apc_user, iosb_ptr, 0 );
+    if (apc_user) add_completion( handle, (ULONG_PTR)apc_user, status, information, FALSE );
+}
+
 static NTSTATUS sock_recv( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *io,
                            int fd, struct async_recv_ioctl *async, int force_async )
 {
     HANDLE wait_handle;
-    BOOL nonblocking;
+    BOOL nonblocking, batch;
     unsigned int i, status;
     ULONG options;
 
@@ -867,6 +1222,20 @@ static NTSTATUS sock_recv( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, voi
         }
     }
 
+    /* datagrams prefetched earlier have to be returned first */
+    if (has_recv_batch_data( handle ))
+    {
+        ULONG_PTR information = 0;
+
+        status = try_recv( fd, async, RECV_BATCH_ONLY, &information );
+        if (status != STATUS_DEVICE_NOT_READY)
+        {
+            release_fileio( &async->io );
+            if (!NT_ERROR(status)) complete_async( handle, event, apc, apc_user, io, status, information );
+            return status;
+        }
+    }
+
     SERVER_START_REQ( recv_socket )
     {
         req->force_async = force_async;
@@ -876,6 +1245,7 @@ static NTSTATUS sock_recv( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, voi
         wait_handle = wine_server_ptr_handle( reply->wait );
         options     = reply->options;
         nonblocking = reply->nonblocking;
+        batch       = reply->batch;
     }
     SERVER_END_REQ;
 
@@ -886,7 +1256,7 @@ static NTSTATUS sock_recv( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, voi
     {
         ULONG_PTR information;
 
-        status = try_recv( fd, async, &information );
+        status = try_recv( fd, async, batch ? RECV_BATCH_FILL : RECV_BATCH_NONE, &information );
         if (status == STATUS_DEVICE_NOT_READY && (force_async || !nonblocking))
             status = STATUS_PENDING;
         if (!NT_ERROR(status) && status != STATUS_PENDING)
@@ -1439,18 +1809,6 @@ static NTSTATUS sock_transmit( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc,
     return status;
 }
 
-static void complete_async( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
-                            IO_STATUS_BLOCK *io, NTSTATUS status, ULONG_PTR information )
-{
-    ULONG_PTR iosb_ptr = iosb_client_ptr(io);
-
-    io->Status = status;
-    io->Information = information;
-    if (event) NtSetEvent( event, NULL );
-    if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc, (ULONG_PTR)apc_user, iosb_ptr, 0 );
-    if (apc_user) add_completion( handle, (ULONG_PTR)apc_user, status, information, FALSE );
-}
-
 
 static NTSTATUS do_getsockopt( HANDLE handle, IO_STATUS_BLOCK *io, int level,
                                int option, void *out_buffer, ULONG out_size )
@@ -1502,6 +1860,177 @@ static int get_sock_type( HANDLE handle )
 }
 
 
+/* Try to satisfy a poll on connectionless sockets on the client side, which only
+ * needs a quick server call to check their state instead of a queued async.
+ * The unix poll never blocks, so that the wait stays alertable and cancellable;
+ * if no socket is ready and the caller wants to wait, the server handles it.
+ * Returns STATUS_BAD_DEVICE_TYPE if the request has to be handled by the server. */
+static NTSTATUS sock_poll_fast( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
+                                IO_STATUS_BLOCK *io, const void *in_buffer, UINT in_size,
+                                void *out_buffer, UINT out_size )
+{
+    struct pollfd pollfds[SOCK_FAST_POLL_MAX_COUNT];
+    int needs_close[SOCK_FAST_POLL_MAX_COUNT];
+    HANDLE sockets[SOCK_FAST_POLL_MAX_COUNT];
+    obj_handle_t handles[SOCK_FAST_POLL_MAX_COUNT];
+    unsigned int state[SOCK_FAST_POLL_MAX_COUNT];
+    int flags[SOCK_FAST_POLL_MAX_COUNT];
+    NTSTATUS status = STATUS_BAD_DEVICE_TYPE;
+    unsigned int i, count, signaled = 0;
+    LONGLONG timeout;
+    BOOLEAN exclusive;
+    ULONG_PTR information;
+    int ret;
+
+    if (in_wow64_call())
+    {
+        const struct afd_poll_params_32 *params = in_buffer;
+
+        if (in_size < offsetof( struct afd_poll_params_32, sockets[0] )) return STATUS_BAD_DEVICE_TYPE;
+        count = params->count;
+        if (!count || count > SOCK_FAST_POLL_MAX_COUNT ||
+            in_size < offsetof( struct afd_poll_params_32, sockets[count] ) || out_size < in_size)
+            return STATUS_BAD_DEVICE_TYPE;
+        timeout = params->timeout;
+        exclusive = params->exclusive;
+        for (i = 0; i < count; ++i)
+        {
+            sockets[i] = ULongToHandle( params->sockets[i].socket );
+            flags[i] = params->sockets[i].flags;
+        }
+    }
+    else
+    {
+        const struct afd_poll_params *params = in_buffer;
+
+        if (in_size < offsetof( struct afd_poll_params, sockets[0] )) return STATUS_BAD_DEVICE_TYPE;
+        count = params->count;
+        if (!count || count > SOCK_FAST_POLL_MAX_COUNT ||
+            in_size < offsetof( struct afd_poll_params, sockets[count] ) || out_size < in_size)
+            return STATUS_BAD_DEVICE_TYPE;
+        timeout = params->timeout;
+        exclusive = params->exclusive;
+        for (i = 0; i < count; ++i)
+        {
+            sockets[i] = (HANDLE)params->sockets[i].socket;
+            flags[i] = params->sockets[i].flags;
+        }
+    }
+
+    if (exclusive) return STATUS_BAD_DEVICE_TYPE;
+
+    for (i = 0; i < count; ++i) handles[i] = wine_server_obj_handle( sockets[i] );
+
+    SERVER_START_REQ( get_socket_poll_state )
+    {
+        wine_server_add_data( req, handles, count * sizeof(*handles) );
+        wine_server_set_reply( req, state, count * sizeof(*state) );
+        ret = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+
+    if (ret) return STATUS_BAD_DEVICE_TYPE;
+
+    for (i = 0; i < count; ++i)
+        if (state[i] & SOCKET_POLL_STATE_SERVER) return STATUS_BAD_DEVICE_TYPE;
+
+    for (i = 0; i < count; ++i)
+    {
+        enum server_fd_type type;
+
+        if (server_get_unix_fd( sockets[i], 0, &pollfds[i].fd, &needs_close[i], &type, NULL )) break;
+        if (type != FD_TYPE_SOCKET)
+        {
+            if (needs_close[i]) close( pollfds[i].fd );
+            break;
+        }
+
+        pollfds[i].events = 0;
+        if (flags[i] & (AFD_POLL_READ | AFD_POLL_ACCEPT)) pollfds[i].events |= POLLIN;
+        if (flags[i] & AFD_POLL_OOB)
+            pollfds[i].events |= (state[i] & SOCKET_POLL_STATE_OOBINLINE) ? POLLIN : POLLPRI;
+        if (flags[i] & AFD_POLL_WRITE) pollfds[i].events |= POLLOUT;
+        pollfds[i].revents = 0;
+    }
+
+    if (i < count)
+    {
+        count = i;
+        goto done;
+    }
+
+    while ((ret = poll( pollfds, count, 0 )) < 0 && errno == EINTR);
+    if (ret < 0) goto done;
+
+    /* errors and hangups update the socket state, leave them to the server */
+    for (i = 0; i < count; ++i)
+        if (pollfds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) goto done;
+
+    for (i = 0; i < count; ++i)
+    {
+        int revents = 0;
+
+        if (pollfds[i].revents & POLLIN) revents |= AFD_POLL_READ;
+        if (pollfds[i].revents & POLLPRI)
+            revents |= (state[i] & SOCKET_POLL_STATE_OOBINLINE) ? AFD_POLL_READ : AFD_POLL_OOB;
+        if (pollfds[i].revents & POLLOUT) revents |= AFD_POLL_WRITE;
+        /* the server reports connected sockets as signaled right away */
+        if (state[i] & SOCKET_POLL_STATE_CONNECTED) revents |= AFD_POLL_CONNECT;
+        if (!(revents &= flags[i])) continue;
+
+        if (in_wow64_call())
+        {
+            struct afd_poll_params_32 *params = out_buffer;
+
+            params->sockets[signaled].socket = HandleToULong( sockets[i] );
+            params->sockets[signaled].flags = revents;
+            params->sockets[signaled].status = STATUS_SUCCESS;
+        }
+        else
+        {
+            struct afd_poll_params *params = out_buffer;
+
+            params->sockets[signaled].socket = (ULONG_PTR)sockets[i];
+            params->sockets[signaled].flags = revents;
+            params->sockets[signaled].status = STATUS_SUCCESS;
+        }
+        ++signaled;
+    }
+
+    /* let the server wait for the sockets */
+    if (!signaled && timeout) goto done;
+
+    TRACE( "polled %u datagram sockets on the client side, %u signaled\n", count, signaled );
+
+    if (in_wow64_call())
+    {
+        struct afd_poll_params_32 *params = out_buffer;
+
+        params->timeout = timeout;
+        params->count = signaled;
+        params->exclusive = exclusive;
+        information = offsetof( struct afd_poll_params_32, sockets[signaled] );
+    }
+    else
+    {
+        struct afd_poll_params *params = out_buffer;
+
+        params->timeout = timeout;
+        params->count = signaled;
+        params->exclusive = exclusive;
+        information = offsetof( struct afd_poll_params, sockets[signaled] );
+    }
+
+    status = signaled ? STATUS_SUCCESS : STATUS_TIMEOUT;
+    complete_async( handle, event, apc, apc_user, io, status, information );
+
+done:
+    for (i = 0; i < count; ++i)
+        if (needs_close[i]) close( pollfds[i].fd );
+    return status;
+}
+
+
 NTSTATUS sock_ioctl( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *io,
                      UINT code, void *in_buffer, UINT in_size, void *out_buffer, UINT out_size )
 {
@@ -1549,10 +2078,16 @@ NTSTATUS sock_ioctl( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc
             TRACE( "event %p, mask %#x\n", params->event, params->mask );
             if (out_size) FIXME( "unexpected output size %u\n", out_size );
 
+            sock_select_recv_batch( handle );
             status = STATUS_BAD_DEVICE_TYPE;
             break;
         }
 
+        case IOCTL_AFD_WINE_MESSAGE_SELECT:
+            sock_select_recv_batch( handle );
+            status = STATUS_BAD_DEVICE_TYPE;
+            break;
+
         case IOCTL_AFD_GET_EVENTS:
         {
             struct afd_get_events_params *params = out_buffer;
@@ -1582,8 +2117,7 @@ NTSTATUS sock_ioctl( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc
         }
 
         case IOCTL_AFD_POLL:
-            status = STATUS_BAD_DEVICE_TYPE;
-            break;
+            return sock_poll_fast( handle, event, apc, apc_user, io, in_buffer, in_size, out_buffer, out_size );
 
         case IOCTL_AFD_RECV:
         {
@@ -1756,7 +2290,7 @@ NTSTATUS sock_ioctl( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc
             }
 #endif
 
-            if ((ret = ioctl( fd, FIONREAD, &value )) < 0)
+            if (!get_recv_batch_next_size( handle, &value ) && (ret = ioctl( fd, FIONREAD, &value )) < 0)
             {
                 status = sock_errno_to_status( errno );
                 break;
@@ -105,6 +105,13 @@ static inline ULONGLONG monotonic_counter(void)
 
 #define FUTEX_WAIT 0
 #define FUTEX_WAKE 1
+#define FUTEX_WAIT_BITSET 9
+#define FUTEX_WAKE_BITSET 10
+
+#ifndef __NR_futex_waitv
+#define __NR_futex_waitv 449
+#endif
+#define FUTEX2_SIZE_U32 0x02
 
 static int futex_private = 128;
 
@@ -129,6 +136,51 @@ static inline int futex_wake( const LONG *addr, int val )
     return syscall( __NR_futex, addr, FUTEX_WAKE | futex_private, val, NULL, 0, 0 );
 }
 
+/* the timeout is absolute, relative to CLOCK_MONOTONIC */
+static inline int futex_wait_bitset( const LONG *addr, int val, struct timespec *end, unsigned int bitset )
+{
+#if (defined(__i386__) || defined(__arm__)) && _TIME_BITS==64
+    if (end && sizeof(*end) != 8)
+    {
+        struct {
+            long tv_sec;
+            long tv_nsec;
+        } end32 = { end->tv_sec, end->tv_nsec };
+
+        return syscall( __NR_futex, addr, FUTEX_WAIT_BITSET | futex_private, val, &end32, 0, bitset );
+    }
+#endif
+    return syscall( __NR_futex, addr, FUTEX_WAIT_BITSET | futex_private, val, end, 0, bitset );
+}
+
+static inline int futex_wake_bitset( const LONG *addr, int val, unsigned int bitset )
+{
+    return syscall( __NR_futex, addr, FUTEX_WAKE_BITSET | futex_private, val, NULL, 0, bitset );
+}
+
+struct futex_waitv
+{
+    ULONG64 val;
+    ULONG64 uaddr;
+    unsigned int flags;
+    unsigned int reserved;
+};
+
+/* the timeout is absolute, relative to CLOCK_MONOTONIC */
+static inline int futex_waitv( struct futex_waitv *futexes, unsigned int count, struct timespec *end )
+{
+    struct
+    {
+        long long tv_sec;
+        long long tv_nsec;
+    } end64;
+
+    if (!end) return syscall( __NR_futex_waitv, futexes, count, 0, NULL, CLOCK_MONOTONIC );
+    end64.tv_sec = end->tv_sec;
+    end64.tv_nsec = end->tv_nsec;
+    return syscall( __NR_futex_waitv, futexes, count, 0, &end64, CLOCK_MONOTONIC );
+}
+
 static inline int use_futexes(void)
 {
     static LONG supported = -1;
@@ -146,6 +198,18 @@ static inline int use_futexes(void)
     return supported;
 }
 
+static inline int use_futex_waitv(void)
+{
+    static LONG supported = -1;
+
+    if (supported == -1)
+    {
+        syscall( __NR_futex_waitv, NULL, 0, 0, NULL, CLOCK_MONOTONIC );
+        supported = (errno != ENOSYS);
+    }
+    return supported;
+}
+
 #endif
 
 
@@ -1762,6 +1826,175 @@ NTSTATUS WINAPI NtOpenKeyedEvent( HANDLE *handle, ACCESS_MASK access, const OBJE
     return ret;
 }
 
+#if defined(__linux__) || defined(HAVE_KQUEUE)
+static LONGLONG get_absolute_timeout( const LARGE_INTEGER *timeout )
+{
+    LARGE_INTEGER now;
+
+    if (timeout->QuadPart >= 0) return timeout->QuadPart;
+    NtQuerySystemTime( &now );
+    return now.QuadPart - timeout->QuadPart;
+}
+
+static LONGLONG update_timeout( ULONGLONG end )
+{
+    LARGE_INTEGER now;
+    LONGLONG timeleft;
+
+    NtQuerySystemTime( &now );
+    timeleft = end - now.QuadPart;
+    if (timeleft < 0) timeleft = 0;
+    return timeleft;
+}
+#endif
+
+
+#ifdef __linux__
+
+/* The process default keyed event can't be reached from other processes,
+ * so waiters on it are paired locally and sleep on a futex instead of
+ * going through the server. User APCs can only be delivered by the server
+ * though, so alertable waiters sleep on an event there instead, which is
+ * set when they are paired. */
+
+struct keyed_waiter
+{
+    struct list entry;
+    const void *key;
+    int         op;      /* SELECT_KEYED_EVENT_WAIT or SELECT_KEYED_EVENT_RELEASE */
+    HANDLE      event;   /* event to wait on for alertable waits */
+    LONG        paired;
+};
+
+#define KEYED_EVENT_BUCKETS 64
+
+static struct list keyed_waiters[KEYED_EVENT_BUCKETS];
+static pthread_mutex_t keyed_event_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct list *get_keyed_event_bucket( const void *key )
+{
+    struct list *bucket = &keyed_waiters[((ULONG_PTR)key >> 2) % KEYED_EVENT_BUCKETS];
+
+    if (!bucket->next) list_init( bucket );
+    return bucket;
+}
+
+/* the waiter is allocated on the stack, unqueue it if the thread is terminated */
+void exit_keyed_event_wait(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct keyed_waiter *waiter;
+    HANDLE event = 0;
+    sigset_t sigset;
+
+    if (!thread_data->keyed_waiter) return;
+
+    server_enter_uninterrupted_section( &keyed_event_mutex, &sigset );
+    if ((waiter = thread_data->keyed_waiter))
+    {
+        if (!waiter->paired) list_remove( &waiter->entry );
+        event = waiter->event;
+    }
+    thread_data->keyed_waiter = NULL;
+    server_leave_uninterrupted_section( &keyed_event_mutex, &sigset );
+    if (event) NtClose( event );
+}
+
+static NTSTATUS wait_keyed_waiter( struct keyed_waiter *waiter, const LARGE_INTEGER *timeout, ULONGLONG end )
+{
+    int ret;
+
+    if (waiter->event) return NtWaitForSingleObject( waiter->event, TRUE, timeout );
+
+    do
+    {
+        struct timespec timespec;
+        LONGLONG timeleft = timeout ? update_timeout( end ) : 0;
+
+        timespec.tv_sec = timeleft / (ULONGLONG)TICKSPERSEC;
+        timespec.tv_nsec = (timeleft % TICKSPERSEC) * 100;
+        ret = futex_wait( &waiter->paired, 0, timeout ? &timespec : NULL );
+    } while (!ReadAcquire( &waiter->paired ) && !(ret == -1 && errno == ETIMEDOUT));
+
+    return ReadAcquire( &waiter->paired ) ? STATUS_SUCCESS : STATUS_TIMEOUT;
+}
+
+static NTSTATUS local_keyed_event_op( int op, const void *key, BOOLEAN alertable,
+                                      const LARGE_INTEGER *timeout )
+{
+    struct keyed_waiter waiter, *other;
+    LARGE_INTEGER abs_timeout;
+    struct list *bucket;
+    NTSTATUS status;
+    sigset_t sigset;
+    ULONGLONG end = 0;
+    HANDLE event;
+
+    if (timeout)
+    {
+        if (timeout->QuadPart == TIMEOUT_INFINITE) timeout = NULL;
+        else
+        {
+            abs_timeout.QuadPart = end = get_absolute_timeout( timeout );
+            timeout = &abs_timeout;
+        }
+    }
+
+    waiter.key    = key;
+    waiter.op     = op;
+    waiter.event  = 0;
+    waiter.paired = 0;
+
+    if (alertable && (status = NtCreateEvent( &waiter.event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE )))
+        return status;
+
+    server_enter_uninterrupted_section( &keyed_event_mutex, &sigset );
+    bucket = get_keyed_event_bucket( key );
+    LIST_FOR_EACH_ENTRY( other, bucket, struct keyed_waiter, entry )
+    {
+        if (other->key != key || other->op == op) continue;
+        list_remove( &other->entry );
+        WriteRelease( &other->paired, 1 );
+        /* the waiter closes its event as soon as it sees it paired */
+        if ((event = other->event)) NtSetEvent( event, NULL );
+        server_leave_uninterrupted_section( &keyed_event_mutex, &sigset );
+        /* the waiter may return as soon as we drop the lock; waking a stale address is harmless */
+        if (!event) futex_wake( &other->paired, 1 );
+        status = STATUS_SUCCESS;
+        goto done;
+    }
+    if (timeout && !update_timeout( end ))
+    {
+        server_leave_uninterrupted_section( &keyed_event_mutex, &sigset );
+        status = STATUS_TIMEOUT;
+        goto done;
+    }
+    list_add_tail( bucket, &waiter.entry );
+    ntdll_get_thread_data()->keyed_waiter = &waiter;
+    server_leave_uninterrupted_section( &keyed_event_mutex, &sigset );
+
+    status = wait_keyed_waiter( &waiter, timeout, end );
+
+    server_enter_uninterrupted_section( &keyed_event_mutex, &sigset );
+    ntdll_get_thread_data()->keyed_waiter = NULL;
+    /* a user APC may have run if we were paired at the same time, the pairing still counts */
+    if (waiter.paired) status = STATUS_SUCCESS;
+    else list_remove( &waiter.entry );
+    server_leave_uninterrupted_section( &keyed_event_mutex, &sigset );
+
+done:
+    if (waiter.event) NtClose( waiter.event );
+    return status;
+}
+
+#else
+
+void exit_keyed_event_wait(void)
+{
+}
+
+#endif
+
 /******************************************************************************
  *              NtWaitForKeyedEvent (NTDLL.@)
  */
@@ -1773,6 +2006,10 @@ NTSTATUS WINAPI NtWaitForKeyedEvent( HANDLE handle, const void *key,
 
     if (!handle) handle = keyed_event;
     if ((ULONG_PTR)key & 1) return STATUS_INVALID_PARAMETER_1;
+#ifdef __linux__
+    if (handle == keyed_event && use_futexes())
+        return local_keyed_event_op( SELECT_KEYED_EVENT_WAIT, key, alertable, timeout );
+#endif
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.keyed_event.op     = SELECT_KEYED_EVENT_WAIT;
     select_op.keyed_event.handle = wine_server_obj_handle( handle );
@@ -1792,6 +2029,10 @@ NTSTATUS WINAPI NtReleaseKeyedEvent( HANDLE handle, const void *key,
 
     if (!handle) handle = keyed_event;
     if ((ULONG_PTR)key & 1) return STATUS_INVALID_PARAMETER_1;
+#ifdef __linux__
+    if (handle == keyed_event && use_futexes())
+        return local_keyed_event_op( SELECT_KEYED_EVENT_RELEASE, key, alertable, timeout );
+#endif
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.keyed_event.op     = SELECT_KEYED_EVENT_RELEASE;
     select_op.keyed_event.handle = wine_server_obj_handle( handle );
@@ -2489,29 +2730,6 @@ NTSTATUS WINAPI NtAlertThreadByThreadId( HANDLE tid )
 }
 
 
-#if defined(__linux__) || defined(HAVE_KQUEUE)
-static LONGLONG get_absolute_timeout( const LARGE_INTEGER *timeout )
-{
-    LARGE_INTEGER now;
-
-    if (timeout->QuadPart >= 0) return timeout->QuadPart;
-    NtQuerySystemTime( &now );
-    return now.QuadPart - timeout->QuadPart;
-}
-
-static LONGLONG update_timeout( ULONGLONG end )
-{
-    LARGE_INTEGER now;
-    LONGLONG timeleft;
-
-    NtQuerySystemTime( &now );
-    timeleft = end - now.QuadPart;
-    if (timeleft < 0) timeleft = 0;
-    return timeleft;
-}
-#endif
-
-
 #ifdef HAVE_KQUEUE
 
 /***********************************************************************
@@ -2619,6 +2837,115 @@ NTSTATUS WINAPI NtWaitForAlertByThreadId( const void *address, const LARGE_INTEG
 
 #endif
 
+
+/***********************************************************************
+ *           wait_on_address
+ *
+ * Backend for RtlWaitOnAddress(), waiting directly on the user address.
+ * Waiters are keyed by the containing 32-bit word, and by their offset
+ * within it using the futex bitset, so that wakes for other addresses
+ * sharing the word don't affect them. 8-byte values are watched through
+ * both halves with futex_waitv().
+ *
+ * Returns STATUS_NOT_SUPPORTED if the address can't be waited on this way,
+ * and STATUS_NOT_IMPLEMENTED if futexes aren't available at all.
+ */
+NTSTATUS wait_on_address( void *args )
+{
+#ifdef __linux__
+    const struct wait_on_address_params *params = args;
+    ULONG_PTR addr = params->addr;
+    unsigned int offset = addr & 3;
+    const LONG *word = (const LONG *)(addr - offset);
+    LONGLONG end = 0;
+    int ret;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+    if (params->size == 8 ? offset || !use_futex_waitv() : offset + params->size > 4)
+        return STATUS_NOT_SUPPORTED;
+
+    if (!params->infinite)
+    {
+        LARGE_INTEGER timeout = {.QuadPart = params->timeout};
+        end = get_absolute_timeout( &timeout );
+    }
+
+    for (;;)
+    {
+        struct timespec timespec, *abs_timeout = NULL;
+
+        if (!params->infinite)
+        {
+            LONGLONG timeleft = update_timeout( end );
+
+            clock_gettime( CLOCK_MONOTONIC, &timespec );
+            timespec.tv_sec += timeleft / (ULONGLONG)TICKSPERSEC;
+            timespec.tv_nsec += (timeleft % TICKSPERSEC) * 100;
+            if (timespec.tv_nsec >= 1000000000)
+            {
+                timespec.tv_sec++;
+                timespec.tv_nsec -= 1000000000;
+            }
+            abs_timeout = &timespec;
+        }
+
+        if (params->size == 8)
+        {
+            struct futex_waitv futexes[2];
+            ULONG low = ((volatile const LONG *)word)[0], high = ((volatile const LONG *)word)[1];
+
+            if ((((ULONG64)high << 32) | low) != params->value) return STATUS_SUCCESS;
+
+            futexes[0].val = low;
+            futexes[0].uaddr = (ULONG_PTR)word;
+            futexes[0].flags = FUTEX2_SIZE_U32 | futex_private;
+            futexes[0].reserved = 0;
+            futexes[1].val = high;
+            futexes[1].uaddr = (ULONG_PTR)(word + 1);
+            futexes[1].flags = FUTEX2_SIZE_U32 | futex_private;
+            futexes[1].reserved = 0;
+            ret = futex_waitv( futexes, 2, abs_timeout );
+        }
+        else
+        {
+            LONG val = *(volatile const LONG *)word;
+            ULONG mask = params->size == 4 ? ~0u : (1u << (params->size * 8)) - 1;
+
+            if ((((ULONG)val >> (offset * 8)) & mask) != params->value) return STATUS_SUCCESS;
+            ret = futex_wait_bitset( word, val, abs_timeout, 1 << offset );
+        }
+
+        if (ret != -1) return STATUS_SUCCESS;
+        if (errno == ETIMEDOUT) return STATUS_TIMEOUT;
+        /* on EAGAIN another part of the word may have changed, check again */
+        if (errno != EAGAIN && errno != EINTR) return STATUS_SUCCESS;
+    }
+#else
+    return STATUS_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/***********************************************************************
+ *           wake_address
+ *
+ * Wake waiters blocked in wait_on_address().
+ */
+NTSTATUS wake_address( void *args )
+{
+#ifdef __linux__
+    const struct wake_address_params *params = args;
+    ULONG_PTR addr = params->addr;
+    unsigned int offset = addr & 3;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+    futex_wake_bitset( (const LONG *)(addr - offset), params->all ? INT_MAX : 1, 1 << offset );
+    return STATUS_SUCCESS;
+#else
+    return STATUS_NOT_IMPLEMENTED;
+#endif
+}
+
 /* Notify direct completion of async and close the wait handle if it is no longer needed.
  * This function is a no-op (returns status as-is) if the supplied handle is NULL.
  */
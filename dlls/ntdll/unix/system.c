@@ -235,6 +235,7 @@ static SYSTEM_LOGICAL_PROCESSOR_INFORMATION *logical_proc_info;
 static unsigned int logical_proc_info_len, logical_proc_info_alloc_len;
 static SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *logical_proc_info_ex;
 static unsigned int logical_proc_info_ex_size, logical_proc_info_ex_alloc_size;
+static pthread_once_t logical_proc_info_once = PTHREAD_ONCE_INIT;
 
 static pthread_mutex_t timezone_mutex = PTHREAD_MUTEX_INITIALIZER;
 
@@ -899,7 +900,7 @@ static NTSTATUS create_logical_proc_info(void)
     FILE *fcpu_list, *fnuma_list, *f;
     unsigned int beg, end, i, j, r, num_cpus = 0, max_cpus = 0;
     char op, name[MAX_PATH];
-    ULONG_PTR all_cpus_mask = 0;
+    ULONG_PTR all_cpus_mask = 0, cpus_mask = get_system_affinity_mask();
 
     /* On systems with a large number of CPU cores (32 or 64 depending on 32-bit or 64-bit),
      * we have issues parsing processor information:
@@ -936,6 +937,8 @@ static NTSTATUS create_logical_proc_info(void)
                 FIXME("skipping logical processor %d\n", i);
                 continue;
             }
+            /* the processor count may be limited by the cgroup */
+            if (!(cpus_mask & ((ULONG_PTR)1 << i))) continue;
 
             snprintf(name, sizeof(name), core_info, i, "physical_package_id");
             f = fopen(name, "r");
@@ -965,6 +968,7 @@ static NTSTATUS create_logical_proc_info(void)
             /* Mask of logical threads sharing same physical core in kernel core numbering. */
             snprintf(name, sizeof(name), core_info, i, "thread_siblings");
             if(!sysfs_parse_bitmap(name, &thread_mask)) thread_mask = 1<<i;
+            thread_mask &= cpus_mask;
 
             /* Needed later for NumaNode and Group. */
             all_cpus_mask |= thread_mask;
@@ -991,6 +995,7 @@ static NTSTATUS create_logical_proc_info(void)
 
                 snprintf(name, sizeof(name), cache_info, i, j, "shared_cpu_map");
                 if(!sysfs_parse_bitmap(name, &mask)) continue;
+                mask &= cpus_mask;
 
                 snprintf(name, sizeof(name), cache_info, i, j, "level");
                 f = fopen(name, "r");
@@ -1066,7 +1071,7 @@ static NTSTATUS create_logical_proc_info(void)
                 ULONG_PTR mask = 0;
 
                 snprintf(name, sizeof(name), numa_info, i);
-                if (!sysfs_parse_bitmap( name, &mask )) continue;
+                if (!sysfs_parse_bitmap( name, &mask ) || !(mask &= cpus_mask)) continue;
 
                 if (!logical_proc_info_add_numa_node( mask, i ))
                 {
@@ -1230,6 +1235,132 @@ static NTSTATUS create_logical_proc_info(void)
 }
 #endif
 
+/* CPUs usable by the process according to its cgroup limits */
+struct cpu_availability
+{
+    ULONG64      allowed;  /* CPUs in the cgroup cpuset, 0 if unrestricted */
+    unsigned int quota;    /* number of CPUs worth of cgroup CPU bandwidth, 0 if unrestricted */
+};
+
+#ifdef linux
+
+static BOOL read_cgroup_file( const char *dir, const char *name, char *buffer, size_t size )
+{
+    char path[MAX_PATH];
+    FILE *f;
+    BOOL ret;
+
+    snprintf( path, sizeof(path), "%s/%s", dir, name );
+    if (!(f = fopen( path, "r" ))) return FALSE;
+    ret = fgets( buffer, size, f ) != NULL;
+    fclose( f );
+    if (ret) buffer[strcspn( buffer, "\n" )] = 0;
+    return ret;
+}
+
+/* parse a CPU list such as "0-3,8" */
+static ULONG64 parse_cpu_list( const char *str )
+{
+    unsigned int beg, end;
+    ULONG64 mask = 0;
+    char *next;
+
+    for (;;)
+    {
+        beg = end = strtoul( str, &next, 10 );
+        if (next == str) break;
+        if (*next == '-') end = strtoul( next + 1, &next, 10 );
+        for (; beg <= end && beg < 64; beg++) mask |= (ULONG64)1 << beg;
+        if (*next != ',') break;
+        str = next + 1;
+    }
+    return mask;
+}
+
+static unsigned int quota_to_cpus( long long quota, long long period )
+{
+    if (quota <= 0 || period <= 0) return 0;
+    return max( 1, (quota + period - 1) / period );
+}
+
+static void get_cpu_availability( struct cpu_availability *avail )
+{
+    char dir[MAX_PATH], line[1024], *p;
+    long long quota, period;
+    unsigned int cpus;
+    FILE *f;
+
+    avail->allowed = 0;
+    avail->quota = 0;
+
+    /* cgroup v2, walk up the hierarchy since limits of all ancestors apply */
+    dir[0] = 0;
+    if ((f = fopen( "/proc/self/cgroup", "r" )))
+    {
+        while (fgets( line, sizeof(line), f ))
+        {
+            if (strncmp( line, "0::", 3 )) continue;
+            line[strcspn( line, "\n" )] = 0;
+            snprintf( dir, sizeof(dir), "/sys/fs/cgroup%s", line + 3 );
+            break;
+        }
+        fclose( f );
+    }
+
+    if (dir[0])
+    {
+        for (;;)
+        {
+            if (!avail->allowed && read_cgroup_file( dir, "cpuset.cpus.effective", line, sizeof(line) ))
+                avail->allowed = parse_cpu_list( line );
+            if (read_cgroup_file( dir, "cpu.max", line, sizeof(line) ) &&
+                sscanf( line, "%lld %lld", &quota, &period ) == 2 &&
+                (cpus = quota_to_cpus( quota, period )) && (!avail->quota || cpus < avail->quota))
+                avail->quota = cpus;
+            if (!(p = strrchr( dir, '/' )) || p == dir + strlen( "/sys/fs/cgroup" )) break;
+            *p = 0;
+        }
+        return;
+    }
+
+    /* cgroup v1 */
+    if (read_cgroup_file( "/sys/fs/cgroup/cpuset", "cpuset.effective_cpus", line, sizeof(line) ))
+        avail->allowed = parse_cpu_list( line );
+    if (read_cgroup_file( "/sys/fs/cgroup/cpu", "cpu.cfs_quota_us", line, sizeof(line) ) &&
+        sscanf( line, "%lld", &quota ) == 1 &&
+        read_cgroup_file( "/sys/fs/cgroup/cpu", "cpu.cfs_period_us", line, sizeof(line) ) &&
+        sscanf( line, "%lld", &period ) == 1)
+        avail->quota = quota_to_cpus( quota, period );
+}
+
+#else
+
+static void get_cpu_availability( struct cpu_availability *avail )
+{
+    avail->allowed = 0;
+    avail->quota = 0;
+}
+
+#endif
+
+/* Limit the processor count to the cgroup CPU bandwidth quota and cpuset.
+ * Processor numbers map directly to Unix CPU numbers, so the count can't go
+ * below the highest CPU in the cpuset, and it has to include at least one CPU
+ * of the cpuset. The limits are only applied at startup. */
+static unsigned int get_available_cpu_count( unsigned int count, const struct cpu_availability *avail )
+{
+    unsigned int lowest = 0;
+
+    if (avail->allowed)
+    {
+        count = min( count, 64 );
+        while (count > 1 && !(avail->allowed & ((ULONG64)1 << (count - 1)))) count--;
+        while (lowest < count - 1 && !(avail->allowed & ((ULONG64)1 << lowest))) lowest++;
+    }
+    if (avail->quota) count = max( min( count, avail->quota ), lowest + 1 );
+    return count;
+}
+
 /******************************************************************
  *		init_cpu_info
  *
@@ -1240,7 +1371,7 @@ static NTSTATUS create_logical_proc_info(void)
  */
 void init_cpu_info(void)
 {
-    unsigned int status;
+    struct cpu_availability avail;
     long num;
 
 #ifdef _SC_NPROCESSORS_ONLN
@@ -1264,11 +1395,25 @@ void init_cpu_info(void)
     num = 1;
     FIXME("Detecting the number of processors is not supported.\n");
 #endif
-    peb->NumberOfProcessors = num;
+    get_cpu_availability( &avail );
+    peb->NumberOfProcessors = get_available_cpu_count( num, &avail );
+    if (peb->NumberOfProcessors != num)
+        TRACE( "limiting to %d of %ld processors\n", (int)peb->NumberOfProcessors, num );
     get_cpuinfo( &cpu_info );
     TRACE( "<- CPU arch %d, level %d, rev %d, features 0x%x\n",
            (int)cpu_info.ProcessorArchitecture, (int)cpu_info.ProcessorLevel,
            (int)cpu_info.ProcessorRevision, (int)cpu_info.ProcessorFeatureBits );
+}
+
+/******************************************************************
+ *		init_logical_proc_info
+ *
+ * Build the processor topology snapshot on first use, so that
+ * processes which never query it don't pay for parsing sysfs.
+ */
+static void init_logical_proc_info(void)
+{
+    unsigned int status;
 
     if ((status = create_logical_proc_info()))
     {
@@ -1298,6 +1443,7 @@ static NTSTATUS create_cpuset_info(SYSTEM_CPU_SET_INFORMATION *info)
     unsigned int i, j, count;
     ULONG64 cpu_mask;
 
+    pthread_once( &logical_proc_info_once, init_logical_proc_info );
     if (!logical_proc_info_ex) return STATUS_NOT_IMPLEMENTED;
 
     count = peb->NumberOfProcessors;
@@ -1369,6 +1515,63 @@ static NTSTATUS create_cpuset_info(SYSTEM_CPU_SET_INFORMATION *info)
     return STATUS_SUCCESS;
 }
 
+/* Report CPUs outside of the cgroup cpuset or beyond the CPU quota as parked.
+ * The processor count was already limited at startup, but the limits may have
+ * changed since, and a cpuset may leave out CPUs below its highest one. */
+static void apply_cpu_availability( SYSTEM_CPU_SET_INFORMATION *info, unsigned int count,
+                                    const struct cpu_availability *avail )
+{
+    unsigned int i, usable = 0;
+    BOOL parked;
+
+    for (i = 0; i < count; i++)
+    {
+        parked = avail->allowed && (i >= 64 || !(avail->allowed & ((ULONG64)1 << i)));
+        if (!parked && avail->quota && usable++ >= avail->quota) parked = TRUE;
+        info[i].CpuSet.Parked = parked;
+    }
+}
+
+/* the topology part of the CPU set information is built once; cgroup limits
+ * are checked again at most once per second */
+static pthread_mutex_t cpuset_info_mutex = PTHREAD_MUTEX_INITIALIZER;
+static SYSTEM_CPU_SET_INFORMATION *cpuset_info;
+static ULONGLONG cpuset_info_expiry;
+
+static NTSTATUS get_cpuset_info( SYSTEM_CPU_SET_INFORMATION *info )
+{
+    unsigned int count = peb->NumberOfProcessors;
+    struct cpu_availability avail;
+    NTSTATUS status = STATUS_SUCCESS;
+    LARGE_INTEGER now;
+
+    NtQueryPerformanceCounter( &now, NULL );
+
+    mutex_lock( &cpuset_info_mutex );
+    if (!cpuset_info)
+    {
+        if (!(cpuset_info = malloc( count * sizeof(*cpuset_info) ))) status = STATUS_NO_MEMORY;
+        else if ((status = create_cpuset_info( cpuset_info )))
+        {
+            free( cpuset_info );
+            cpuset_info = NULL;
+        }
+        cpuset_info_expiry = 0;
+    }
+    if (!status)
+    {
+        if (now.QuadPart >= cpuset_info_expiry)
+        {
+            get_cpu_availability( &avail );
+            apply_cpu_availability( cpuset_info, count, &avail );
+            cpuset_info_expiry = now.QuadPart + TICKSPERSEC;
+        }
+        memcpy( info, cpuset_info, count * sizeof(*info) );
+    }
+    mutex_unlock( &cpuset_info_mutex );
+    return status;
+}
+
 #if defined(linux) || defined(__APPLE__)
 
 static void copy_smbios_string( char **buffer, const char *s, size_t len )
@@ -1892,7 +2095,17 @@ static NTSTATUS get_firmware_info( SYSTEM_FIRMWARE_TABLE_INFORMATION *sfti, ULON
 
 #endif
 
-static void get_performance_info( SYSTEM_PERFORMANCE_INFORMATION *info )
+/* interval at which the kernel updates the statistics it exports */
+static ULONGLONG get_clock_tick_interval(void)
+{
+    static ULONGLONG interval;
+    long clk_tck;
+
+    if (!interval) interval = (clk_tck = sysconf( _SC_CLK_TCK )) > 0 ? TICKSPERSEC / clk_tck : TICKSPERSEC / 100;
+    return interval;
+}
+
+static void read_performance_info( SYSTEM_PERFORMANCE_INFORMATION *info )
 {
     unsigned long long totalram = 0, freeram = 0, totalswap = 0, freeswap = 0;
 
@@ -2059,6 +2272,94 @@ static void get_performance_info( SYSTEM_PERFORMANCE_INFORMATION *info )
     info->TotalCommitLimit    = (totalram + totalswap) / page_size;
 }
 
+static void get_performance_info( SYSTEM_PERFORMANCE_INFORMATION *info )
+{
+    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    static SYSTEM_PERFORMANCE_INFORMATION cache;
+    static ULONGLONG expiry;
+    LARGE_INTEGER now;
+
+    NtQueryPerformanceCounter( &now, NULL );
+
+    /* don't parse /proc again before the kernel had a chance to update it */
+    mutex_lock( &mutex );
+    if (now.QuadPart >= expiry)
+    {
+        read_performance_info( &cache );
+        expiry = now.QuadPart + get_clock_tick_interval();
+    }
+    *info = cache;
+    mutex_unlock( &mutex );
+}
+
+#ifdef linux
+
+/* per-CPU times from /proc/stat, cached for a clock tick */
+static unsigned int get_cpu_times( SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION *info, unsigned int count )
+{
+    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    static SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION *cache;
+    static unsigned int cache_count, cache_size;
+    static ULONGLONG expiry;
+    LARGE_INTEGER now;
+
+    NtQueryPerformanceCounter( &now, NULL );
+
+    mutex_lock( &mutex );
+    if (now.QuadPart >= expiry)
+    {
+        FILE *cpuinfo = fopen("/proc/stat", "r");
+
+        cache_count = 0;
+        if (cpuinfo)
+        {
+            unsigned long clk_tck = sysconf(_SC_CLK_TCK);
+            unsigned long usr,nice,sys,idle,remainder[8];
+            unsigned int i, id;
+            int ret;
+            char name[32];
+            char line[255];
+
+            while (fgets(line,255,cpuinfo))
+            {
+                ret = sscanf(line, "%31s %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu",
+                             name, &usr, &nice, &sys, &idle,
+                             &remainder[0], &remainder[1], &remainder[2], &remainder[3],
+                             &remainder[4], &remainder[5], &remainder[6], &remainder[7]);
+
+                if (ret < 5 || strncmp( name, "cpu", 3 )) break;
+                if (!name[3]) continue;  /* first line is combined usage */
+                for (i = 0; i + 5 < ret; ++i) sys += remainder[i];
+                sys += idle;
+                usr += nice;
+                id = atoi( name + 3 );
+                if (id >= cache_size)
+                {
+                    unsigned int new_size = max( id + 1, cache_size * 2 );
+                    SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION *new_cache;
+
+                    if (!(new_cache = realloc( cache, new_size * sizeof(*cache) ))) break;
+                    memset( new_cache + cache_size, 0, (new_size - cache_size) * sizeof(*cache) );
+                    cache = new_cache;
+                    cache_size = new_size;
+                }
+                if (id + 1 > cache_count) cache_count = id + 1;
+                cache[id].IdleTime.QuadPart   = (ULONGLONG)idle * 10000000 / clk_tck;
+                cache[id].KernelTime.QuadPart = (ULONGLONG)sys * 10000000 / clk_tck;
+                cache[id].UserTime.QuadPart   = (ULONGLONG)usr * 10000000 / clk_tck;
+            }
+            fclose(cpuinfo);
+        }
+        expiry = now.QuadPart + get_clock_tick_interval();
+    }
+    count = min( count, cache_count );
+    memcpy( info, cache, count * sizeof(*info) );
+    mutex_unlock( &mutex );
+    return count;
+}
+
+#endif
+
 
 /* calculate the mday of dst change date, so that for instance Sun 5 Oct 2007
  * (last Sunday in October of 2007) becomes Sun Oct 28 2007
@@ -2725,38 +3026,7 @@ NTSTATUS WINAPI NtQuerySystemInformation( SYSTEM_INFORMATION_CLASS class,
             mach_port_deallocate (mach_task_self (), host);
         }
 #elif defined(linux)
-        {
-            FILE *cpuinfo = fopen("/proc/stat", "r");
-            if (cpuinfo)
-            {
-                unsigned long clk_tck = sysconf(_SC_CLK_TCK);
-                unsigned long usr,nice,sys,idle,remainder[8];
-                int i, count, id;
-                char name[32];
-                char line[255];
-
-                /* first line is combined usage */
-                while (fgets(line,255,cpuinfo))
-                {
-                    count = sscanf(line, "%s %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu",
-                                   name, &usr, &nice, &sys, &idle,
-                                   &remainder[0], &remainder[1], &remainder[2], &remainder[3],
-                                   &remainder[4], &remainder[5], &remainder[6], &remainder[7]);
-
-                    if (count < 5 || strncmp( name, "cpu", 3 )) break;
-                    for (i = 0; i + 5 < count; ++i) sys += remainder[i];
-                    sys += idle;
-                    usr += nice;
-                    id = atoi( name + 3 ) + 1;
-                    if (id > out_cpus) break;
-                    if (id > cpus) cpus = id;
-                    sppi[id-1].IdleTime.QuadPart   = (ULONGLONG)idle * 10000000 / clk_tck;
-                    sppi[id-1].KernelTime.QuadPart = (ULONGLONG)sys * 10000000 / clk_tck;
-                    sppi[id-1].UserTime.QuadPart   = (ULONGLONG)usr * 10000000 / clk_tck;
-                }
-                fclose(cpuinfo);
-            }
-        }
+        cpus = get_cpu_times( sppi, out_cpus );
 #elif defined(__FreeBSD__) || defined (__FreeBSD_kernel__)
         {
             static int clockrate_name[] = { CTL_KERN, KERN_CLOCKRATE };
@@ -3121,6 +3391,7 @@ NTSTATUS WINAPI NtQuerySystemInformation( SYSTEM_INFORMATION_CLASS class,
 
     case SystemLogicalProcessorInformation:  /* 73 */
     {
+        pthread_once( &logical_proc_info_once, init_logical_proc_info );
         if (!logical_proc_info)
         {
             ret = STATUS_NOT_IMPLEMENTED;
@@ -3314,6 +3585,7 @@ NTSTATUS WINAPI NtQuerySystemInformationEx( SYSTEM_INFORMATION_CLASS class,
             ret = STATUS_INVALID_PARAMETER;
             break;
         }
+        pthread_once( &logical_proc_info_once, init_logical_proc_info );
         if (!logical_proc_info_ex)
         {
             ret = STATUS_NOT_IMPLEMENTED;
@@ -3358,7 +3630,7 @@ NTSTATUS WINAPI NtQuerySystemInformationEx( SYSTEM_INFORMATION_CLASS class,
         if (!info)
             return STATUS_ACCESS_VIOLATION;
 
-        if ((ret = create_cpuset_info(info)))
+        if ((ret = get_cpuset_info( info )))
             return ret;
         break;
     }
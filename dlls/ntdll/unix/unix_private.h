@@ -101,6 +101,8 @@ struct ntdll_thread_data
     PRTL_THREAD_START_ROUTINE start;  /* thread entry point */
     void              *param;         /* thread entry point parameter */
     void              *jmp_buf;       /* setjmp buffer for exception handling */
+    void              *syscall_stats; /* syscall statistics, see record_syscall_stats */
+    void              *keyed_waiter;  /* queued waiter on the default keyed event, see local_keyed_event_op */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -225,6 +227,10 @@ extern NTSTATUS get_thread_context( HANDLE handle, void *context, BOOL *self, US
 extern unsigned int alloc_object_attributes( const OBJECT_ATTRIBUTES *attr, struct object_attributes **ret,
                                              data_size_t *ret_len );
 extern NTSTATUS system_time_precise( void *args );
+extern NTSTATUS wait_on_address( void *args );
+extern NTSTATUS wake_address( void *args );
+extern void exit_keyed_event_wait(void);
+extern NTSTATUS get_runtime_stats( void *args );
 
 extern void *anon_mmap_fixed( void *start, size_t size, int prot, int flags );
 extern void *anon_mmap_alloc( size_t size, int prot );
@@ -248,6 +254,7 @@ extern NTSTATUS virtual_alloc_thread_stack( INITIAL_TEB *stack, ULONG_PTR limit_
                                             SIZE_T reserve_size, SIZE_T commit_size, BOOL guard_page );
 extern void virtual_map_user_shared_data(void);
 extern NTSTATUS virtual_handle_fault( void *addr, DWORD err, void *stack );
+extern unsigned int virtual_get_view_count(void);
 extern unsigned int virtual_locked_server_call( void *req_ptr );
 extern ssize_t virtual_locked_read( int fd, void *addr, size_t size );
 extern ssize_t virtual_locked_pread( int fd, void *addr, size_t size, off_t offset );
@@ -278,6 +285,10 @@ extern void signal_init_process(void);
 extern void DECLSPEC_NORETURN signal_start_thread( PRTL_THREAD_START_ROUTINE entry, void *arg,
                                                    BOOL suspend, TEB *teb );
 extern SYSTEM_SERVICE_TABLE KeServiceDescriptorTable[4];
+extern void init_syscall_stats( ULONG64 frequency );
+extern void record_syscall_stats( const SYSTEM_SERVICE_TABLE *table, ULONG id, ULONG64 ticks );
+extern void free_syscall_stats( struct ntdll_thread_data *thread_data );
+extern NTSTATUS dump_syscall_stats( void *args );
 extern void __wine_syscall_dispatcher(void);
 extern void DECLSPEC_NORETURN __wine_syscall_dispatcher_return( void *frame, ULONG_PTR retval );
 extern void __wine_unix_call_dispatcher(void);
@@ -300,6 +311,8 @@ extern NTSTATUS sock_read( HANDLE handle, int fd, HANDLE event, PIO_APC_ROUTINE
                            IO_STATUS_BLOCK *io, void *buffer, ULONG length );
 extern NTSTATUS sock_write( HANDLE handle, int fd, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
                             IO_STATUS_BLOCK *io, const void *buffer, ULONG length );
+extern void sock_release_recv_batch( HANDLE handle );
+extern void reg_cache_close_handle( HANDLE handle );
 extern NTSTATUS tape_DeviceIoControl( HANDLE device, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
                                       IO_STATUS_BLOCK *io, UINT code, void *in_buffer,
                                       UINT in_size, void *out_buffer, UINT out_size );
@@ -150,6 +150,7 @@ static const BYTE VIRTUAL_Win32Flags[16] =
 };
 
 static struct wine_rb_tree views_tree;
+static unsigned int view_count;  /* number of views in views_tree */
 static pthread_mutex_t virtual_mutex;
 
 static const UINT page_shift = 12;
@@ -1530,6 +1531,7 @@ static void unregister_view( struct file_view *view )
     if (mmap_is_in_reserved_area( view->base, view->size ))
         free_ranges_remove_view( view );
     wine_rb_remove( &views_tree, &view->entry );
+    view_count--;
 }
 
 
@@ -1556,6 +1558,7 @@ static void delete_view( struct file_view *view ) /* [in] View */
 static void register_view( struct file_view *view )
 {
     wine_rb_put( &views_tree, view->base, &view->entry );
+    view_count++;
     if (mmap_is_in_reserved_area( view->base, view->size ))
         free_ranges_insert_view( view );
 }
@@ -3717,6 +3720,7 @@ void virtual_free_teb( TEB *teb )
     WOW_TEB *wow_teb = get_wow_teb( teb );
 
     signal_free_thread( teb );
+    free_syscall_stats( thread_data );
     if (teb->DeallocationStack)
     {
         size = 0;
@@ -4062,6 +4066,15 @@ static NTSTATUS check_write_access( void *base, size_t size, BOOL *has_write_wat
 }
 
 
+/***********************************************************************
+ *           virtual_get_view_count
+ */
+unsigned int virtual_get_view_count(void)
+{
+    return view_count;
+}
+
+
 /***********************************************************************
  *           virtual_locked_server_call
  */
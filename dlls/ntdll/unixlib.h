@@ -66,6 +66,34 @@ struct unwind_builtin_dll_params
     CONTEXT                    *context;
 };
 
+struct wait_on_address_params
+{
+    ULONG64                     addr;
+    ULONG64                     value;
+    ULONG                       size;
+    BOOL                        infinite;
+    LONGLONG                    timeout;
+};
+
+struct wake_address_params
+{
+    ULONG64                     addr;
+    BOOL                        all;
+};
+
+/* Leaf syscalls that ntdll can also call through the unix call dispatcher,
+ * which skips the full syscall frame setup. They must not block, call back
+ * into PE code, deliver APCs or use the floating point state; the syscall
+ * dispatcher relies on the latter as well. Arguments are pointers, passed as
+ * an array of ULONG64 so that the same entry point works for wow64.
+ * NtQuerySystemTime() and NtYieldExecution() have no caller inside ntdll yet;
+ * they are listed so that the dispatcher treats them as leaf syscalls. */
+#define ALL_FAST_SYSCALLS \
+    FAST_SYSCALL( NtGetCurrentProcessorNumber, 0 ) \
+    FAST_SYSCALL( NtQueryPerformanceCounter, 2 ) \
+    FAST_SYSCALL( NtQuerySystemTime, 1 ) \
+    FAST_SYSCALL( NtYieldExecution, 0 )
+
 enum ntdll_unix_funcs
 {
     unix_load_so_dll,
@@ -76,6 +104,13 @@ enum ntdll_unix_funcs
     unix_wine_server_handle_to_fd,
     unix_wine_spawnvp,
     unix_system_time_precise,
+    unix_wait_on_address,
+    unix_wake_address,
+    unix_get_runtime_stats,
+    unix_dump_syscall_stats,
+#define FAST_SYSCALL(name,args) unix_fast_##name,
+    ALL_FAST_SYSCALLS
+#undef FAST_SYSCALL
 };
 
 extern unixlib_handle_t __wine_unixlib_handle;
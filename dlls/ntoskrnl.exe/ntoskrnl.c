@@ -920,16 +920,98 @@ static void unload_driver( struct wine_rb_entry *entry, void *context )
 
 PEPROCESS PsInitialSystemProcess = NULL;
 
+/* dispatched irp whose result has to be reported to the server */
+struct dispatch_result
+{
+    HANDLE           handle;    /* irp handle if not consumed by the dispatch function */
+    struct irp_data *irp_data;
+    NTSTATUS         status;    /* status returned by the dispatch function */
+};
+
+/* number of irps fetched by each get_next_device_request call, raised by WINEDEVICEBATCH
+ * and by the DeviceRequestBatch value of the services of the loaded drivers */
+static unsigned int device_request_batch = 1;
+
+static void set_device_request_batch( unsigned int count )
+{
+    count = min( count, MAX_DEVICE_REQUEST_BATCH );
+    if (count > device_request_batch)
+    {
+        TRACE( "fetching up to %u requests at a time\n", count );
+        device_request_batch = count;
+    }
+}
+
+/* build the irp_result_t array sent back to the server; irp_completion_cs must be held */
+static void *get_irp_results( const struct dispatch_result *results, unsigned int count, data_size_t *ret_size )
+{
+    data_size_t size = 0, out_size;
+    irp_result_t *result;
+    unsigned int i;
+    char *buffer;
+
+    for (i = 0; i < count; i++)
+    {
+        out_size = 0;
+        if (results[i].irp_data && results[i].irp_data->complete)
+            out_size = get_irp_output_size( results[i].irp_data->irp );
+        size += sizeof(*result) + ((out_size + 7) & ~7);
+    }
+
+    if (!(buffer = calloc( 1, size ))) return NULL;
+
+    for (i = 0, size = 0; i < count; i++)
+    {
+        struct irp_data *irp_data = results[i].irp_data;
+
+        result = (irp_result_t *)(buffer + size);
+        result->handle = wine_server_obj_handle( results[i].handle );
+        result->status = results[i].status;
+        size += sizeof(*result);
+
+        if (!irp_data) continue;
+
+        result->user_ptr = wine_server_client_ptr( irp_data->irp );
+        if (irp_data->complete)
+        {
+            /* IRP completed even before we got here; we can report completion now */
+            IRP *irp = irp_data->irp;
+
+            result->handle      = wine_server_obj_handle( irp_data->handle );
+            result->pending     = irp->PendingReturned;
+            result->iosb_status = irp->IoStatus.Status;
+            result->result      = irp->IoStatus.Information;
+            result->size        = get_irp_output_size( irp );
+            if (result->size) memcpy( result + 1, irp->UserBuffer, result->size );
+            size += (result->size + 7) & ~7;
+        }
+        else
+        {
+            result->pending = 1;
+        }
+    }
+
+    *ret_size = size;
+    return buffer;
+}
+
 /***********************************************************************
  *           wine_ntoskrnl_main_loop   (Not a Windows API)
  */
 NTSTATUS CDECL wine_ntoskrnl_main_loop( HANDLE stop_event )
 {
     HANDLE manager = get_device_manager();
-    struct dispatch_context context = {.in_size = 4096};
+    struct dispatch_result results[MAX_DEVICE_REQUEST_BATCH];
+    unsigned int i, count = 0, result_count = 0;
+    data_size_t results_size, buff_size = 4096;
+    void *buff = NULL, *results_buff;
+    char *ptr;
     NTSTATUS status = STATUS_SUCCESS;
     struct wine_driver *driver;
     HANDLE handles[2];
+    const char *env;
+
+    if ((env = getenv( "WINEDEVICEBATCH" ))) set_device_request_batch( atoi( env ));
 
     /* Set the system process global before setting up the request thread trickery  */
     PsInitialSystemProcess = IoGetCurrentProcess();
@@ -943,7 +1025,7 @@ NTSTATUS CDECL wine_ntoskrnl_main_loop( HANDLE stop_event )
     for (;;)
     {
         NtCurrentTeb()->Instrumentation[1] = NULL;
-        if (!context.in_buff && !(context.in_buff = HeapAlloc( GetProcessHeap(), 0, context.in_size )))
+        if (!buff && !(buff = HeapAlloc( GetProcessHeap(), 0, buff_size )))
         {
             ERR( "failed to allocate buffer\n" );
             status = STATUS_NO_MEMORY;
@@ -952,86 +1034,102 @@ NTSTATUS CDECL wine_ntoskrnl_main_loop( HANDLE stop_event )
 
         EnterCriticalSection( &irp_completion_cs );
 
-        SERVER_START_REQ( get_next_device_request )
+        results_buff = NULL;
+        results_size = 0;
+        if (result_count && !(results_buff = get_irp_results( results, result_count, &results_size )))
         {
-            req->manager  = wine_server_obj_handle( manager );
-            req->prev     = wine_server_obj_handle( context.handle );
-
-            if (context.irp_data)
-            {
-                IRP *irp = context.irp_data->irp;
-
-                req->user_ptr = wine_server_client_ptr( irp );
-                req->status   = status;
-
-                if (context.irp_data->complete)
-                {
-                    /* IRP completed even before we got here; we can report completion now */
-                    unsigned int out_size = get_irp_output_size( irp );
-
-                    req->prev        = wine_server_obj_handle( context.irp_data->handle );
-                    req->pending     = irp->PendingReturned;
-                    req->iosb_status = irp->IoStatus.Status;
-                    req->result      = irp->IoStatus.Information;
-                    if (out_size) wine_server_add_data( req, irp->UserBuffer, out_size );
-                }
-                else
-                {
-                    req->pending     = 1;
-                }
-            }
-            else
-            {
-                req->user_ptr = 0;
-                req->status   = status;
-            }
+            LeaveCriticalSection( &irp_completion_cs );
+            ERR( "failed to allocate buffer\n" );
+            HeapFree( GetProcessHeap(), 0, buff );
+            status = STATUS_NO_MEMORY;
+            goto done;
+        }
 
-            wine_server_set_reply( req, context.in_buff, context.in_size );
+        SERVER_START_REQ( get_next_device_request )
+        {
+            req->manager   = wine_server_obj_handle( manager );
+            req->max_count = device_request_batch;
+            wine_server_add_data( req, results_buff, results_size );
+            wine_server_set_reply( req, buff, buff_size );
             if (!(status = wine_server_call( req )))
-            {
-                context.handle  = wine_server_ptr_handle( reply->next );
-                context.params  = reply->params;
-                context.in_size = reply->in_size;
-                client_tid = reply->client_tid;
-                NtCurrentTeb()->Instrumentation[1] = wine_server_get_ptr( reply->client_thread );
-            }
-            else
-            {
-                context.handle = 0; /* no previous irp */
-                if (status == STATUS_BUFFER_OVERFLOW)
-                    context.in_size = reply->in_size;
-            }
+                count = reply->count;
+            else if (status == STATUS_BUFFER_OVERFLOW)
+                buff_size = reply->in_size;
         }
         SERVER_END_REQ;
 
-        if (context.irp_data)
+        free( results_buff );
+
+        for (i = 0; i < result_count; i++)
         {
-            if (context.irp_data->complete)
+            struct irp_data *irp_data = results[i].irp_data;
+
+            if (!irp_data) continue;
+            if (irp_data->complete)
             {
-                IRP *irp = context.irp_data->irp;
-                free_dispatch_irp( context.irp_data );
+                IRP *irp = irp_data->irp;
+                free_dispatch_irp( irp_data );
                 IoCompleteRequest( irp, IO_NO_INCREMENT );
             }
             else
             {
-                context.irp_data->async = TRUE;
+                irp_data->async = TRUE;
             }
         }
 
         LeaveCriticalSection( &irp_completion_cs );
 
-        context.irp_data = NULL;
+        result_count = 0;
 
         switch (status)
         {
         case STATUS_SUCCESS:
-            assert( context.params.type != IRP_CALL_NONE && context.params.type < ARRAY_SIZE(dispatch_funcs) );
-            status = dispatch_funcs[context.params.type]( &context );
-            if (!context.in_buff) context.in_size = 4096;
+            ptr = buff;
+            for (i = 0; i < count; i++)
+            {
+                irp_request_t *next = (irp_request_t *)ptr;
+                struct dispatch_context context;
+
+                context.params   = next->params;
+                context.handle   = wine_server_ptr_handle( next->handle );
+                context.irp_data = NULL;
+                context.in_size  = next->in_size;
+                client_tid = next->client_tid;
+                NtCurrentTeb()->Instrumentation[1] = wine_server_get_ptr( next->client_thread );
+
+                if (i == count - 1)
+                {
+                    /* the last irp takes over the reply buffer */
+                    memmove( buff, next + 1, context.in_size );
+                    context.in_buff = buff;
+                }
+                else
+                {
+                    if ((context.in_buff = HeapAlloc( GetProcessHeap(), 0, context.in_size )))
+                        memcpy( context.in_buff, next + 1, context.in_size );
+                    ptr += sizeof(*next) + ((context.in_size + 7) & ~7);
+                }
+
+                assert( context.params.type != IRP_CALL_NONE && context.params.type < ARRAY_SIZE(dispatch_funcs) );
+                if (context.in_buff) status = dispatch_funcs[context.params.type]( &context );
+                else status = STATUS_NO_MEMORY;
+
+                results[result_count].handle   = context.handle;
+                results[result_count].irp_data = context.irp_data;
+                results[result_count].status   = status;
+                result_count++;
+
+                if (i < count - 1) HeapFree( GetProcessHeap(), 0, context.in_buff );
+                else if (!context.in_buff)
+                {
+                    buff = NULL;
+                    buff_size = 4096;
+                }
+            }
             break;
         case STATUS_BUFFER_OVERFLOW:
-            HeapFree( GetProcessHeap(), 0, context.in_buff );
-            context.in_buff = NULL;
+            HeapFree( GetProcessHeap(), 0, buff );
+            buff = NULL;
             /* restart with larger buffer */
             break;
         case STATUS_PENDING:
@@ -1040,7 +1138,7 @@ NTSTATUS CDECL wine_ntoskrnl_main_loop( HANDLE stop_event )
                 DWORD ret = WaitForMultipleObjectsEx( 2, handles, FALSE, INFINITE, TRUE );
                 if (ret == WAIT_OBJECT_0)
                 {
-                    HeapFree( GetProcessHeap(), 0, context.in_buff );
+                    HeapFree( GetProcessHeap(), 0, buff );
                     status = STATUS_SUCCESS;
                     goto done;
                 }
@@ -3878,7 +3976,7 @@ static HMODULE load_driver( const WCHAR *driver_name, const UNICODE_STRING *keyn
     HKEY driver_hkey;
     HMODULE module;
     LPWSTR path = NULL, str;
-    DWORD type, size;
+    DWORD type, size, batch;
 
     if (RegOpenKeyW( HKEY_LOCAL_MACHINE, keyname->Buffer + 18 /* skip \registry\machine */, &driver_hkey ))
     {
@@ -3886,6 +3984,11 @@ static HMODULE load_driver( const WCHAR *driver_name, const UNICODE_STRING *keyn
         return NULL;
     }
 
+    size = sizeof(batch);
+    if (!RegQueryValueExW( driver_hkey, L"DeviceRequestBatch", NULL, &type, (BYTE *)&batch, &size ) &&
+            type == REG_DWORD)
+        set_device_request_batch( batch );
+
     /* read the executable path from memory */
     size = 0;
     if (!RegQueryValueExW( driver_hkey, ImagePathW, NULL, &type, NULL, &size ))
@@ -1147,6 +1147,92 @@ static void test_blocking_irp(void)
     CloseHandle(file);
 }
 
+static void check_queued_ioctls(void)
+{
+    struct return_status_params params[16];
+    OVERLAPPED ovl[16];
+    char buf[16][32];
+    unsigned int i, j;
+    DWORD size;
+    HANDLE file;
+    BOOL ret;
+
+    file = CreateFileA("\\\\.\\WineTestDriver", 0, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to open device: %lu\n", GetLastError());
+
+    for (j = 0; j < ARRAY_SIZE(ovl); j++)
+    {
+        memset(&ovl[j], 0, sizeof(ovl[j]));
+        ovl[j].hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        params[j].pending = (j % 4 == 1);
+        params[j].ret_status = params[j].pending ? STATUS_PENDING : STATUS_SUCCESS;
+        params[j].iosb_status = STATUS_SUCCESS;
+    }
+
+    /* keep several different requests queued, so that the driver can pick them
+     * up together; each of them must still get its own input and results */
+    for (i = 0; i < 4; i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(ovl); j++)
+        {
+            strcpy(buf[j], "abcdef");
+            if (j % 2)
+                ret = DeviceIoControl(file, IOCTL_WINETEST_RETURN_STATUS_BUFFERED, &params[j], sizeof(params[j]),
+                                      buf[j], 7, NULL, &ovl[j]);
+            else
+                ret = DeviceIoControl(file, IOCTL_WINETEST_BASIC_IOCTL, NULL, 0, buf[j], sizeof(buf[j]), NULL, &ovl[j]);
+            ok(ret || GetLastError() == ERROR_IO_PENDING, "DeviceIoControl failed: %lu\n", GetLastError());
+        }
+        for (j = 0; j < ARRAY_SIZE(ovl); j++)
+        {
+            ret = GetOverlappedResult(file, &ovl[j], &size, TRUE);
+            ok(ret, "%u: GetOverlappedResult failed: %lu\n", j, GetLastError());
+            ok(ovl[j].Internal == STATUS_SUCCESS, "%u: got status %#Ix\n", j, ovl[j].Internal);
+            if (j % 2)
+            {
+                ok(size == 3, "%u: got size %lu\n", j, size);
+                ok(!strcmp(buf[j], "ghidef"), "%u: got '%s'\n", j, buf[j]);
+            }
+            else
+            {
+                ok(size == sizeof(teststr), "%u: got size %lu\n", j, size);
+                ok(!strcmp(buf[j], teststr), "%u: got '%s'\n", j, buf[j]);
+            }
+        }
+    }
+
+    for (j = 0; j < ARRAY_SIZE(ovl); j++) CloseHandle(ovl[j].hEvent);
+    CloseHandle(file);
+}
+
+static void test_queued_ioctls(void)
+{
+    DWORD batch = 16, sz;
+    BOOL load, res;
+    HKEY key;
+    LONG ret;
+
+    check_queued_ioctls();
+
+    /* Wine fetches several requests at a time once a driver whose service
+     * asks for it is loaded; Windows ignores the value */
+    ret = RegOpenKeyExA(HKEY_LOCAL_MACHINE, "System\\CurrentControlSet\\Services\\WineTestDriver2",
+                        0, KEY_SET_VALUE, &key);
+    ok(!ret, "RegOpenKeyEx failed: %ld\n", ret);
+    ret = RegSetValueExA(key, "DeviceRequestBatch", 0, REG_DWORD, (BYTE *)&batch, sizeof(batch));
+    ok(!ret, "RegSetValueEx failed: %ld\n", ret);
+    RegCloseKey(key);
+
+    load = TRUE;
+    res = DeviceIoControl(device, IOCTL_WINETEST_LOAD_DRIVER, &load, sizeof(load), NULL, 0, &sz, NULL);
+    ok(res, "DeviceIoControl failed: %lu\n", GetLastError());
+    load = FALSE;
+    res = DeviceIoControl(device, IOCTL_WINETEST_LOAD_DRIVER, &load, sizeof(load), NULL, 0, &sz, NULL);
+    ok(res, "DeviceIoControl failed: %lu\n", GetLastError());
+
+    check_queued_ioctls();
+}
+
 static void test_driver3(struct testsign_context *ctx)
 {
     WCHAR filename[MAX_PATH];
@@ -1953,6 +2039,7 @@ START_TEST(ntoskrnl)
     test_return_status();
     test_object_info();
     test_blocking_irp();
+    test_queued_ioctls();
 
     /* We need a separate ioctl to call IoDetachDevice(); calling it in the
      * driver unload routine causes a live-lock. */
@@ -2210,6 +2210,15 @@ static void test_TreatAsClass(void)
         return;
     }
 
+    /* a class written to the registry by the process is found right away */
+    lr = RegSetValueA(deadbeefkey, "TreatAs", REG_SZ, "{79EAC9E7-BAF9-11CE-8C82-00AA004BA90B}", 0);
+    ok(!lr, "Couldn't set TreatAs value, error %ld\n", lr);
+    hr = CoGetTreatAsClass(&deadbeef, &out);
+    ok(hr == S_OK, "CoGetTreatAsClass failed: %08lx\n", hr);
+    ok(IsEqualGUID(&out, &CLSID_FileProtocol), "expected to get substituted clsid\n");
+    lr = RegDeleteKeyA(deadbeefkey, "TreatAs");
+    ok(!lr, "Couldn't delete TreatAs key, error %ld\n", lr);
+
     hr = CoTreatAsClass(&deadbeef, &deadbeef);
     ok(hr == REGDB_E_WRITEREGDB, "CoTreatAsClass gave wrong error: %08lx\n", hr);
 
@@ -2224,6 +2233,18 @@ static void test_TreatAsClass(void)
     ok(hr == S_OK, "CoGetTreatAsClass failed: %08lx\n",hr);
     ok(IsEqualGUID(&out, &CLSID_FileProtocol), "expected to get substituted clsid\n");
 
+    hr = CoTreatAsClass(&deadbeef, &CLSID_InternetZoneManager);
+    ok(hr == S_OK, "CoTreatAsClass failed: %08lx\n", hr);
+    hr = CoGetTreatAsClass(&deadbeef, &out);
+    ok(hr == S_OK, "CoGetTreatAsClass failed: %08lx\n", hr);
+    ok(IsEqualGUID(&out, &CLSID_InternetZoneManager), "expected to get substituted clsid\n");
+
+    hr = CoTreatAsClass(&deadbeef, &CLSID_FileProtocol);
+    ok(hr == S_OK, "CoTreatAsClass failed: %08lx\n", hr);
+    hr = CoGetTreatAsClass(&deadbeef, &out);
+    ok(hr == S_OK, "CoGetTreatAsClass failed: %08lx\n", hr);
+    ok(IsEqualGUID(&out, &CLSID_FileProtocol), "expected to get substituted clsid\n");
+
     OleInitialize(NULL);
 
     hr = CoCreateInstance(&deadbeef, NULL, CLSCTX_INPROC_SERVER, &IID_IInternetProtocol, (void **)&pIP);
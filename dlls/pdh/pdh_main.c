@@ -32,6 +32,7 @@
 
 #include "wine/debug.h"
 #include "wine/list.h"
+#include "wine/perfstats.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(pdh);
 
@@ -76,6 +77,8 @@ struct counter
     DWORD_PTR       queryuser;                      /* query user data */
     LONGLONG        base;                           /* samples per second */
     FILETIME        stamp;                          /* time stamp */
+    LONGLONG        sample_time;                    /* performance counter at previous sample */
+    DWORD           instance;                       /* instance index */
     void (CALLBACK *collect)( struct counter * );   /* collect callback */
     union value     one;                            /* first value */
     union value     two;                            /* second value */
@@ -165,11 +168,114 @@ static void CALLBACK collect_uptime( struct counter *counter )
 #define TYPE_UPTIME \
     (PERF_SIZE_LARGE | PERF_TYPE_COUNTER | PERF_COUNTER_ELAPSED | PERF_OBJECT_TIMER | PERF_DISPLAY_SECONDS)
 
+/* Wine runtime statistics, shared by all counters collected in the same pass */
+static struct wine_runtime_stats *wine_stats;
+static DWORD wine_stats_serial, collect_serial;
+
+static const struct wine_runtime_stats *get_wine_stats(void)
+{
+    static NTSTATUS (WINAPI *p__wine_get_runtime_stats)( struct wine_runtime_stats *, ULONG );
+
+    if (wine_stats && wine_stats_serial == collect_serial) return wine_stats;
+
+    if (!p__wine_get_runtime_stats)
+        p__wine_get_runtime_stats = (void *)GetProcAddress( GetModuleHandleW( L"ntdll.dll" ),
+                                                            "__wine_get_runtime_stats" );
+    if (!p__wine_get_runtime_stats) return NULL;
+    if (!wine_stats && !(wine_stats = malloc( sizeof(*wine_stats) ))) return NULL;
+    if (p__wine_get_runtime_stats( wine_stats, sizeof(*wine_stats) )) return NULL;
+
+    wine_stats_serial = collect_serial;
+    return wine_stats;
+}
+
+static void set_raw_value( struct counter *counter, LONGLONG value )
+{
+    counter->two.largevalue = value;
+    counter->status = PDH_CSTATUS_VALID_DATA;
+}
+
+/* compute a per second rate from two consecutive samples */
+static void set_rate_value( struct counter *counter, LONGLONG count )
+{
+    LARGE_INTEGER now, freq;
+
+    QueryPerformanceCounter( &now );
+    QueryPerformanceFrequency( &freq );
+
+    if (counter->sample_time && now.QuadPart > counter->sample_time)
+    {
+        counter->two.largevalue = (count - counter->one.largevalue) * freq.QuadPart /
+                                  (now.QuadPart - counter->sample_time);
+        counter->status = PDH_CSTATUS_VALID_DATA;
+    }
+    else counter->status = PDH_CSTATUS_INVALID_DATA;
+
+    counter->one.largevalue = count;
+    counter->sample_time = now.QuadPart;
+}
+
+static void CALLBACK collect_wine_server_requests( struct counter *counter )
+{
+    const struct wine_runtime_stats *stats;
+    LONGLONG count = 0;
+    unsigned int i;
+
+    if (!(stats = get_wine_stats())) counter->status = PDH_CSTATUS_NO_OBJECT;
+    else if (counter->instance < WINE_STATS_MAX_REQUESTS)
+        set_rate_value( counter, stats->server_requests[counter->instance] );
+    else
+    {
+        for (i = 0; i < WINE_STATS_MAX_REQUESTS; i++) count += stats->server_requests[i];
+        set_rate_value( counter, count );
+    }
+}
+
+#define DEFINE_WINE_COLLECT( name, expr, set ) \
+    static void CALLBACK collect_wine_##name( struct counter *counter ) \
+    { \
+        const struct wine_runtime_stats *stats; \
+        if (!(stats = get_wine_stats())) counter->status = PDH_CSTATUS_NO_OBJECT; \
+        else set( counter, expr ); \
+    }
+
+DEFINE_WINE_COLLECT( heap_committed,   stats->heap_committed,            set_raw_value )
+DEFINE_WINE_COLLECT( heap_free,        stats->heap_free,                 set_raw_value )
+DEFINE_WINE_COLLECT( heap_allocs,      stats->heap_allocs,               set_rate_value )
+DEFINE_WINE_COLLECT( heap_lfh_percent, stats->heap_allocs ? stats->heap_lfh_allocs * 100 / stats->heap_allocs : 0,
+                     set_raw_value )
+DEFINE_WINE_COLLECT( tp_workers,       stats->threadpool_workers,        set_raw_value )
+DEFINE_WINE_COLLECT( tp_busy_workers,  stats->threadpool_busy_workers,   set_raw_value )
+DEFINE_WINE_COLLECT( tp_queued,        stats->threadpool_queued,         set_raw_value )
+DEFINE_WINE_COLLECT( virtual_views,    stats->virtual_views,             set_raw_value )
+
+#define TYPE_WINE_RATE \
+    (PERF_SIZE_LARGE | PERF_TYPE_COUNTER | PERF_COUNTER_RATE | PERF_TIMER_TICK | PERF_DELTA_COUNTER | \
+     PERF_DISPLAY_PER_SEC)
+
+#define TYPE_WINE_NUMBER \
+    (PERF_SIZE_LARGE | PERF_TYPE_NUMBER | PERF_NUMBER_DECIMAL | PERF_DISPLAY_NO_SUFFIX)
+
+#define TYPE_WINE_PERCENT \
+    (PERF_SIZE_LARGE | PERF_TYPE_NUMBER | PERF_NUMBER_DECIMAL | PERF_DISPLAY_PERCENT)
+
+#define WINE_SERVER_REQUESTS_SOURCE 2  /* index of the per request type counter template */
+
 /* counter source registry */
 static const struct source counter_sources[] =
 {
     { 6,   L"\\Processor(_Total)\\% Processor Time", collect_processor_time, TYPE_PROCESSOR_TIME, -5, 10000000 },
-    { 674, L"\\System\\System Up Time",              collect_uptime,         TYPE_UPTIME,         -3, 1000 }
+    { 674, L"\\System\\System Up Time",              collect_uptime,         TYPE_UPTIME,         -3, 1000 },
+    /* Wine specific counters, with indices outside of the range used by Windows */
+    { 0x10000, L"\\Wine Server(_Total)\\Requests/sec",       collect_wine_server_requests,   TYPE_WINE_RATE,    0, 0 },
+    { 0x10002, L"\\Wine Heap\\Committed Bytes",              collect_wine_heap_committed,    TYPE_WINE_NUMBER,  0, 0 },
+    { 0x10004, L"\\Wine Heap\\Free Bytes",                   collect_wine_heap_free,         TYPE_WINE_NUMBER,  0, 0 },
+    { 0x10006, L"\\Wine Heap\\Allocations/sec",              collect_wine_heap_allocs,       TYPE_WINE_RATE,    0, 0 },
+    { 0x10008, L"\\Wine Heap\\% LFH Allocations",            collect_wine_heap_lfh_percent,  TYPE_WINE_PERCENT, 0, 0 },
+    { 0x1000a, L"\\Wine Thread Pool\\Worker Threads",        collect_wine_tp_workers,        TYPE_WINE_NUMBER,  0, 0 },
+    { 0x1000c, L"\\Wine Thread Pool\\Busy Worker Threads",   collect_wine_tp_busy_workers,   TYPE_WINE_NUMBER,  0, 0 },
+    { 0x1000e, L"\\Wine Thread Pool\\Queue Length",          collect_wine_tp_queued,         TYPE_WINE_NUMBER,  0, 0 },
+    { 0x10010, L"\\Wine Memory\\Virtual Views",              collect_wine_virtual_views,     TYPE_WINE_NUMBER,  0, 0 },
 };
 
 static BOOL is_local_machine( const WCHAR *name, DWORD len )
@@ -181,7 +287,7 @@ static BOOL is_local_machine( const WCHAR *name, DWORD len )
     return len == buflen && !wcsnicmp( name, buf, buflen );
 }
 
-static BOOL pdh_match_path( LPCWSTR fullpath, LPCWSTR path )
+static const WCHAR *skip_machine_name( LPCWSTR path )
 {
     const WCHAR *p;
 
@@ -190,11 +296,338 @@ static BOOL pdh_match_path( LPCWSTR fullpath, LPCWSTR path )
     {
         path += p - path;
     }
+    return path;
+}
+
+static BOOL pdh_match_path( LPCWSTR fullpath, LPCWSTR path )
+{
+    const WCHAR *p;
+
+    path = skip_machine_name( path );
     if (wcschr( path, '\\' )) p = fullpath;
     else p = wcsrchr( fullpath, '\\' ) + 1;
     return !wcscmp( p, path );
 }
 
+/* wineserver request names, indexed by request number */
+/* ### make_requests begin ### */
+
+static const WCHAR * const server_request_names[] =
+{
+    L"new_process",
+    L"get_new_process_info",
+    L"new_thread",
+    L"get_startup_info",
+    L"init_process_done",
+    L"init_first_thread",
+    L"init_thread",
+    L"terminate_process",
+    L"terminate_thread",
+    L"get_process_info",
+    L"get_process_debug_info",
+    L"get_process_image_name",
+    L"get_process_vm_counters",
+    L"set_process_info",
+    L"get_thread_info",
+    L"get_thread_times",
+    L"set_thread_info",
+    L"suspend_thread",
+    L"resume_thread",
+    L"queue_apc",
+    L"get_apc_result",
+    L"close_handle",
+    L"set_handle_info",
+    L"dup_handle",
+    L"compare_objects",
+    L"make_temporary",
+    L"open_process",
+    L"open_thread",
+    L"select",
+    L"create_event",
+    L"event_op",
+    L"query_event",
+    L"open_event",
+    L"create_keyed_event",
+    L"open_keyed_event",
+    L"create_mutex",
+    L"release_mutex",
+    L"open_mutex",
+    L"query_mutex",
+    L"create_semaphore",
+    L"release_semaphore",
+    L"query_semaphore",
+    L"open_semaphore",
+    L"create_file",
+    L"open_file_object",
+    L"alloc_file_handle",
+    L"get_handle_unix_name",
+    L"get_handle_fd",
+    L"get_directory_cache_entry",
+    L"flush",
+    L"get_file_info",
+    L"get_volume_info",
+    L"lock_file",
+    L"unlock_file",
+    L"recv_socket",
+    L"send_socket",
+    L"socket_get_events",
+    L"socket_send_icmp_id",
+    L"socket_get_icmp_id",
+    L"get_socket_poll_state",
+    L"set_socket_buffered",
+    L"get_next_console_request",
+    L"read_directory_changes",
+    L"read_change",
+    L"create_mapping",
+    L"open_mapping",
+    L"get_mapping_info",
+    L"get_image_map_address",
+    L"map_view",
+    L"map_image_view",
+    L"map_builtin_view",
+    L"get_image_view_info",
+    L"unmap_view",
+    L"get_mapping_committed_range",
+    L"add_mapping_committed_range",
+    L"is_same_mapping",
+    L"get_mapping_filename",
+    L"list_processes",
+    L"create_debug_obj",
+    L"wait_debug_event",
+    L"queue_exception_event",
+    L"get_exception_status",
+    L"continue_debug_event",
+    L"debug_process",
+    L"set_debug_obj_info",
+    L"read_process_memory",
+    L"write_process_memory",
+    L"create_key",
+    L"open_key",
+    L"delete_key",
+    L"flush_key",
+    L"enum_key",
+    L"set_key_value",
+    L"get_key_value",
+    L"enum_key_value",
+    L"delete_key_value",
+    L"load_registry",
+    L"unload_registry",
+    L"save_registry",
+    L"set_registry_notification",
+    L"rename_key",
+    L"create_timer",
+    L"open_timer",
+    L"set_timer",
+    L"cancel_timer",
+    L"get_timer_info",
+    L"get_thread_context",
+    L"set_thread_context",
+    L"get_selector_entry",
+    L"add_atom",
+    L"delete_atom",
+    L"find_atom",
+    L"get_atom_information",
+    L"get_msg_queue",
+    L"set_queue_fd",
+    L"set_queue_mask",
+    L"get_queue_status",
+    L"get_process_idle_event",
+    L"send_message",
+    L"post_quit_message",
+    L"send_hardware_message",
+    L"get_message",
+    L"reply_message",
+    L"accept_hardware_message",
+    L"get_message_reply",
+    L"set_win_timer",
+    L"kill_win_timer",
+    L"is_window_hung",
+    L"get_serial_info",
+    L"set_serial_info",
+    L"cancel_sync",
+    L"register_async",
+    L"cancel_async",
+    L"get_async_result",
+    L"set_async_direct_result",
+    L"read",
+    L"write",
+    L"ioctl",
+    L"set_irp_result",
+    L"create_named_pipe",
+    L"set_named_pipe_info",
+    L"create_window",
+    L"destroy_window",
+    L"get_desktop_window",
+    L"set_window_owner",
+    L"get_window_info",
+    L"set_window_info",
+    L"set_parent",
+    L"get_window_parents",
+    L"get_window_children",
+    L"get_window_children_from_point",
+    L"get_window_tree",
+    L"set_window_pos",
+    L"get_window_rectangles",
+    L"get_window_text",
+    L"set_window_text",
+    L"get_windows_offset",
+    L"get_visible_region",
+    L"get_surface_region",
+    L"get_window_region",
+    L"set_window_region",
+    L"get_update_region",
+    L"update_window_zorder",
+    L"redraw_window",
+    L"set_window_property",
+    L"remove_window_property",
+    L"get_window_property",
+    L"get_window_properties",
+    L"create_winstation",
+    L"open_winstation",
+    L"close_winstation",
+    L"get_process_winstation",
+    L"set_process_winstation",
+    L"enum_winstation",
+    L"create_desktop",
+    L"open_desktop",
+    L"open_input_desktop",
+    L"close_desktop",
+    L"get_thread_desktop",
+    L"set_thread_desktop",
+    L"enum_desktop",
+    L"set_user_object_info",
+    L"register_hotkey",
+    L"unregister_hotkey",
+    L"attach_thread_input",
+    L"get_thread_input",
+    L"get_last_input_time",
+    L"get_key_state",
+    L"set_key_state",
+    L"set_foreground_window",
+    L"set_focus_window",
+    L"set_active_window",
+    L"set_capture_window",
+    L"set_caret_window",
+    L"set_caret_info",
+    L"set_hook",
+    L"remove_hook",
+    L"start_hook_chain",
+    L"finish_hook_chain",
+    L"get_hook_info",
+    L"create_class",
+    L"destroy_class",
+    L"set_class_info",
+    L"open_clipboard",
+    L"close_clipboard",
+    L"empty_clipboard",
+    L"set_clipboard_data",
+    L"get_clipboard_data",
+    L"get_clipboard_formats",
+    L"enum_clipboard_formats",
+    L"release_clipboard",
+    L"get_clipboard_info",
+    L"set_clipboard_viewer",
+    L"add_clipboard_listener",
+    L"remove_clipboard_listener",
+    L"create_token",
+    L"open_token",
+    L"set_global_windows",
+    L"adjust_token_privileges",
+    L"get_token_privileges",
+    L"check_token_privileges",
+    L"duplicate_token",
+    L"filter_token",
+    L"access_check",
+    L"get_token_sid",
+    L"get_token_groups",
+    L"get_token_default_dacl",
+    L"set_token_default_dacl",
+    L"set_security_object",
+    L"get_security_object",
+    L"get_system_handles",
+    L"create_mailslot",
+    L"set_mailslot_info",
+    L"create_directory",
+    L"open_directory",
+    L"get_directory_entry",
+    L"create_symlink",
+    L"open_symlink",
+    L"query_symlink",
+    L"get_object_info",
+    L"get_object_name",
+    L"get_object_type",
+    L"get_object_types",
+    L"allocate_locally_unique_id",
+    L"create_device_manager",
+    L"create_device",
+    L"delete_device",
+    L"get_next_device_request",
+    L"get_kernel_object_ptr",
+    L"set_kernel_object_ptr",
+    L"grab_kernel_object",
+    L"release_kernel_object",
+    L"get_kernel_object_handle",
+    L"make_process_system",
+    L"get_token_info",
+    L"create_linked_token",
+    L"create_completion",
+    L"open_completion",
+    L"add_completion",
+    L"remove_completion",
+    L"query_completion",
+    L"set_completion_info",
+    L"add_fd_completion",
+    L"set_fd_completion_mode",
+    L"set_fd_disp_info",
+    L"set_fd_name_info",
+    L"set_fd_eof_info",
+    L"get_window_layered_info",
+    L"set_window_layered_info",
+    L"alloc_user_handle",
+    L"free_user_handle",
+    L"set_cursor",
+    L"get_cursor_history",
+    L"get_rawinput_buffer",
+    L"update_rawinput_devices",
+    L"create_job",
+    L"open_job",
+    L"assign_job",
+    L"process_in_job",
+    L"set_job_limits",
+    L"set_job_completion_port",
+    L"get_job_info",
+    L"terminate_job",
+    L"suspend_process",
+    L"resume_process",
+    L"get_next_thread",
+};
+
+/* ### make_requests end ### */
+
+C_ASSERT( ARRAY_SIZE(server_request_names) <= WINE_STATS_MAX_REQUESTS );
+
+/* match a "\\Wine Server(<request name>)\\Requests/sec" counter path */
+static BOOL pdh_match_server_request_path( LPCWSTR path, DWORD *instance )
+{
+    static const WCHAR prefix[] = L"\\Wine Server(";
+    const WCHAR *end;
+    unsigned int i;
+
+    path = skip_machine_name( path );
+    if (wcsncmp( path, prefix, ARRAY_SIZE(prefix) - 1 )) return FALSE;
+    path += ARRAY_SIZE(prefix) - 1;
+    if (!(end = wcschr( path, ')' )) || wcscmp( end, L")\\Requests/sec" )) return FALSE;
+
+    for (i = 0; i < ARRAY_SIZE(server_request_names); i++)
+    {
+        if (wcslen( server_request_names[i] ) != end - path) continue;
+        if (wcsncmp( server_request_names[i], path, end - path )) continue;
+        *instance = i;
+        return TRUE;
+    }
+    return FALSE;
+}
+
 /***********************************************************************
  *              PdhAddCounterA   (PDH.@)
  */
@@ -224,7 +657,9 @@ PDH_STATUS WINAPI PdhAddCounterW( PDH_HQUERY hquery, LPCWSTR path,
                                   DWORD_PTR userdata, PDH_HCOUNTER *hcounter )
 {
     struct query *query = hquery;
+    const struct source *source = NULL;
     struct counter *counter;
+    DWORD instance = ~0u;
     unsigned int i;
 
     TRACE("%p %s %Ix %p\n", hquery, debugstr_w(path), userdata, hcounter);
@@ -243,28 +678,37 @@ PDH_STATUS WINAPI PdhAddCounterW( PDH_HQUERY hquery, LPCWSTR path,
     {
         if (pdh_match_path( counter_sources[i].path, path ))
         {
-            if ((counter = create_counter()))
-            {
-                counter->path         = wcsdup( counter_sources[i].path );
-                counter->collect      = counter_sources[i].collect;
-                counter->type         = counter_sources[i].type;
-                counter->defaultscale = counter_sources[i].scale;
-                counter->base         = counter_sources[i].base;
-                counter->queryuser    = query->user;
-                counter->user         = userdata;
-
-                list_add_tail( &query->counters, &counter->entry );
-                *hcounter = counter;
-
-                LeaveCriticalSection( &pdh_handle_cs );
-                return ERROR_SUCCESS;
-            }
-            LeaveCriticalSection( &pdh_handle_cs );
-            return PDH_MEMORY_ALLOCATION_FAILURE;
+            source = &counter_sources[i];
+            break;
         }
     }
+    if (!source && pdh_match_server_request_path( path, &instance ))
+        source = &counter_sources[WINE_SERVER_REQUESTS_SOURCE];
+    if (!source)
+    {
+        LeaveCriticalSection( &pdh_handle_cs );
+        return PDH_CSTATUS_NO_COUNTER;
+    }
+
+    if ((counter = create_counter()))
+    {
+        counter->path         = wcsdup( instance == ~0u ? source->path : skip_machine_name( path ));
+        counter->collect      = source->collect;
+        counter->type         = source->type;
+        counter->defaultscale = source->scale;
+        counter->base         = source->base;
+        counter->instance     = instance;
+        counter->queryuser    = query->user;
+        counter->user         = userdata;
+
+        list_add_tail( &query->counters, &counter->entry );
+        *hcounter = counter;
+
+        LeaveCriticalSection( &pdh_handle_cs );
+        return ERROR_SUCCESS;
+    }
     LeaveCriticalSection( &pdh_handle_cs );
-    return PDH_CSTATUS_NO_COUNTER;
+    return PDH_MEMORY_ALLOCATION_FAILURE;
 }
 
 /***********************************************************************
@@ -312,8 +756,8 @@ static PDH_STATUS format_value( struct counter *counter, DWORD format, union val
     }
     else if (format & PDH_FMT_DOUBLE)
     {
-        if (format & PDH_FMT_1000) value->doubleValue = raw2->doublevalue * 1000;
-        else value->doubleValue = raw2->doublevalue * pow( 10, factor );
+        if (format & PDH_FMT_1000) value->doubleValue = raw2->largevalue * 1000.0;
+        else value->doubleValue = raw2->largevalue * pow( 10, factor );
     }
     else
     {
@@ -407,6 +851,8 @@ static void collect_query_data( struct query *query )
 {
     struct list *item;
 
+    collect_serial++;
+
     LIST_FOR_EACH( item, &query->counters )
     {
         SYSTEMTIME time;
@@ -1039,6 +1485,7 @@ PDH_STATUS WINAPI PdhValidatePathW( LPCWSTR path )
 {
     PDH_STATUS ret;
     unsigned int i;
+    DWORD instance;
 
     TRACE("%s\n", debugstr_w(path));
 
@@ -1046,6 +1493,7 @@ PDH_STATUS WINAPI PdhValidatePathW( LPCWSTR path )
 
     for (i = 0; i < ARRAY_SIZE(counter_sources); i++)
         if (pdh_match_path( counter_sources[i].path, path )) return ERROR_SUCCESS;
+    if (pdh_match_server_request_path( path, &instance )) return ERROR_SUCCESS;
 
     return PDH_CSTATUS_NO_COUNTER;
 }
@@ -1016,6 +1016,78 @@ static void test_PdhGetDllVersion(void)
     }
 }
 
+static void test_wine_counters(void)
+{
+    PDH_HCOUNTER requests, request, committed, views;
+    PDH_FMT_COUNTERVALUE value;
+    PDH_STATUS ret;
+    PDH_HQUERY query;
+    HANDLE event;
+
+    ret = PdhOpenQueryA( NULL, 0, &query );
+    ok(ret == ERROR_SUCCESS, "PdhOpenQueryA failed 0x%08lx\n", ret);
+
+    ret = PdhAddCounterA( query, "\\Wine Server(_Total)\\Requests/sec", 0, &requests );
+    if (ret == PDH_CSTATUS_NO_COUNTER || ret == PDH_CSTATUS_NO_OBJECT)
+    {
+        win_skip("Wine counters not supported\n");
+        PdhCloseQuery( query );
+        return;
+    }
+    ok(ret == ERROR_SUCCESS, "PdhAddCounterA failed 0x%08lx\n", ret);
+
+    ret = PdhAddCounterA( query, "\\Wine Server(create_event)\\Requests/sec", 0, &request );
+    ok(ret == ERROR_SUCCESS, "PdhAddCounterA failed 0x%08lx\n", ret);
+    ret = PdhAddCounterA( query, "\\Wine Heap\\Committed Bytes", 0, &committed );
+    ok(ret == ERROR_SUCCESS, "PdhAddCounterA failed 0x%08lx\n", ret);
+    ret = PdhAddCounterA( query, "\\Wine Memory\\Virtual Views", 0, &views );
+    ok(ret == ERROR_SUCCESS, "PdhAddCounterA failed 0x%08lx\n", ret);
+
+    ret = PdhValidatePathA( "\\Wine Server(no_such_request)\\Requests/sec" );
+    ok(ret == PDH_CSTATUS_NO_COUNTER, "PdhValidatePathA failed 0x%08lx\n", ret);
+    ret = PdhValidatePathA( "\\Wine Server(1)\\Requests/sec" );
+    ok(ret == PDH_CSTATUS_NO_COUNTER, "PdhValidatePathA failed 0x%08lx\n", ret);
+    ret = PdhValidatePathA( "\\Wine Server(close_handle)\\Requests/sec" );
+    ok(ret == ERROR_SUCCESS, "PdhValidatePathA failed 0x%08lx\n", ret);
+    ret = PdhValidatePathA( "\\Wine Thread Pool\\Queue Length" );
+    ok(ret == ERROR_SUCCESS, "PdhValidatePathA failed 0x%08lx\n", ret);
+
+    ret = PdhCollectQueryData( query );
+    ok(ret == ERROR_SUCCESS, "PdhCollectQueryData failed 0x%08lx\n", ret);
+
+    /* rate counters need two samples */
+    ret = PdhGetFormattedCounterValue( requests, PDH_FMT_LARGE, NULL, &value );
+    ok(ret == PDH_INVALID_DATA, "PdhGetFormattedCounterValue failed 0x%08lx\n", ret);
+
+    ret = PdhGetFormattedCounterValue( committed, PDH_FMT_LARGE, NULL, &value );
+    ok(ret == ERROR_SUCCESS, "PdhGetFormattedCounterValue failed 0x%08lx\n", ret);
+    ok(value.largeValue > 0, "got %s\n", wine_dbgstr_longlong(value.largeValue));
+
+    ret = PdhGetFormattedCounterValue( views, PDH_FMT_DOUBLE, NULL, &value );
+    ok(ret == ERROR_SUCCESS, "PdhGetFormattedCounterValue failed 0x%08lx\n", ret);
+    ok(value.doubleValue >= 1.0, "got %f\n", value.doubleValue);
+
+    /* generate some server requests */
+    event = CreateEventA( NULL, FALSE, FALSE, NULL );
+    CloseHandle( event );
+    Sleep( 10 );
+
+    ret = PdhCollectQueryData( query );
+    ok(ret == ERROR_SUCCESS, "PdhCollectQueryData failed 0x%08lx\n", ret);
+
+    ret = PdhGetFormattedCounterValue( requests, PDH_FMT_LARGE, NULL, &value );
+    ok(ret == ERROR_SUCCESS, "PdhGetFormattedCounterValue failed 0x%08lx\n", ret);
+    ok(value.largeValue > 0, "got %s\n", wine_dbgstr_longlong(value.largeValue));
+
+    /* requests are counted once statistics have been queried */
+    ret = PdhGetFormattedCounterValue( request, PDH_FMT_LARGE, NULL, &value );
+    ok(ret == ERROR_SUCCESS, "PdhGetFormattedCounterValue failed 0x%08lx\n", ret);
+    ok(value.largeValue > 0, "got %s\n", wine_dbgstr_longlong(value.largeValue));
+
+    ret = PdhCloseQuery( query );
+    ok(ret == ERROR_SUCCESS, "PdhCloseQuery failed 0x%08lx\n", ret);
+}
+
 START_TEST(pdh)
 {
     if (!is_lang_english())
@@ -1060,4 +1132,5 @@ START_TEST(pdh)
     test_PdhCollectQueryDataEx();
     test_PdhMakeCounterPathA();
     test_PdhGetDllVersion();
+    test_wine_counters();
 }
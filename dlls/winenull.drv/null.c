@@ -0,0 +1,1335 @@
+/*
+ * Null audio driver (unixlib)
+ *
+ * Copyright 2011 Andrew Eikum for CodeWeavers
+ *           2022 Huw Davies
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#if 0
+#pragma makedep unix
+#endif
+
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "winternl.h"
+#include "initguid.h"
+#include "audioclient.h"
+#include "mmddk.h"
+
+#include "wine/debug.h"
+#include "wine/unixlib.h"
+
+#include "unixlib.h"
+
+/* The null device neither plays nor records anything.  Each stream runs a
+ * virtual device clock off the performance counter while it is started:
+ * rendered frames are consumed (and dropped) at the stream's sample rate,
+ * and captured frames are produced as silence at the same rate. */
+struct null_stream
+{
+    WAVEFORMATEX *fmt;
+    EDataFlow flow;
+    UINT flags;
+    AUDCLNT_SHAREMODE share;
+    HANDLE event;
+
+    BOOL playing, please_quit;
+    UINT64 written_frames, clock_frames, clock_base_frames;
+    UINT32 period_frames, bufsize_frames, held_frames;
+    UINT32 getbuf_last;
+    REFERENCE_TIME period;
+    LARGE_INTEGER clock_base;
+
+    BYTE *local_buffer;
+
+    pthread_mutex_t lock;
+};
+
+WINE_DEFAULT_DEBUG_CHANNEL(nullaudio);
+
+static const REFERENCE_TIME def_period = 100000;
+static const REFERENCE_TIME min_period = 30000;
+
+static const WCHAR render_nameW[] = {'N','u','l','l',' ','O','u','t','p','u','t',0};
+static const WCHAR capture_nameW[] = {'N','u','l','l',' ','I','n','p','u','t',0};
+static const char null_device[] = "null";
+
+static ULONG_PTR zero_bits = 0;
+
+static NTSTATUS null_not_implemented(void *args)
+{
+    return STATUS_SUCCESS;
+}
+
+/* copied from kernelbase */
+static int muldiv( int a, int b, int c )
+{
+    LONGLONG ret;
+
+    if (!c) return -1;
+
+    /* We want to deal with a positive divisor to simplify the logic. */
+    if (c < 0)
+    {
+        a = -a;
+        c = -c;
+    }
+
+    /* If the result is positive, we "add" to round. else, we subtract to round. */
+    if ((a < 0 && b < 0) || (a >= 0 && b >= 0))
+        ret = (((LONGLONG)a * b) + (c / 2)) / c;
+    else
+        ret = (((LONGLONG)a * b) - (c / 2)) / c;
+
+    if (ret > 2147483647 || ret < -2147483647) return -1;
+    return ret;
+}
+
+static void null_lock(struct null_stream *stream)
+{
+    pthread_mutex_lock(&stream->lock);
+}
+
+static void null_unlock(struct null_stream *stream)
+{
+    pthread_mutex_unlock(&stream->lock);
+}
+
+static NTSTATUS null_unlock_result(struct null_stream *stream,
+                                   HRESULT *result, HRESULT value)
+{
+    *result = value;
+    null_unlock(stream);
+    return STATUS_SUCCESS;
+}
+
+static struct null_stream *handle_get_stream(stream_handle h)
+{
+    return (struct null_stream *)(UINT_PTR)h;
+}
+
+/* Advance the virtual device clock to the current time and let the device
+ * consume (render) or produce (capture) the frames that elapsed since the
+ * last update.  Must be called with the stream lock held. */
+static void null_update_clock(struct null_stream *stream)
+{
+    LARGE_INTEGER now, freq;
+    UINT64 ticks, clock, advanced, rate = stream->fmt->nSamplesPerSec;
+
+    if(!stream->playing)
+        return;
+
+    NtQueryPerformanceCounter(&now, &freq);
+    ticks = now.QuadPart - stream->clock_base.QuadPart;
+    /* split the division to avoid overflowing on long running streams */
+    clock = stream->clock_base_frames + (ticks / freq.QuadPart) * rate +
+            (ticks % freq.QuadPart) * rate / freq.QuadPart;
+    if(clock <= stream->clock_frames)
+        return;
+
+    advanced = clock - stream->clock_frames;
+    stream->clock_frames = clock;
+
+    if(stream->flow == eRender){
+        /* an underrun just leaves the device idle until new data arrives */
+        stream->held_frames -= min(advanced, stream->held_frames);
+    }else{
+        advanced += stream->held_frames;
+        if(advanced > stream->bufsize_frames){
+            TRACE("Overflow of unread data, dropping %s frames\n",
+                    wine_dbgstr_longlong(advanced - stream->bufsize_frames));
+            stream->written_frames += advanced - stream->bufsize_frames;
+            advanced = stream->bufsize_frames;
+        }
+        stream->held_frames = advanced;
+    }
+}
+
+static void silence_buffer(struct null_stream *stream, BYTE *buffer, UINT32 frames)
+{
+    WAVEFORMATEXTENSIBLE *fmtex = (WAVEFORMATEXTENSIBLE*)stream->fmt;
+    if((stream->fmt->wFormatTag == WAVE_FORMAT_PCM ||
+            (stream->fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+             IsEqualGUID(&fmtex->SubFormat, &KSDATAFORMAT_SUBTYPE_PCM))) &&
+            stream->fmt->wBitsPerSample == 8)
+        memset(buffer, 128, frames * stream->fmt->nBlockAlign);
+    else
+        memset(buffer, 0, frames * stream->fmt->nBlockAlign);
+}
+
+static BOOL is_supported_format(const WAVEFORMATEX *fmt)
+{
+    const WAVEFORMATEXTENSIBLE *fmtex = (const WAVEFORMATEXTENSIBLE *)fmt;
+    BOOL is_pcm, is_float;
+
+    if(fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE){
+        is_pcm = IsEqualGUID(&fmtex->SubFormat, &KSDATAFORMAT_SUBTYPE_PCM);
+        is_float = IsEqualGUID(&fmtex->SubFormat, &KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
+        if(fmtex->Samples.wValidBitsPerSample > fmt->wBitsPerSample)
+            return FALSE;
+    }else{
+        is_pcm = fmt->wFormatTag == WAVE_FORMAT_PCM;
+        is_float = fmt->wFormatTag == WAVE_FORMAT_IEEE_FLOAT;
+    }
+
+    if(is_pcm){
+        if(fmt->wBitsPerSample != 8 && fmt->wBitsPerSample != 16 &&
+           fmt->wBitsPerSample != 24 && fmt->wBitsPerSample != 32)
+            return FALSE;
+    }else if(is_float){
+        if(fmt->wBitsPerSample != 32 && fmt->wBitsPerSample != 64)
+            return FALSE;
+    }else
+        return FALSE;
+
+    if(fmt->nChannels == 0 || fmt->nChannels > 8 ||
+       fmt->nSamplesPerSec < 8000 || fmt->nSamplesPerSec > 384000)
+        return FALSE;
+
+    return fmt->nBlockAlign == fmt->nChannels * fmt->wBitsPerSample / 8 &&
+           fmt->nAvgBytesPerSec == fmt->nSamplesPerSec * fmt->nBlockAlign;
+}
+
+static WAVEFORMATEXTENSIBLE *clone_format(const WAVEFORMATEX *fmt)
+{
+    WAVEFORMATEXTENSIBLE *ret;
+    size_t size;
+
+    if(fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE)
+        size = sizeof(WAVEFORMATEXTENSIBLE);
+    else
+        size = sizeof(WAVEFORMATEX);
+
+    ret = malloc(size);
+    if(!ret)
+        return NULL;
+
+    memcpy(ret, fmt, size);
+
+    ret->Format.cbSize = size - sizeof(WAVEFORMATEX);
+
+    return ret;
+}
+
+static NTSTATUS null_test_connect(void *args)
+{
+    struct test_connect_params *params = args;
+
+    /* Always usable, but never preferred over a real sound system. */
+    params->priority = Priority_Low;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_process_attach(void *args)
+{
+#ifdef _WIN64
+    if (NtCurrentTeb()->WowTebOffset)
+    {
+        SYSTEM_BASIC_INFORMATION info;
+
+        NtQuerySystemInformation(SystemEmulationBasicInformation, &info, sizeof(info), NULL);
+        zero_bits = (ULONG_PTR)info.HighestUserAddress | 0x7fffffff;
+    }
+#endif
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_main_loop(void *args)
+{
+    struct main_loop_params *params = args;
+    NtSetEvent(params->event, NULL);
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_endpoint_ids(void *args)
+{
+    struct get_endpoint_ids_params *params = args;
+    const WCHAR *name = params->flow == eRender ? render_nameW : capture_nameW;
+    unsigned int name_len, device_len, needed;
+    struct endpoint *endpoint = params->endpoints;
+
+    if(params->flow != eRender && params->flow != eCapture){
+        params->result = E_INVALIDARG;
+        return STATUS_SUCCESS;
+    }
+
+    name_len = wcslen(name) + 1;
+    device_len = strlen(null_device) + 1;
+    needed = sizeof(*endpoint) + name_len * sizeof(WCHAR) + ((device_len + 1) & ~1);
+
+    params->num = 1;
+    params->default_idx = 0;
+
+    if(needed > params->size){
+        params->size = needed;
+        params->result = HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+        return STATUS_SUCCESS;
+    }
+
+    endpoint->name = sizeof(*endpoint);
+    memcpy((char *)params->endpoints + endpoint->name, name, name_len * sizeof(WCHAR));
+    endpoint->device = endpoint->name + name_len * sizeof(WCHAR);
+    memcpy((char *)params->endpoints + endpoint->device, null_device, device_len);
+
+    params->result = S_OK;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_create_stream(void *args)
+{
+    struct create_stream_params *params = args;
+    WAVEFORMATEXTENSIBLE *fmtex = (WAVEFORMATEXTENSIBLE *)params->fmt;
+    struct null_stream *stream;
+    SIZE_T size;
+
+    params->result = S_OK;
+
+    if (!is_supported_format(params->fmt))
+        params->result = AUDCLNT_E_UNSUPPORTED_FORMAT;
+    else if (params->share == AUDCLNT_SHAREMODE_SHARED) {
+        params->period = def_period;
+        if (params->duration < 3 * params->period)
+            params->duration = 3 * params->period;
+    } else {
+        if (fmtex->Format.wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+           (fmtex->dwChannelMask == 0 || fmtex->dwChannelMask & SPEAKER_RESERVED))
+            params->result = AUDCLNT_E_UNSUPPORTED_FORMAT;
+        else {
+            if (!params->period)
+                params->period = def_period;
+            if (params->period < min_period || params->period > 5000000)
+                params->result = AUDCLNT_E_INVALID_DEVICE_PERIOD;
+            else if (params->duration > 20000000) /* The smaller the period, the lower this limit. */
+                params->result = AUDCLNT_E_BUFFER_SIZE_ERROR;
+            else if (params->flags & AUDCLNT_STREAMFLAGS_EVENTCALLBACK) {
+                if (params->duration != params->period)
+                    params->result = AUDCLNT_E_BUFDURATION_PERIOD_NOT_EQUAL;
+            } else if (params->duration < 8 * params->period)
+                params->duration = 8 * params->period; /* May grow above 2s. */
+        }
+    }
+
+    if (FAILED(params->result))
+        return STATUS_SUCCESS;
+
+    stream = calloc(1, sizeof(*stream));
+    if(!stream){
+        params->result = E_OUTOFMEMORY;
+        return STATUS_SUCCESS;
+    }
+
+    stream->flow = params->flow;
+    pthread_mutex_init(&stream->lock, NULL);
+
+    fmtex = clone_format(params->fmt);
+    if(!fmtex){
+        params->result = E_OUTOFMEMORY;
+        goto exit;
+    }
+    stream->fmt = &fmtex->Format;
+
+    stream->period = params->period;
+    stream->period_frames = muldiv(params->fmt->nSamplesPerSec, params->period, 10000000);
+
+    stream->bufsize_frames = muldiv(params->duration, params->fmt->nSamplesPerSec, 10000000);
+    if(params->share == AUDCLNT_SHAREMODE_EXCLUSIVE)
+        stream->bufsize_frames -= stream->bufsize_frames % stream->period_frames;
+
+    /* Sample data is never looked at, so the whole buffer is handed out as
+     * scratch space for every GetBuffer call instead of being used as a ring. */
+    size = stream->bufsize_frames * params->fmt->nBlockAlign;
+    if(NtAllocateVirtualMemory(GetCurrentProcess(), (void **)&stream->local_buffer, zero_bits,
+                               &size, MEM_COMMIT, PAGE_READWRITE)){
+        params->result = E_OUTOFMEMORY;
+        goto exit;
+    }
+
+    stream->share = params->share;
+    stream->flags = params->flags;
+
+exit:
+    if(FAILED(params->result)){
+        pthread_mutex_destroy(&stream->lock);
+        free(stream->fmt);
+        free(stream);
+    }else{
+        *params->channel_count = params->fmt->nChannels;
+        *params->stream = (stream_handle)(UINT_PTR)stream;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_release_stream(void *args)
+{
+    struct release_stream_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    SIZE_T size;
+
+    if(params->timer_thread){
+        stream->please_quit = TRUE;
+        NtWaitForSingleObject(params->timer_thread, FALSE, NULL);
+        NtClose(params->timer_thread);
+    }
+
+    if(stream->local_buffer){
+        size = 0;
+        NtFreeVirtualMemory(GetCurrentProcess(), (void **)&stream->local_buffer, &size, MEM_RELEASE);
+    }
+    free(stream->fmt);
+    pthread_mutex_destroy(&stream->lock);
+    free(stream);
+
+    params->result = S_OK;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_start(void *args)
+{
+    struct start_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    if((stream->flags & AUDCLNT_STREAMFLAGS_EVENTCALLBACK) && !stream->event)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_EVENTHANDLE_NOT_SET);
+
+    if(stream->playing)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_NOT_STOPPED);
+
+    NtQueryPerformanceCounter(&stream->clock_base, NULL);
+    stream->clock_base_frames = stream->clock_frames;
+    stream->playing = TRUE;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_stop(void *args)
+{
+    struct stop_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    if(!stream->playing)
+        return null_unlock_result(stream, &params->result, S_FALSE);
+
+    null_update_clock(stream);
+    stream->playing = FALSE;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_reset(void *args)
+{
+    struct reset_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    if(stream->playing)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_NOT_STOPPED);
+
+    if(stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_BUFFER_OPERATION_PENDING);
+
+    if(stream->flow == eRender)
+        stream->written_frames = 0;
+    else
+        stream->written_frames += stream->held_frames;
+    stream->held_frames = 0;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_timer_loop(void *args)
+{
+    struct timer_loop_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    LARGE_INTEGER delay, now, next;
+    int adjust;
+
+    null_lock(stream);
+
+    delay.QuadPart = -stream->period;
+    NtQueryPerformanceCounter(&now, NULL);
+    next.QuadPart = now.QuadPart + stream->period;
+
+    while(!stream->please_quit){
+        null_update_clock(stream);
+        if(stream->event)
+            NtSetEvent(stream->event, NULL);
+        null_unlock(stream);
+
+        NtDelayExecution(FALSE, &delay);
+
+        null_lock(stream);
+        NtQueryPerformanceCounter(&now, NULL);
+        adjust = next.QuadPart - now.QuadPart;
+        if(adjust > stream->period / 2)
+            adjust = stream->period / 2;
+        else if(adjust < -stream->period / 2)
+            adjust = -stream->period / 2;
+        delay.QuadPart = -(stream->period + adjust);
+        next.QuadPart += stream->period;
+    }
+
+    null_unlock(stream);
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_render_buffer(void *args)
+{
+    struct get_render_buffer_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT32 frames = params->frames;
+
+    null_lock(stream);
+
+    if(stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_OUT_OF_ORDER);
+
+    if(!frames)
+        return null_unlock_result(stream, &params->result, S_OK);
+
+    null_update_clock(stream);
+
+    if(stream->held_frames + frames > stream->bufsize_frames)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_BUFFER_TOO_LARGE);
+
+    *params->data = stream->local_buffer;
+    stream->getbuf_last = frames;
+
+    silence_buffer(stream, *params->data, frames);
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_release_render_buffer(void *args)
+{
+    struct release_render_buffer_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT32 written_frames = params->written_frames;
+
+    null_lock(stream);
+
+    if(!written_frames){
+        stream->getbuf_last = 0;
+        return null_unlock_result(stream, &params->result, S_OK);
+    }
+
+    if(!stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_OUT_OF_ORDER);
+
+    if(written_frames > stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_INVALID_SIZE);
+
+    /* the data itself is discarded, only the accounting matters */
+    stream->held_frames += written_frames;
+    stream->written_frames += written_frames;
+    stream->getbuf_last = 0;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_capture_buffer(void *args)
+{
+    struct get_capture_buffer_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT64 *devpos = params->devpos, *qpcpos = params->qpcpos;
+    UINT32 *frames = params->frames;
+
+    null_lock(stream);
+
+    if(stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_OUT_OF_ORDER);
+
+    null_update_clock(stream);
+
+    if(stream->held_frames < stream->period_frames){
+        *frames = 0;
+        return null_unlock_result(stream, &params->result, AUDCLNT_S_BUFFER_EMPTY);
+    }
+
+    *frames = stream->period_frames;
+    *params->flags = AUDCLNT_BUFFERFLAGS_SILENT;
+    *params->data = stream->local_buffer;
+    silence_buffer(stream, stream->local_buffer, *frames);
+
+    stream->getbuf_last = *frames;
+
+    if(devpos)
+       *devpos = stream->written_frames;
+    if(qpcpos){
+        LARGE_INTEGER stamp, freq;
+        NtQueryPerformanceCounter(&stamp, &freq);
+        *qpcpos = (stamp.QuadPart * (INT64)10000000) / freq.QuadPart;
+    }
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_release_capture_buffer(void *args)
+{
+    struct release_capture_buffer_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT32 done = params->done;
+
+    null_lock(stream);
+
+    if(!done){
+        stream->getbuf_last = 0;
+        return null_unlock_result(stream, &params->result, S_OK);
+    }
+
+    if(!stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_OUT_OF_ORDER);
+
+    if(stream->getbuf_last != done)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_INVALID_SIZE);
+
+    stream->written_frames += done;
+    stream->held_frames -= done;
+    stream->getbuf_last = 0;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_is_format_supported(void *args)
+{
+    struct is_format_supported_params *params = args;
+
+    params->result = S_OK;
+
+    if(!params->fmt_in || (params->share == AUDCLNT_SHAREMODE_SHARED && !params->fmt_out))
+        params->result = E_POINTER;
+    else if(params->share != AUDCLNT_SHAREMODE_SHARED && params->share != AUDCLNT_SHAREMODE_EXCLUSIVE)
+        params->result = E_INVALIDARG;
+    else if(params->fmt_in->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+            params->fmt_in->cbSize < sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX))
+        params->result = E_INVALIDARG;
+    else if(!is_supported_format(params->fmt_in))
+        params->result = AUDCLNT_E_UNSUPPORTED_FORMAT;
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_mix_format(void *args)
+{
+    struct get_mix_format_params *params = args;
+    WAVEFORMATEXTENSIBLE *fmt = params->fmt;
+
+    if(params->flow != eRender && params->flow != eCapture){
+        params->result = E_UNEXPECTED;
+        return STATUS_SUCCESS;
+    }
+
+    fmt->Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    fmt->Format.wBitsPerSample = 32;
+    fmt->SubFormat = KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+    fmt->Format.nChannels = 2;
+    fmt->Format.nSamplesPerSec = 48000;
+    fmt->dwChannelMask = KSAUDIO_SPEAKER_STEREO;
+
+    fmt->Format.nBlockAlign = (fmt->Format.wBitsPerSample *
+            fmt->Format.nChannels) / 8;
+    fmt->Format.nAvgBytesPerSec = fmt->Format.nSamplesPerSec *
+        fmt->Format.nBlockAlign;
+
+    fmt->Samples.wValidBitsPerSample = fmt->Format.wBitsPerSample;
+    fmt->Format.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+
+    params->result = S_OK;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_device_period(void *args)
+{
+    struct get_device_period_params *params = args;
+
+    if (params->def_period)
+        *params->def_period = def_period;
+    if (params->min_period)
+        *params->min_period = min_period;
+
+    params->result = S_OK;
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_buffer_size(void *args)
+{
+    struct get_buffer_size_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    *params->frames = stream->bufsize_frames;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_latency(void *args)
+{
+    struct get_latency_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    /* pretend we process audio in Period chunks, so max latency includes
+     * the period time.  Some native machines add .6666ms in shared mode. */
+    *params->latency = stream->period + 6666;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_current_padding(void *args)
+{
+    struct get_current_padding_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    null_update_clock(stream);
+    *params->padding = stream->held_frames;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_next_packet_size(void *args)
+{
+    struct get_next_packet_size_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT32 *frames = params->frames;
+
+    null_lock(stream);
+
+    null_update_clock(stream);
+    *frames = stream->held_frames < stream->period_frames ? 0 : stream->period_frames;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_frequency(void *args)
+{
+    struct get_frequency_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT64 *freq = params->freq;
+
+    null_lock(stream);
+
+    if(stream->share == AUDCLNT_SHAREMODE_SHARED)
+        *freq = (UINT64)stream->fmt->nSamplesPerSec * stream->fmt->nBlockAlign;
+    else
+        *freq = stream->fmt->nSamplesPerSec;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_position(void *args)
+{
+    struct get_position_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT64 *pos = params->pos, *qpctime = params->qpctime;
+
+    null_lock(stream);
+
+    null_update_clock(stream);
+
+    if(params->device)
+        *pos = stream->clock_frames;
+    else if(stream->flow == eRender)
+        *pos = stream->written_frames - stream->held_frames;
+    else
+        *pos = stream->written_frames + stream->held_frames;
+
+    TRACE("returning: %s\n", wine_dbgstr_longlong(*pos));
+    if(stream->share == AUDCLNT_SHAREMODE_SHARED)
+        *pos *= stream->fmt->nBlockAlign;
+
+    if(qpctime){
+        LARGE_INTEGER stamp, freq;
+        NtQueryPerformanceCounter(&stamp, &freq);
+        *qpctime = (stamp.QuadPart * (INT64)10000000) / freq.QuadPart;
+    }
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_set_volumes(void *args)
+{
+    /* nothing is ever audible */
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_set_event_handle(void *args)
+{
+    struct set_event_handle_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    if(!(stream->flags & AUDCLNT_STREAMFLAGS_EVENTCALLBACK))
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_EVENTHANDLE_NOT_EXPECTED);
+
+    if (stream->event){
+        FIXME("called twice\n");
+        return null_unlock_result(stream, &params->result, HRESULT_FROM_WIN32(ERROR_INVALID_NAME));
+    }
+
+    stream->event = params->event;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_is_started(void *args)
+{
+    struct is_started_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    return null_unlock_result(stream, &params->result, stream->playing ? S_OK : S_FALSE);
+}
+
+static NTSTATUS null_get_prop_value(void *args)
+{
+    struct get_prop_value_params *params = args;
+
+    params->result = E_NOTIMPL;
+
+    return STATUS_SUCCESS;
+}
+
+const unixlib_entry_t __wine_unix_call_funcs[] =
+{
+    null_process_attach,
+    null_not_implemented,
+    null_main_loop,
+    null_get_endpoint_ids,
+    null_create_stream,
+    null_release_stream,
+    null_start,
+    null_stop,
+    null_reset,
+    null_timer_loop,
+    null_get_render_buffer,
+    null_release_render_buffer,
+    null_get_capture_buffer,
+    null_release_capture_buffer,
+    null_is_format_supported,
+    null_get_mix_format,
+    null_get_device_period,
+    null_get_buffer_size,
+    null_get_latency,
+    null_get_current_padding,
+    null_get_next_packet_size,
+    null_get_frequency,
+    null_get_position,
+    null_set_volumes,
+    null_set_event_handle,
+    null_test_connect,
+    null_is_started,
+    null_get_prop_value,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+};
+
+C_ASSERT(ARRAYSIZE(__wine_unix_call_funcs) == funcs_count);
+
+#ifdef _WIN64
+
+typedef UINT PTR32;
+
+static NTSTATUS null_wow64_test_connect(void *args)
+{
+    struct
+    {
+        PTR32 name;
+        enum driver_priority priority;
+    } *params32 = args;
+    struct test_connect_params params =
+    {
+        .name = ULongToPtr(params32->name),
+    };
+    null_test_connect(&params);
+    params32->priority = params.priority;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_main_loop(void *args)
+{
+    struct
+    {
+        PTR32 event;
+    } *params32 = args;
+    struct main_loop_params params =
+    {
+        .event = ULongToHandle(params32->event)
+    };
+    return null_main_loop(&params);
+}
+
+static NTSTATUS null_wow64_get_endpoint_ids(void *args)
+{
+    struct
+    {
+        EDataFlow flow;
+        PTR32 endpoints;
+        unsigned int size;
+        HRESULT result;
+        unsigned int num;
+        unsigned int default_idx;
+    } *params32 = args;
+    struct get_endpoint_ids_params params =
+    {
+        .flow = params32->flow,
+        .endpoints = ULongToPtr(params32->endpoints),
+        .size = params32->size
+    };
+    null_get_endpoint_ids(&params);
+    params32->size = params.size;
+    params32->result = params.result;
+    params32->num = params.num;
+    params32->default_idx = params.default_idx;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_create_stream(void *args)
+{
+    struct
+    {
+        PTR32 name;
+        PTR32 device;
+        EDataFlow flow;
+        AUDCLNT_SHAREMODE share;
+        UINT flags;
+        REFERENCE_TIME duration;
+        REFERENCE_TIME period;
+        PTR32 fmt;
+        HRESULT result;
+        PTR32 channel_count;
+        PTR32 stream;
+    } *params32 = args;
+    struct create_stream_params params =
+    {
+        .name = ULongToPtr(params32->name),
+        .device = ULongToPtr(params32->device),
+        .flow = params32->flow,
+        .share = params32->share,
+        .flags = params32->flags,
+        .duration = params32->duration,
+        .period = params32->period,
+        .fmt = ULongToPtr(params32->fmt),
+        .channel_count = ULongToPtr(params32->channel_count),
+        .stream = ULongToPtr(params32->stream)
+    };
+    null_create_stream(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_release_stream(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        PTR32 timer_thread;
+        HRESULT result;
+    } *params32 = args;
+    struct release_stream_params params =
+    {
+        .stream = params32->stream,
+        .timer_thread = ULongToHandle(params32->timer_thread)
+    };
+    null_release_stream(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_render_buffer(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        UINT32 frames;
+        HRESULT result;
+        PTR32 data;
+    } *params32 = args;
+    BYTE *data = NULL;
+    struct get_render_buffer_params params =
+    {
+        .stream = params32->stream,
+        .frames = params32->frames,
+        .data = &data
+    };
+    null_get_render_buffer(&params);
+    params32->result = params.result;
+    *(unsigned int *)ULongToPtr(params32->data) = PtrToUlong(data);
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_capture_buffer(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 data;
+        PTR32 frames;
+        PTR32 flags;
+        PTR32 devpos;
+        PTR32 qpcpos;
+    } *params32 = args;
+    BYTE *data = NULL;
+    struct get_capture_buffer_params params =
+    {
+        .stream = params32->stream,
+        .data = &data,
+        .frames = ULongToPtr(params32->frames),
+        .flags = ULongToPtr(params32->flags),
+        .devpos = ULongToPtr(params32->devpos),
+        .qpcpos = ULongToPtr(params32->qpcpos)
+    };
+    null_get_capture_buffer(&params);
+    params32->result = params.result;
+    *(unsigned int *)ULongToPtr(params32->data) = PtrToUlong(data);
+    return STATUS_SUCCESS;
+};
+
+static NTSTATUS null_wow64_is_format_supported(void *args)
+{
+    struct
+    {
+        PTR32 device;
+        EDataFlow flow;
+        AUDCLNT_SHAREMODE share;
+        PTR32 fmt_in;
+        PTR32 fmt_out;
+        HRESULT result;
+    } *params32 = args;
+    struct is_format_supported_params params =
+    {
+        .device = ULongToPtr(params32->device),
+        .flow = params32->flow,
+        .share = params32->share,
+        .fmt_in = ULongToPtr(params32->fmt_in),
+        .fmt_out = ULongToPtr(params32->fmt_out)
+    };
+    null_is_format_supported(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_mix_format(void *args)
+{
+    struct
+    {
+        PTR32 device;
+        EDataFlow flow;
+        PTR32 fmt;
+        HRESULT result;
+    } *params32 = args;
+    struct get_mix_format_params params =
+    {
+        .device = ULongToPtr(params32->device),
+        .flow = params32->flow,
+        .fmt = ULongToPtr(params32->fmt)
+    };
+    null_get_mix_format(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_device_period(void *args)
+{
+    struct
+    {
+        PTR32 device;
+        EDataFlow flow;
+        HRESULT result;
+        PTR32 def_period;
+        PTR32 min_period;
+    } *params32 = args;
+    struct get_device_period_params params =
+    {
+        .device = ULongToPtr(params32->device),
+        .flow = params32->flow,
+        .def_period = ULongToPtr(params32->def_period),
+        .min_period = ULongToPtr(params32->min_period),
+    };
+    null_get_device_period(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_buffer_size(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 frames;
+    } *params32 = args;
+    struct get_buffer_size_params params =
+    {
+        .stream = params32->stream,
+        .frames = ULongToPtr(params32->frames)
+    };
+    null_get_buffer_size(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_latency(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 latency;
+    } *params32 = args;
+    struct get_latency_params params =
+    {
+        .stream = params32->stream,
+        .latency = ULongToPtr(params32->latency)
+    };
+    null_get_latency(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_current_padding(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 padding;
+    } *params32 = args;
+    struct get_current_padding_params params =
+    {
+        .stream = params32->stream,
+        .padding = ULongToPtr(params32->padding)
+    };
+    null_get_current_padding(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_next_packet_size(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 frames;
+    } *params32 = args;
+    struct get_next_packet_size_params params =
+    {
+        .stream = params32->stream,
+        .frames = ULongToPtr(params32->frames)
+    };
+    null_get_next_packet_size(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_frequency(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 freq;
+    } *params32 = args;
+    struct get_frequency_params params =
+    {
+        .stream = params32->stream,
+        .freq = ULongToPtr(params32->freq)
+    };
+    null_get_frequency(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_position(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        BOOL device;
+        HRESULT result;
+        PTR32 pos;
+        PTR32 qpctime;
+    } *params32 = args;
+    struct get_position_params params =
+    {
+        .stream = params32->stream,
+        .device = params32->device,
+        .pos = ULongToPtr(params32->pos),
+        .qpctime = ULongToPtr(params32->qpctime)
+    };
+    null_get_position(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_set_volumes(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        float master_volume;
+        PTR32 volumes;
+        PTR32 session_volumes;
+    } *params32 = args;
+    struct set_volumes_params params =
+    {
+        .stream = params32->stream,
+        .master_volume = params32->master_volume,
+        .volumes = ULongToPtr(params32->volumes),
+        .session_volumes = ULongToPtr(params32->session_volumes),
+    };
+    return null_set_volumes(&params);
+}
+
+static NTSTATUS null_wow64_set_event_handle(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        PTR32 event;
+        HRESULT result;
+    } *params32 = args;
+    struct set_event_handle_params params =
+    {
+        .stream = params32->stream,
+        .event = ULongToHandle(params32->event)
+    };
+
+    null_set_event_handle(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_prop_value(void *args)
+{
+    struct propvariant32
+    {
+        WORD vt;
+        WORD pad1, pad2, pad3;
+        union
+        {
+            ULONG ulVal;
+            PTR32 ptr;
+            ULARGE_INTEGER uhVal;
+        };
+    } *value32;
+    struct
+    {
+        PTR32 device;
+        EDataFlow flow;
+        PTR32 guid;
+        PTR32 prop;
+        HRESULT result;
+        PTR32 value;
+        PTR32 buffer; /* caller allocated buffer to hold value's strings */
+        PTR32 buffer_size;
+    } *params32 = args;
+    PROPVARIANT value;
+    struct get_prop_value_params params =
+    {
+        .device = ULongToPtr(params32->device),
+        .flow = params32->flow,
+        .guid = ULongToPtr(params32->guid),
+        .prop = ULongToPtr(params32->prop),
+        .value = &value,
+        .buffer = ULongToPtr(params32->buffer),
+        .buffer_size = ULongToPtr(params32->buffer_size)
+    };
+    null_get_prop_value(&params);
+    params32->result = params.result;
+    if (SUCCEEDED(params.result))
+    {
+        value32 = UlongToPtr(params32->value);
+        value32->vt = value.vt;
+        switch (value.vt)
+        {
+        case VT_UI4:
+            value32->ulVal = value.ulVal;
+            break;
+        case VT_LPWSTR:
+            value32->ptr = params32->buffer;
+            break;
+        default:
+            FIXME("Unhandled vt %04x\n", value.vt);
+        }
+    }
+    return STATUS_SUCCESS;
+}
+
+const unixlib_entry_t __wine_unix_call_wow64_funcs[] =
+{
+    null_process_attach,
+    null_not_implemented,
+    null_wow64_main_loop,
+    null_wow64_get_endpoint_ids,
+    null_wow64_create_stream,
+    null_wow64_release_stream,
+    null_start,
+    null_stop,
+    null_reset,
+    null_timer_loop,
+    null_wow64_get_render_buffer,
+    null_release_render_buffer,
+    null_wow64_get_capture_buffer,
+    null_release_capture_buffer,
+    null_wow64_is_format_supported,
+    null_wow64_get_mix_format,
+    null_wow64_get_device_period,
+    null_wow64_get_buffer_size,
+    null_wow64_get_latency,
+    null_wow64_get_current_padding,
+    null_wow64_get_next_packet_size,
+    null_wow64_get_frequency,
+    null_wow64_get_position,
+    null_wow64_set_volumes,
+    null_wow64_set_event_handle,
+    null_wow64_test_connect,
+    null_is_started,
+    null_wow64_get_prop_value,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+};
+
+C_ASSERT(ARRAYSIZE(__wine_unix_call_wow64_funcs) == funcs_count);
+
+#endif /* _WIN64 */
@@ -0,0 +1,3 @@
+# MMDevAPI driver functions
+@ stdcall -private get_device_guid(long ptr ptr) get_device_guid
+@ stdcall -private get_device_name_from_guid(ptr ptr ptr) get_device_name_from_guid
@@ -2510,6 +2510,65 @@ static void WINAPI test_apc_proc( void *arg, IO_STATUS_BLOCK *iosb, ULONG reserv
     ++test_apc_count;
 }
 
+static void WINAPI test_user_apc_proc( ULONG_PTR arg )
+{
+    ++test_apc_count;
+}
+
+static void test_poll_datagram_wait(void)
+{
+    const struct sockaddr_in bind_addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    char in_buffer[offsetof(struct afd_poll_params, sockets[1])];
+    char out_buffer[offsetof(struct afd_poll_params, sockets[1])];
+    struct afd_poll_params *in_params = (struct afd_poll_params *)in_buffer;
+    struct afd_poll_params *out_params = (struct afd_poll_params *)out_buffer;
+    ULONG params_size = sizeof(in_buffer);
+    IO_STATUS_BLOCK io;
+    HANDLE event;
+    SOCKET sock;
+    int ret;
+
+    event = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ret = bind(sock, (const struct sockaddr *)&bind_addr, sizeof(bind_addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+
+    memset(in_buffer, 0, sizeof(in_buffer));
+    in_params->timeout = -200 * 10000; /* 200 ms */
+    in_params->count = 1;
+    in_params->sockets[0].socket = sock;
+    in_params->sockets[0].flags = AFD_POLL_READ;
+
+    /* A short poll of an idle datagram socket is still pending, and user APCs
+     * are delivered while it is. */
+
+    test_apc_count = 0;
+    ret = NtDeviceIoControlFile((HANDLE)sock, event, test_apc_proc, NULL, &io,
+            IOCTL_AFD_POLL, in_params, params_size, out_params, params_size);
+    ok(ret == STATUS_PENDING, "got %#x\n", ret);
+
+    ret = QueueUserAPC(test_user_apc_proc, GetCurrentThread(), 0);
+    ok(ret, "QueueUserAPC failed, error %lu\n", GetLastError());
+    ret = SleepEx(0, TRUE);
+    ok(ret == WAIT_IO_COMPLETION, "got %d\n", ret);
+    ok(test_apc_count == 1, "got %u APCs\n", test_apc_count);
+    ok(WaitForSingleObject(event, 0) == WAIT_TIMEOUT, "poll should still be pending\n");
+
+    /* It can be cancelled as well. */
+
+    CancelIo((HANDLE)sock);
+    ret = WaitForSingleObject(event, 100);
+    ok(!ret, "got %#x\n", ret);
+    ok(io.Status == STATUS_CANCELLED, "got %#lx\n", io.Status);
+    ret = SleepEx(0, TRUE);
+    ok(ret == WAIT_IO_COMPLETION, "got %d\n", ret);
+    ok(test_apc_count == 2, "got %u APCs\n", test_apc_count);
+
+    closesocket(sock);
+    CloseHandle(event);
+}
+
 static void test_async_thread_termination(void)
 {
     static const struct
@@ -2955,6 +3014,7 @@ START_TEST(afd)
     test_bind();
     test_getsockname();
     test_async_thread_termination();
+    test_poll_datagram_wait();
     test_read_write();
     test_async_cancel_on_handle_close();
 
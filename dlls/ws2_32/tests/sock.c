@@ -14066,8 +14066,141 @@ static void test_select_after_WSAEventSelect(void)
     closesocket(client);
 }
 
+static void check_recv_batch_datagram_(int line, SOCKET s, int flags, unsigned int index)
+{
+    char buffer[64];
+    int ret;
+
+    memset(buffer, 0xcc, sizeof(buffer));
+    ret = recv(s, buffer, sizeof(buffer), flags);
+    ok_(__FILE__, line)(ret == 10 + index, "got %d, error %u\n", ret, WSAGetLastError());
+    ok_(__FILE__, line)(buffer[0] == index && buffer[ret - 1] == index,
+            "got datagram %d\n", buffer[0]);
+}
+#define check_recv_batch_datagram(a, b, c) check_recv_batch_datagram_(__LINE__, a, b, c)
+
+static void send_recv_batch_datagrams(SOCKET s, unsigned int first, unsigned int count)
+{
+    char buffer[64];
+    unsigned int i;
+    int ret;
+
+    for (i = first; i < first + count; ++i)
+    {
+        memset(buffer, i, 10 + i);
+        ret = send(s, buffer, 10 + i, 0);
+        ok(ret == 10 + i, "got %d, error %u\n", ret, WSAGetLastError());
+    }
+}
+
+/* runs in a child process with WINESOCKBATCH set, which makes Wine prefetch
+ * datagrams; nothing of that may be visible to the application */
+static void test_recv_batch_child(void)
+{
+    const struct sockaddr_in bind_addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    const struct timeval timeout = {0};
+    struct sockaddr_in addr;
+    SOCKET client, server;
+    HANDLE duplicate;
+    char buffer[64];
+    u_long value;
+    fd_set set;
+    int ret, len;
+
+    client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    server = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    set_blocking(server, FALSE);
+
+    ret = bind(server, (const struct sockaddr *)&bind_addr, sizeof(bind_addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(server, (struct sockaddr *)&addr, &len);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ret = connect(client, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+
+    send_recv_batch_datagrams(client, 0, 5);
+
+    check_recv_batch_datagram(server, 0, 0);
+
+    /* the remaining datagrams may now be queued in the client */
+    value = 0;
+    ret = ioctlsocket(server, FIONREAD, &value);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ok(value == 11 || broken(value == 11 + 12 + 13 + 14) /* Windows reports all pending data */,
+            "got %lu\n", value);
+
+    FD_ZERO(&set);
+    FD_SET(server, &set);
+    ret = select(0, &set, NULL, NULL, &timeout);
+    ok(ret == 1, "got %d\n", ret);
+
+    check_recv_batch_datagram(server, MSG_PEEK, 1);
+    check_recv_batch_datagram(server, 0, 1);
+    check_recv_batch_datagram(server, 0, 2);
+
+    /* datagrams arriving later have to be returned after the queued ones */
+    send_recv_batch_datagrams(client, 5, 2);
+    check_recv_batch_datagram(server, 0, 3);
+    check_recv_batch_datagram(server, 0, 4);
+    check_recv_batch_datagram(server, 0, 5);
+    check_recv_batch_datagram(server, 0, 6);
+
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(ret == -1, "got %d\n", ret);
+    ok(WSAGetLastError() == WSAEWOULDBLOCK, "got error %u\n", WSAGetLastError());
+
+    FD_ZERO(&set);
+    FD_SET(server, &set);
+    ret = select(0, &set, NULL, NULL, &timeout);
+    ok(!ret, "got %d\n", ret);
+
+    value = 0xdeadbeef;
+    ret = ioctlsocket(server, FIONREAD, &value);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ok(!value, "got %lu\n", value);
+
+    /* the batch is refilled once it is empty */
+    send_recv_batch_datagrams(client, 7, 3);
+    check_recv_batch_datagram(server, 0, 7);
+
+    /* datagrams queued for the old handle may be dropped, but never returned
+     * after newer ones */
+    ret = DuplicateHandle(GetCurrentProcess(), (HANDLE)server, GetCurrentProcess(), &duplicate,
+            0, FALSE, DUPLICATE_SAME_ACCESS | DUPLICATE_CLOSE_SOURCE);
+    ok(ret, "got error %lu\n", GetLastError());
+    while ((ret = recv((SOCKET)duplicate, buffer, sizeof(buffer), 0)) > 0)
+        ok(ret == 18 || ret == 19, "got %d\n", ret);
+    ok(WSAGetLastError() == WSAEWOULDBLOCK, "got error %u\n", WSAGetLastError());
+    send_recv_batch_datagrams(client, 10, 1);
+    check_recv_batch_datagram((SOCKET)duplicate, 0, 10);
+
+    CloseHandle(duplicate);
+    closesocket(client);
+}
+
+static void test_recv_batch(void)
+{
+    STARTUPINFOA si = {.cb = sizeof(si)};
+    PROCESS_INFORMATION pi;
+    char cmdline[MAX_PATH];
+    char **argv;
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "%s %s recv_batch", argv[0], argv[1]);
+    SetEnvironmentVariableA("WINESOCKBATCH", "4");
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    ok(ret, "got error %lu\n", GetLastError());
+    SetEnvironmentVariableA("WINESOCKBATCH", NULL);
+    wait_child_process(pi.hProcess);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+}
+
 START_TEST( sock )
 {
+    char **argv;
     int i;
 
 /* Leave these tests at the beginning. They depend on WSAStartup not having been
@@ -14077,6 +14210,13 @@ START_TEST( sock )
 
     Init();
 
+    if (winetest_get_mainargs(&argv) >= 3 && !strcmp(argv[2], "recv_batch"))
+    {
+        test_recv_batch_child();
+        Exit();
+        return;
+    }
+
     test_set_getsockopt();
     test_reuseaddr();
     test_ip_pktinfo();
@@ -14148,6 +14288,7 @@ START_TEST( sock )
     test_icmp();
     test_connect_udp();
     test_tcp_sendto_recvfrom();
+    test_recv_batch();
 
     /* There is apparently an obscure interaction between this test and
      * test_WSAGetOverlappedResult().
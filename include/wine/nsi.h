@@ -444,6 +444,16 @@ struct nsiproxy_request_notification
     UINT table;
 };
 
+/* Change counter shared by nsiproxy; enumerations of tables that only change
+ * through reported notifications may be reused while it stays the same. */
+#define NSIPROXY_WINE_GENERATION_NAME L"\\BaseNamedObjects\\__wine_nsiproxy_generation"
+
+struct nsiproxy_generation
+{
+    LONG generation;  /* incremented for every change notification */
+    LONG monitoring;  /* non-zero while changes are being monitored */
+};
+
 /* Undocumented Nsi api */
 
 #define NSI_PARAM_TYPE_RW      0
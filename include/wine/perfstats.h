@@ -0,0 +1,47 @@
+/*
+ * Wine runtime statistics
+ *
+ * Copyright 2024 The Wine Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_WINE_PERFSTATS_H
+#define __WINE_WINE_PERFSTATS_H
+
+#include <windef.h>
+#include <winternl.h>
+
+/* upper bound of the wineserver request numbers */
+#define WINE_STATS_MAX_REQUESTS 512
+
+struct wine_runtime_stats
+{
+    ULONG64 server_requests[WINE_STATS_MAX_REQUESTS]; /* wineserver calls per request type */
+    ULONG64 heap_committed;             /* committed bytes in all heaps */
+    ULONG64 heap_free;                  /* free bytes in all heaps */
+    ULONG64 heap_allocs;                /* allocations since statistics were first queried */
+    ULONG64 heap_lfh_allocs;            /* allocations served by the low fragmentation heap */
+    ULONG   heap_count;                 /* number of heaps */
+    ULONG   threadpool_count;           /* number of thread pools */
+    ULONG   threadpool_workers;         /* worker threads in all thread pools */
+    ULONG   threadpool_busy_workers;    /* worker threads running a callback */
+    ULONG   threadpool_queued;          /* callbacks waiting for a worker */
+    ULONG   virtual_views;              /* number of virtual memory views */
+};
+
+NTSYSAPI NTSTATUS WINAPI __wine_get_runtime_stats( struct wine_runtime_stats *stats, ULONG size );
+
+#endif  /* __WINE_WINE_PERFSTATS_H */
@@ -824,6 +824,31 @@ typedef union
 } irp_params_t;
 
 
+typedef struct
+{
+    irp_params_t     params;
+    obj_handle_t     handle;
+    thread_id_t      client_tid;
+    client_ptr_t     client_thread;
+    data_size_t      in_size;
+    int              __pad;
+} irp_request_t;
+
+
+typedef struct
+{
+    obj_handle_t     handle;
+    unsigned int     status;
+    client_ptr_t     user_ptr;
+    int              pending;
+    unsigned int     iosb_status;
+    data_size_t      result;
+    data_size_t      size;
+} irp_result_t;
+
+#define MAX_DEVICE_REQUEST_BATCH 16
+
+
 typedef struct
 {
     client_ptr_t   base;
@@ -1822,7 +1847,7 @@ struct recv_socket_reply
     obj_handle_t wait;
     unsigned int options;
     int          nonblocking;
-    char __pad_20[4];
+    int          batch;
 };
 
 
@@ -1894,6 +1919,37 @@ struct socket_get_icmp_id_reply
 
 
 
+struct get_socket_poll_state_request
+{
+    struct request_header __header;
+    /* VARARG(sockets,uints); */
+    char __pad_12[4];
+};
+struct get_socket_poll_state_reply
+{
+    struct reply_header __header;
+    /* VARARG(state,uints); */
+};
+#define SOCKET_POLL_STATE_SERVER    0x01
+#define SOCKET_POLL_STATE_CONNECTED 0x02
+#define SOCKET_POLL_STATE_OOBINLINE 0x04
+
+
+
+struct set_socket_buffered_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    int          delta;
+    char __pad_20[4];
+};
+struct set_socket_buffered_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct get_next_console_request_request
 {
     struct request_header __header;
@@ -2435,15 +2491,22 @@ struct get_key_value_request
 {
     struct request_header __header;
     obj_handle_t hkey;
+    unsigned int cache;
     /* VARARG(name,unicode_str); */
+    char __pad_20[4];
 };
 struct get_key_value_reply
 {
     struct reply_header __header;
     int          type;
     data_size_t  total;
+    unsigned int serial_index;
+    unsigned int serial;
     /* VARARG(data,bytes); */
 };
+#define REG_CACHE_MACHINE 0x01
+#define REG_CACHE_USER    0x02
+#define REG_SERIAL_COUNT  1024
 
 
 
@@ -5032,25 +5095,16 @@ struct get_next_device_request_request
 {
     struct request_header __header;
     obj_handle_t manager;
-    obj_handle_t prev;
-    unsigned int status;
-    client_ptr_t user_ptr;
-    int          pending;
-    unsigned int iosb_status;
-    data_size_t  result;
-    /* VARARG(data,bytes); */
-    char __pad_44[4];
+    unsigned int max_count;
+    /* VARARG(results,irp_results); */
+    char __pad_20[4];
 };
 struct get_next_device_request_reply
 {
     struct reply_header __header;
-    irp_params_t params;
-    obj_handle_t next;
-    thread_id_t  client_tid;
-    client_ptr_t client_thread;
+    unsigned int count;
     data_size_t  in_size;
-    /* VARARG(next_data,bytes); */
-    char __pad_60[4];
+    /* VARARG(next,irp_requests); */
 };
 
 
@@ -5698,6 +5752,8 @@ enum request
     REQ_socket_get_events,
     REQ_socket_send_icmp_id,
     REQ_socket_get_icmp_id,
+    REQ_get_socket_poll_state,
+    REQ_set_socket_buffered,
     REQ_get_next_console_request,
     REQ_read_directory_changes,
     REQ_read_change,
@@ -5989,6 +6045,8 @@ union generic_request
     struct socket_get_events_request socket_get_events_request;
     struct socket_send_icmp_id_request socket_send_icmp_id_request;
     struct socket_get_icmp_id_request socket_get_icmp_id_request;
+    struct get_socket_poll_state_request get_socket_poll_state_request;
+    struct set_socket_buffered_request set_socket_buffered_request;
     struct get_next_console_request_request get_next_console_request_request;
     struct read_directory_changes_request read_directory_changes_request;
     struct read_change_request read_change_request;
@@ -6278,6 +6336,8 @@ union generic_reply
     struct socket_get_events_reply socket_get_events_reply;
     struct socket_send_icmp_id_reply socket_send_icmp_id_reply;
     struct socket_get_icmp_id_reply socket_get_icmp_id_reply;
+    struct get_socket_poll_state_reply get_socket_poll_state_reply;
+    struct set_socket_buffered_reply set_socket_buffered_reply;
     struct get_next_console_request_reply get_next_console_request_reply;
     struct read_directory_changes_reply read_directory_changes_reply;
     struct read_change_reply read_change_reply;
@@ -6507,7 +6567,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 786
+#define SERVER_PROTOCOL_VERSION 790
 
 /* ### protocol_version end ### */
 
@@ -90,7 +90,8 @@ struct device_manager
     struct object          obj;            /* object header */
     struct list            devices;        /* list of devices */
     struct list            requests;       /* list of pending irps across all devices */
-    struct irp_call       *current_call;   /* call currently executed on client side */
+    struct irp_call       *current_calls[MAX_DEVICE_REQUEST_BATCH]; /* calls currently executed on client side */
+    unsigned int           current_count;  /* number of calls currently executed on client side */
     struct wine_rb_tree    kernel_objects; /* map of objects that have client side pointer associated */
 };
 
@@ -787,12 +788,10 @@ static void device_manager_destroy( struct object *obj )
     struct device_manager *manager = (struct device_manager *)obj;
     struct kernel_object *kernel_object;
     struct list *ptr;
+    unsigned int i;
 
-    if (manager->current_call)
-    {
-        release_object( manager->current_call );
-        manager->current_call = NULL;
-    }
+    for (i = 0; i < manager->current_count; i++) release_object( manager->current_calls[i] );
+    manager->current_count = 0;
 
     while (manager->kernel_objects.root)
     {
@@ -824,7 +823,7 @@ static struct device_manager *create_device_manager(void)
 
     if ((manager = alloc_object( &device_manager_ops )))
     {
-        manager->current_call = NULL;
+        manager->current_count = 0;
         list_init( &manager->devices );
         list_init( &manager->requests );
         wine_rb_init( &manager->kernel_objects, compare_kernel_object );
@@ -932,96 +931,167 @@ DECL_HANDLER(delete_device)
 }
 
 
-/* retrieve the next pending device irp request */
+/* process the result of an irp returned by a previous get_next_device_request */
+static void process_irp_result( struct irp_call *irp, const irp_result_t *result, const void *out_data )
+{
+    irp->user_ptr = result->user_ptr;
+
+    if (irp->async)
+    {
+        if (result->pending)
+            set_async_pending( irp->async );
+        async_set_initial_status( irp->async, result->status );
+
+        if (result->handle)
+        {
+            set_irp_result( irp, result->iosb_status, out_data, result->size, result->result );
+        }
+        else
+        {
+            async_wake_obj( irp->async );
+            if (irp->canceled)
+            {
+                /* if it was canceled during dispatch, we couldn't queue cancel
+                 * call without client pointer, so we need to do it now */
+                cancel_irp_call( irp );
+            }
+        }
+    }
+    else
+    {
+        set_irp_result( irp, result->status, NULL, 0, 0 );
+    }
+
+    if (result->handle)
+        close_handle( current->process, result->handle );  /* avoid an extra round-trip for close */
+
+    free_irp_params( irp );
+    release_object( irp );
+}
+
+/* get the size needed to return an irp to the client */
+static data_size_t get_irp_request_size( const struct irp_call *irp )
+{
+    return sizeof(irp_request_t) + (irp->iosb ? (irp->iosb->in_size + 7) & ~7 : 0);
+}
+
+/* retrieve the next pending device irp requests */
 DECL_HANDLER(get_next_device_request)
 {
+    const char *data = get_req_data();
+    data_size_t left = get_req_data_size();
+    data_size_t size, reply_size = 0, max_size = get_reply_max_size();
+    unsigned int i, count = 0, max_count = max( 1, min( req->max_count, MAX_DEVICE_REQUEST_BATCH ));
     struct irp_call *irp;
     struct device_manager *manager;
     struct list *ptr;
     struct iosb *iosb;
+    irp_result_t result;
+    irp_request_t *next;
+    char *reply_data;
 
     if (!(manager = (struct device_manager *)get_handle_obj( current->process, req->manager,
                                                              0, &device_manager_ops )))
         return;
 
-    /* process result of previous call */
-    if (manager->current_call)
+    /* process results of previous calls, they are returned in the same order */
+    for (i = 0; i < manager->current_count; i++)
     {
-        irp = manager->current_call;
-        irp->user_ptr = req->user_ptr;
-
-        if (irp->async)
-        {
-            if (req->pending)
-                set_async_pending( irp->async );
-            async_set_initial_status( irp->async, req->status );
+        const void *out_data = NULL;
 
-            if (req->prev)
-            {
-                set_irp_result( irp, req->iosb_status, get_req_data(), get_req_data_size(), req->result );
-            }
-            else
-            {
-                async_wake_obj( irp->async );
-                if (irp->canceled)
-                {
-                    /* if it was canceled during dispatch, we couldn't queue cancel
-                     * call without client pointer, so we need to do it now */
-                    cancel_irp_call( irp );
-                }
-            }
-        }
-        else
+        memset( &result, 0, sizeof(result) );
+        if (left >= sizeof(result))
         {
-            set_irp_result( irp, req->status, NULL, 0, 0 );
+            memcpy( &result, data, sizeof(result) );
+            data += sizeof(result);
+            left -= sizeof(result);
+            out_data = data;
+            result.size = min( result.size, left );
+            size = min( (result.size + 7) & ~7, left );
+            data += size;
+            left -= size;
         }
+        else result.status = STATUS_INVALID_PARAMETER;
 
-        if (req->prev)
-            close_handle( current->process, req->prev );  /* avoid an extra round-trip for close */
-
-        free_irp_params( irp );
-        release_object( irp );
-        manager->current_call = NULL;
+        process_irp_result( manager->current_calls[i], &result, out_data );
     }
+    manager->current_count = 0;
 
     clear_error();
 
-    if ((ptr = list_head( &manager->requests )))
+    if (!(ptr = list_head( &manager->requests )))
+    {
+        set_error( STATUS_PENDING );
+        release_object( manager );
+        return;
+    }
+
+    /* return as many irps as fit in the reply buffer */
+    LIST_FOR_EACH_ENTRY( irp, &manager->requests, struct irp_call, mgr_entry )
+    {
+        size = get_irp_request_size( irp );
+        if (count == max_count || reply_size + size > max_size) break;
+        reply_size += size;
+        count++;
+    }
+
+    if (!count)
+    {
+        irp = LIST_ENTRY( ptr, struct irp_call, mgr_entry );
+        reply->in_size = get_irp_request_size( irp );
+        set_error( STATUS_BUFFER_OVERFLOW );
+        release_object( manager );
+        return;
+    }
+
+    if (!(reply_data = mem_alloc( reply_size )))
+    {
+        release_object( manager );
+        return;
+    }
+    memset( reply_data, 0, reply_size );
+
+    size = 0;
+    while (manager->current_count < count && (ptr = list_head( &manager->requests )))
     {
         struct thread *thread;
 
         irp = LIST_ENTRY( ptr, struct irp_call, mgr_entry );
+        next = (irp_request_t *)(reply_data + size);
 
         thread = irp->thread ? irp->thread : current;
-        reply->client_thread = get_kernel_object_ptr( manager, &thread->obj );
-        reply->client_tid    = get_thread_id( thread );
+        next->client_thread = get_kernel_object_ptr( manager, &thread->obj );
+        next->client_tid    = get_thread_id( thread );
 
-        iosb = irp->iosb;
-        if (iosb)
-            reply->in_size = iosb->in_size;
+        if (irp->file && !(next->handle = alloc_handle( current->process, irp, 0, 0 ))) break;
+        if (!fill_irp_params( manager, irp, &next->params ))
+        {
+            if (next->handle) close_handle( current->process, next->handle );
+            break;
+        }
 
-        if (iosb && iosb->in_size > get_reply_max_size())
-            set_error( STATUS_BUFFER_OVERFLOW );
-        else if (!irp->file || (reply->next = alloc_handle( current->process, irp, 0, 0 )))
+        if ((iosb = irp->iosb))
         {
-            if (fill_irp_params( manager, irp, &reply->params ))
-            {
-                if (iosb)
-                {
-                    set_reply_data_ptr( iosb->in_data, iosb->in_size );
-                    iosb->in_data = NULL;
-                    iosb->in_size = 0;
-                }
-                list_remove( &irp->mgr_entry );
-                list_init( &irp->mgr_entry );
-                /* we already own the object if it's only on manager queue */
-                if (irp->file) grab_object( irp );
-                manager->current_call = irp;
-            }
-            else close_handle( current->process, reply->next );
+            next->in_size = iosb->in_size;
+            if (iosb->in_size) memcpy( next + 1, iosb->in_data, iosb->in_size );
+            free( iosb->in_data );
+            iosb->in_data = NULL;
+            iosb->in_size = 0;
         }
+        size += sizeof(*next) + ((next->in_size + 7) & ~7);
+
+        list_remove( &irp->mgr_entry );
+        list_init( &irp->mgr_entry );
+        /* we already own the object if it's only on manager queue */
+        if (irp->file) grab_object( irp );
+        manager->current_calls[manager->current_count++] = irp;
     }
-    else set_error( STATUS_PENDING );
+
+    /* a failure on a later irp only ends the batch, it will be retried by the next call */
+    if (manager->current_count) clear_error();
+    reply->count = manager->current_count;
+    if (size) set_reply_data_ptr( reply_data, size );
+    else free( reply_data );
 
     release_object( manager );
 }
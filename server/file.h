@@ -137,6 +137,7 @@ struct timeout_user;
 extern timeout_t current_time;
 extern timeout_t monotonic_time;
 extern struct _KUSER_SHARED_DATA *user_shared_data;
+extern unsigned int *registry_serials;
 
 #define TICKS_PER_SEC 10000000
 
@@ -182,10 +183,13 @@ extern struct memory_view *get_exe_view( struct process *process );
 extern struct file *get_view_file( const struct memory_view *view, unsigned int access, unsigned int sharing );
 extern const pe_image_info_t *get_view_image_info( const struct memory_view *view, client_ptr_t *base );
 extern int get_view_nt_name( const struct memory_view *view, struct unicode_str *name );
+extern void init_process_views( struct process *process );
 extern void free_mapped_views( struct process *process );
 extern int get_page_size(void);
 extern struct mapping *create_fd_mapping( struct object *root, const struct unicode_str *name, struct fd *fd,
                                           unsigned int attr, const struct security_descriptor *sd );
+extern struct object *create_registry_serials_mapping( struct object *root, const struct unicode_str *name,
+                                                      unsigned int attr, const struct security_descriptor *sd );
 extern struct object *create_user_data_mapping( struct object *root, const struct unicode_str *name,
                                                 unsigned int attr, const struct security_descriptor *sd );
 
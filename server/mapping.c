@@ -125,6 +125,7 @@ static struct list shared_map_list = LIST_INIT( shared_map_list );
 struct memory_view
 {
     struct list     entry;           /* entry in per-process view list */
+    struct wine_rb_entry tree_entry; /* entry in per-process view tree, keyed by base */
     struct fd      *fd;              /* fd for mapped file */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
@@ -227,9 +228,35 @@ static struct addr_range ranges64;
 
 #define ROUND_SIZE(size)  (((size) + page_mask) & ~page_mask)
 
+/* parsed headers of a PE image file, reused by further mappings of the same file */
+struct image_cache_entry
+{
+    struct list      entry;          /* entry in hash bucket */
+    struct list      lru_entry;      /* entry in LRU list */
+    dev_t            dev;            /* file identity */
+    ino_t            ino;
+    file_pos_t       size;
+    time_t           mtime;
+    long             mtime_nsec;
+    time_t           ctime;
+    pe_image_info_t  image;          /* image info, without map_addr */
+    unsigned int     nb_sec;         /* number of section headers */
+    IMAGE_SECTION_HEADER sec[1];     /* section headers */
+};
+
+#define IMAGE_CACHE_HASH_SIZE 64
+#define IMAGE_CACHE_MAX_ENTRIES 512
+
+static struct list image_cache[IMAGE_CACHE_HASH_SIZE];
+static struct list image_cache_lru = LIST_INIT( image_cache_lru );
+static unsigned int image_cache_count;
+
 void init_memory(void)
 {
+    unsigned int i;
+
     page_mask = sysconf( _SC_PAGESIZE ) - 1;
+    for (i = 0; i < IMAGE_CACHE_HASH_SIZE; i++) list_init( &image_cache[i] );
     free_map_addr( 0x60000000, 0x1c000000 );
     free_map_addr( 0x600000000000, 0x100000000000 );
 }
@@ -355,14 +382,48 @@ static int create_temp_file( file_pos_t size )
     return fd;
 }
 
+static int compare_view_base( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct memory_view *view = WINE_RB_ENTRY_VALUE( entry, struct memory_view, tree_entry );
+    client_ptr_t base = *(const client_ptr_t *)key;
+
+    if (base < view->base) return -1;
+    if (base > view->base) return 1;
+    return 0;
+}
+
+/* initialize the view list and tree of a new process */
+void init_process_views( struct process *process )
+{
+    list_init( &process->views );
+    wine_rb_init( &process->view_tree, compare_view_base );
+}
+
+/* find the view with the highest base address not above addr */
+static struct memory_view *find_view_below( struct process *process, client_ptr_t addr )
+{
+    struct wine_rb_entry *ptr = process->view_tree.root;
+    struct memory_view *view, *ret = NULL;
+
+    while (ptr)
+    {
+        view = WINE_RB_ENTRY_VALUE( ptr, struct memory_view, tree_entry );
+        if (view->base <= addr)
+        {
+            ret = view;
+            ptr = ptr->right;
+        }
+        else ptr = ptr->left;
+    }
+    return ret;
+}
+
 /* find a memory view from its base address */
 struct memory_view *find_mapped_view( struct process *process, client_ptr_t base )
 {
-    struct memory_view *view;
-
-    LIST_FOR_EACH_ENTRY( view, &process->views, struct memory_view, entry )
-        if (view->base == base) return view;
+    struct wine_rb_entry *ptr = wine_rb_get( &process->view_tree, &base );
 
+    if (ptr) return WINE_RB_ENTRY_VALUE( ptr, struct memory_view, tree_entry );
     set_error( STATUS_NOT_MAPPED_VIEW );
     return NULL;
 }
@@ -370,11 +431,9 @@ struct memory_view *find_mapped_view( struct process *process, client_ptr_t base
 /* find a memory view from any address inside it */
 static struct memory_view *find_mapped_addr( struct process *process, client_ptr_t addr )
 {
-    struct memory_view *view;
-
-    LIST_FOR_EACH_ENTRY( view, &process->views, struct memory_view, entry )
-        if (addr >= view->base && addr < view->base + view->size) return view;
+    struct memory_view *view = find_view_below( process, addr );
 
+    if (view && addr < view->base + view->size) return view;
     set_error( STATUS_NOT_MAPPED_VIEW );
     return NULL;
 }
@@ -388,13 +447,9 @@ static int is_valid_view_addr( struct process *process, client_ptr_t addr, mem_s
     if (addr & page_mask) return 0;
     if (addr + size < addr) return 0;  /* overflow */
 
-    /* check for overlapping view */
-    LIST_FOR_EACH_ENTRY( view, &process->views, struct memory_view, entry )
-    {
-        if (view->base + view->size <= addr) continue;
-        if (view->base >= addr + size) continue;
+    /* views don't overlap, so only the last one starting below the end can */
+    if ((view = find_view_below( process, addr + size - 1 )) && view->base + view->size > addr)
         return 0;
-    }
     return 1;
 }
 
@@ -425,6 +480,7 @@ static void add_process_view( struct thread *thread, struct memory_view *view )
     struct process *process = thread->process;
     struct unicode_str name;
 
+    wine_rb_put( &process->view_tree, &view->base, &view->tree_entry );
     if (view->flags & SEC_IMAGE)
     {
         if (is_process_init_done( process ))
@@ -448,11 +504,12 @@ static void add_process_view( struct thread *thread, struct memory_view *view )
     list_add_tail( &process->views, &view->entry );
 }
 
-static void free_memory_view( struct memory_view *view )
+static void free_memory_view( struct process *process, struct memory_view *view )
 {
     if (view->fd) release_object( view->fd );
     if (view->committed) release_object( view->committed );
     if (view->shared) release_object( view->shared );
+    wine_rb_remove( &process->view_tree, &view->tree_entry );
     list_remove( &view->entry );
     free( view );
 }
@@ -463,7 +520,7 @@ void free_mapped_views( struct process *process )
     struct list *ptr;
 
     while ((ptr = list_head( &process->views )))
-        free_memory_view( LIST_ENTRY( ptr, struct memory_view, entry ));
+        free_memory_view( process, LIST_ENTRY( ptr, struct memory_view, entry ));
 }
 
 /* find the shared PE mapping for a given mapping */
@@ -692,8 +749,81 @@ static int load_clr_header( IMAGE_COR20_HEADER *hdr, size_t va, size_t size, int
     return 0;
 }
 
+static long get_mtime_nsec( const struct stat *st )
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static struct list *get_image_cache_bucket( const struct stat *st )
+{
+    return &image_cache[(unsigned int)(st->st_ino ^ st->st_dev) % IMAGE_CACHE_HASH_SIZE];
+}
+
+/* find the cached image parameters of a file, if it hasn't changed since */
+static struct image_cache_entry *find_cached_image( const struct stat *st )
+{
+    struct image_cache_entry *cached;
+
+    LIST_FOR_EACH_ENTRY( cached, get_image_cache_bucket( st ), struct image_cache_entry, entry )
+    {
+        if (cached->dev != st->st_dev || cached->ino != st->st_ino) continue;
+        if (cached->size != st->st_size || cached->mtime != st->st_mtime ||
+            cached->mtime_nsec != get_mtime_nsec( st ) || cached->ctime != st->st_ctime)
+            return NULL;
+        list_remove( &cached->lru_entry );
+        list_add_head( &image_cache_lru, &cached->lru_entry );
+        return cached;
+    }
+    return NULL;
+}
+
+static void free_cached_image( struct image_cache_entry *cached )
+{
+    list_remove( &cached->entry );
+    list_remove( &cached->lru_entry );
+    image_cache_count--;
+    free( cached );
+}
+
+/* remember the image parameters of a file for further mappings */
+static void add_cached_image( const struct stat *st, const pe_image_info_t *image,
+                              const IMAGE_SECTION_HEADER *sec, unsigned int nb_sec )
+{
+    struct image_cache_entry *cached;
+
+    LIST_FOR_EACH_ENTRY( cached, get_image_cache_bucket( st ), struct image_cache_entry, entry )
+    {
+        if (cached->dev != st->st_dev || cached->ino != st->st_ino) continue;
+        free_cached_image( cached );  /* stale entry */
+        break;
+    }
+
+    if (!(cached = malloc( offsetof( struct image_cache_entry, sec ) + nb_sec * sizeof(*sec) ))) return;
+    cached->dev        = st->st_dev;
+    cached->ino        = st->st_ino;
+    cached->size       = st->st_size;
+    cached->mtime      = st->st_mtime;
+    cached->mtime_nsec = get_mtime_nsec( st );
+    cached->ctime      = st->st_ctime;
+    cached->image      = *image;
+    cached->image.map_addr = 0;
+    cached->nb_sec     = nb_sec;
+    memcpy( cached->sec, sec, nb_sec * sizeof(*sec) );
+    list_add_head( get_image_cache_bucket( st ), &cached->entry );
+    list_add_head( &image_cache_lru, &cached->lru_entry );
+
+    if (++image_cache_count > IMAGE_CACHE_MAX_ENTRIES)
+        free_cached_image( LIST_ENTRY( list_tail( &image_cache_lru ), struct image_cache_entry, lru_entry ));
+}
+
 /* retrieve the mapping parameters for an executable (PE) image */
-static unsigned int get_image_params( struct mapping *mapping, file_pos_t file_size, int unix_fd )
+static unsigned int get_image_params( struct mapping *mapping, const struct stat *st, int unix_fd )
 {
     static const char builtin_signature[] = "Wine builtin DLL";
     static const char fakedll_signature[] = "Wine placeholder DLL";
@@ -715,11 +845,24 @@ static unsigned int get_image_params( struct mapping *mapping, file_pos_t file_s
             IMAGE_OPTIONAL_HEADER64 hdr64;
         } opt;
     } nt;
+    struct image_cache_entry *cached;
+    file_pos_t file_size = st->st_size;
     off_t pos;
     int size, has_relocs;
     size_t mz_size, clr_va = 0, clr_size = 0;
     unsigned int i;
 
+    if (file_size && (cached = find_cached_image( st )))
+    {
+        mapping->image = cached->image;
+        mapping->image.map_addr = get_fd_map_address( mapping->fd );
+        if (!mapping->size) mapping->size = mapping->image.map_size;
+        else if (mapping->size > mapping->image.map_size) return STATUS_SECTION_TOO_BIG;
+        if (!build_shared_mapping( mapping, unix_fd, cached->sec, cached->nb_sec ))
+            return STATUS_INVALID_FILE_FOR_SECTION;
+        return STATUS_SUCCESS;
+    }
+
     /* load the headers */
 
     if (!file_size) return STATUS_INVALID_FILE_FOR_SECTION;
@@ -883,6 +1026,8 @@ static unsigned int get_image_params( struct mapping *mapping, file_pos_t file_s
         }
     }
 
+    add_cached_image( st, &mapping->image, sec, nt.FileHeader.NumberOfSections );
+
     if (!build_shared_mapping( mapping, unix_fd, sec, nt.FileHeader.NumberOfSections ))
         return STATUS_INVALID_FILE_FOR_SECTION;
 
@@ -978,7 +1123,7 @@ static struct mapping *create_mapping( struct object *root, const struct unicode
         }
         if (flags & SEC_IMAGE)
         {
-            unsigned int err = get_image_params( mapping, st.st_size, unix_fd );
+            unsigned int err = get_image_params( mapping, &st, unix_fd );
             if (!err) return mapping;
             set_error( err );
             goto error;
@@ -1239,6 +1384,19 @@ struct object *create_user_data_mapping( struct object *root, const struct unico
     return &mapping->obj;
 }
 
+struct object *create_registry_serials_mapping( struct object *root, const struct unicode_str *name,
+                                               unsigned int attr, const struct security_descriptor *sd )
+{
+    void *ptr;
+    struct mapping *mapping;
+
+    if (!(mapping = create_mapping( root, name, attr, REG_SERIAL_COUNT * sizeof(*registry_serials),
+                                    SEC_COMMIT, 0, FILE_READ_DATA | FILE_WRITE_DATA, sd ))) return NULL;
+    ptr = mmap( NULL, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, get_unix_fd( mapping->fd ), 0 );
+    if (ptr != MAP_FAILED) registry_serials = ptr;
+    return &mapping->obj;
+}
+
 /* create a file mapping */
 DECL_HANDLER(create_mapping)
 {
@@ -1454,7 +1612,7 @@ DECL_HANDLER(unmap_view)
 
     if (!view) return;
     generate_dll_event( current, DbgUnloadDllStateChange, view );
-    free_memory_view( view );
+    free_memory_view( current->process, view );
 }
 
 /* get information about a mapped image view */
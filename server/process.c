@@ -688,7 +688,7 @@ struct process *create_process( int fd, struct process *parent, unsigned int fla
     list_init( &process->locks );
     list_init( &process->asyncs );
     list_init( &process->classes );
-    list_init( &process->views );
+    init_process_views( process );
 
     process->end_time = 0;
 
@@ -1630,7 +1630,14 @@ DECL_HANDLER(set_process_info)
 
     if ((process = get_process_from_handle( req->handle, PROCESS_SET_INFORMATION )))
     {
-        if (req->mask & SET_PROCESS_INFO_PRIORITY) process->priority = req->priority;
+        if (req->mask & SET_PROCESS_INFO_PRIORITY)
+        {
+            struct thread *thread;
+
+            LIST_FOR_EACH_ENTRY( thread, &process->thread_list, struct thread, proc_entry )
+                set_thread_priority( thread, req->priority, thread->priority );
+            process->priority = req->priority;
+        }
         if (req->mask & SET_PROCESS_INFO_AFFINITY) set_process_affinity( process, req->affinity );
         release_object( process );
     }
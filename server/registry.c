@@ -120,6 +120,11 @@ struct key_value
 
 /* the root of the registry tree */
 static struct key *root_key;
+/* the \Registry\Machine and \Registry\User hives */
+static struct key *machine_key, *users_key;
+
+/* change serials shared with the clients, see get_key_value */
+unsigned int *registry_serials = NULL;
 
 static const timeout_t ticks_1601_to_1970 = (timeout_t)86400 * (369 * 365 + 89) * TICKS_PER_SEC;
 static const timeout_t save_period = 30 * -TICKS_PER_SEC;  /* delay between periodic saves */
@@ -646,12 +651,27 @@ static void key_unlink_name( struct object *obj, struct object_name *name )
     }
 }
 
+/* get the index of the change serial of a key */
+static inline unsigned int get_key_serial_index( const struct key *key )
+{
+    return 1 + ((unsigned long)key / sizeof(*key)) % (REG_SERIAL_COUNT - 1);
+}
+
+/* invalidate the client caches of a key's values */
+static void update_key_serial( const struct key *key )
+{
+    if (registry_serials) registry_serials[get_key_serial_index( key )]++;
+}
+
 /* close the notification associated with a handle */
 static int key_close_handle( struct object *obj, struct process *process, obj_handle_t handle )
 {
     struct key * key = (struct key *) obj;
     struct notify *notify = find_notify( key, process, handle );
     if (notify) do_notification( key, notify, 1 );
+    /* the client cache only sees its own closes, make sure that values cached
+     * for this handle aren't used once the handle value is reused */
+    if (!current || current->process != process) update_key_serial( key );
     return 1;  /* ok to close */
 }
 
@@ -760,9 +780,30 @@ static void check_notify( struct key *key, unsigned int change, int not_subtree
     }
 }
 
+/* invalidate the client caches of all keys */
+static void update_all_key_serials(void)
+{
+    unsigned int i;
+
+    if (registry_serials) for (i = 1; i < REG_SERIAL_COUNT; i++) registry_serials[i]++;
+}
+
+/* check if the values of a key may be cached by the client */
+static int is_key_cacheable( const struct key *key, unsigned int cache )
+{
+    const struct key *parent;
+
+    if (!registry_serials) return 0;
+    while ((parent = get_parent( key )) && parent != root_key) key = parent;
+    if (key == machine_key) return cache & REG_CACHE_MACHINE;
+    if (key == users_key) return cache & REG_CACHE_USER;
+    return 0;
+}
+
 /* update key modification time */
 static void touch_key( struct key *key, unsigned int change )
 {
+    update_key_serial( key );
     key->modif = current_time;
     make_dirty( key );
 
@@ -1085,6 +1126,7 @@ static int delete_key( struct key *key, int recurse )
     }
 
     if (debug_level > 1) dump_operation( key, NULL, "Delete" );
+    update_key_serial( key );
     key->flags |= KEY_DELETED;
     unlink_named_object( &key->obj );
     touch_key( parent, REG_NOTIFY_CHANGE_NAME );
@@ -1800,6 +1842,7 @@ static void load_registry( struct key *key, obj_handle_t handle )
         {
             load_keys( key, NULL, f, -1 );
             fclose( f );
+            update_all_key_serials();
         }
         else file_set_error();
     }
@@ -1933,6 +1976,8 @@ void init_registry(void)
 
     if (!(key = create_key_recursive( root_key, &HKU_name, current_time )))
         fatal_error( "could not create User\\.Default registry key\n" );
+    machine_key = hklm;
+    users_key = get_parent( key );
 
     load_init_registry_from_file( "userdef.reg", key );
     release_object( key );
@@ -2282,6 +2327,11 @@ DECL_HANDLER(get_key_value)
     reply->total = 0;
     if ((key = get_hkey_obj( req->hkey, KEY_QUERY_VALUE )))
     {
+        if (is_key_cacheable( key, req->cache ))
+        {
+            reply->serial_index = get_key_serial_index( key );
+            reply->serial = registry_serials[reply->serial_index];
+        }
         get_value( key, &name, &reply->type, &reply->total );
         release_object( key );
     }
@@ -178,6 +178,8 @@ DECL_HANDLER(send_socket);
 DECL_HANDLER(socket_get_events);
 DECL_HANDLER(socket_send_icmp_id);
 DECL_HANDLER(socket_get_icmp_id);
+DECL_HANDLER(get_socket_poll_state);
+DECL_HANDLER(set_socket_buffered);
 DECL_HANDLER(get_next_console_request);
 DECL_HANDLER(read_directory_changes);
 DECL_HANDLER(read_change);
@@ -468,6 +470,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_socket_get_events,
     (req_handler)req_socket_send_icmp_id,
     (req_handler)req_socket_get_icmp_id,
+    (req_handler)req_get_socket_poll_state,
+    (req_handler)req_set_socket_buffered,
     (req_handler)req_get_next_console_request,
     (req_handler)req_read_directory_changes,
     (req_handler)req_read_change,
@@ -1083,6 +1087,7 @@ C_ASSERT( sizeof(struct recv_socket_request) == 64 );
 C_ASSERT( FIELD_OFFSET(struct recv_socket_reply, wait) == 8 );
 C_ASSERT( FIELD_OFFSET(struct recv_socket_reply, options) == 12 );
 C_ASSERT( FIELD_OFFSET(struct recv_socket_reply, nonblocking) == 16 );
+C_ASSERT( FIELD_OFFSET(struct recv_socket_reply, batch) == 20 );
 C_ASSERT( sizeof(struct recv_socket_reply) == 24 );
 C_ASSERT( FIELD_OFFSET(struct send_socket_request, async) == 16 );
 C_ASSERT( FIELD_OFFSET(struct send_socket_request, force_async) == 56 );
@@ -1106,6 +1111,11 @@ C_ASSERT( FIELD_OFFSET(struct socket_get_icmp_id_request, icmp_seq) == 16 );
 C_ASSERT( sizeof(struct socket_get_icmp_id_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct socket_get_icmp_id_reply, icmp_id) == 8 );
 C_ASSERT( sizeof(struct socket_get_icmp_id_reply) == 16 );
+C_ASSERT( sizeof(struct get_socket_poll_state_request) == 16 );
+C_ASSERT( sizeof(struct get_socket_poll_state_reply) == 8 );
+C_ASSERT( FIELD_OFFSET(struct set_socket_buffered_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct set_socket_buffered_request, delta) == 16 );
+C_ASSERT( sizeof(struct set_socket_buffered_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_next_console_request_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_next_console_request_request, signal) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_next_console_request_request, read) == 20 );
@@ -1268,10 +1278,13 @@ C_ASSERT( FIELD_OFFSET(struct set_key_value_request, type) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_key_value_request, namelen) == 20 );
 C_ASSERT( sizeof(struct set_key_value_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_key_value_request, hkey) == 12 );
-C_ASSERT( sizeof(struct get_key_value_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_key_value_request, cache) == 16 );
+C_ASSERT( sizeof(struct get_key_value_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, type) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, total) == 12 );
-C_ASSERT( sizeof(struct get_key_value_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, serial_index) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, serial) == 20 );
+C_ASSERT( sizeof(struct get_key_value_reply) == 24 );
 C_ASSERT( FIELD_OFFSET(struct enum_key_value_request, hkey) == 12 );
 C_ASSERT( FIELD_OFFSET(struct enum_key_value_request, index) == 16 );
 C_ASSERT( FIELD_OFFSET(struct enum_key_value_request, info_class) == 20 );
@@ -2146,19 +2159,11 @@ C_ASSERT( FIELD_OFFSET(struct delete_device_request, manager) == 12 );
 C_ASSERT( FIELD_OFFSET(struct delete_device_request, device) == 16 );
 C_ASSERT( sizeof(struct delete_device_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, manager) == 12 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, prev) == 16 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, status) == 20 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, user_ptr) == 24 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, pending) == 32 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, iosb_status) == 36 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, result) == 40 );
-C_ASSERT( sizeof(struct get_next_device_request_request) == 48 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, params) == 8 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, next) == 40 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, client_tid) == 44 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, client_thread) == 48 );
-C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, in_size) == 56 );
-C_ASSERT( sizeof(struct get_next_device_request_reply) == 64 );
+C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, max_count) == 16 );
+C_ASSERT( sizeof(struct get_next_device_request_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, count) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, in_size) == 12 );
+C_ASSERT( sizeof(struct get_next_device_request_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_kernel_object_ptr_request, manager) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_kernel_object_ptr_request, handle) == 16 );
 C_ASSERT( sizeof(struct get_kernel_object_ptr_request) == 24 );
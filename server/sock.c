@@ -248,6 +248,9 @@ struct sock
     unsigned int        sndbuf;      /* advisory send buffer size */
     unsigned int        rcvtimeo;    /* receive timeout in ms */
     unsigned int        sndtimeo;    /* send timeout in ms */
+    int                 client_buffered; /* number of handles with datagrams prefetched by the client */
+    struct process     *buffered_process; /* process and handle which last prefetched datagrams */
+    obj_handle_t        buffered_handle;
     struct
     {
         unsigned short icmp_id;
@@ -1433,6 +1436,15 @@ static void sock_poll_event( struct fd *fd, int event )
     release_object( sock );
 }
 
+/* datagrams prefetched by the client are invisible to poll(), report them as readable */
+static void sock_signal_buffered( struct sock *sock )
+{
+    int event = sock_dispatch_asyncs( sock, POLLIN, 0 );
+
+    sock_dispatch_events( sock, sock->state, event );
+    complete_async_polls( sock, event, 0 );
+}
+
 static void sock_dump( struct object *obj, int verbose )
 {
     struct sock *sock = (struct sock *)obj;
@@ -1634,6 +1646,13 @@ static int sock_close_handle( struct object *obj, struct process *process, obj_h
 {
     struct sock *sock = (struct sock *)obj;
 
+    /* the client drops its prefetched datagrams when the handle is closed */
+    if (sock->buffered_process == process && sock->buffered_handle == handle)
+    {
+        sock->client_buffered = 0;
+        sock->buffered_process = NULL;
+    }
+
     if (sock->obj.handle_count == 1) /* last handle */
     {
         struct accept_req *accept_req, *accept_next;
@@ -1746,6 +1765,9 @@ static struct sock *create_socket(void)
     sock->sndbuf = 0;
     sock->rcvtimeo = 0;
     sock->sndtimeo = 0;
+    sock->client_buffered = 0;
+    sock->buffered_process = NULL;
+    sock->buffered_handle = 0;
     sock->icmp_fixup_data_len = 0;
     sock->bound_addr[0] = sock->bound_addr[1] = NULL;
     init_async_queue( &sock->read_q );
@@ -2869,6 +2891,8 @@ static void sock_ioctl( struct fd *fd, ioctl_code_t code, struct async *async )
          * don't set the event again (even though e.g. data is still available)
          * until a "reset" call (i.e. that clears reported_events). */
 
+        if (sock->client_buffered > 0) sock_signal_buffered( sock );
+
         if (event && (sock->pending_events & mask))
         {
             if (debug_level) fprintf( stderr, "signalling pending events %#x due to event select\n",
@@ -2904,6 +2928,7 @@ static void sock_ioctl( struct fd *fd, ioctl_code_t code, struct async *async )
         sock->nonblocking = 1;
 
         sock_reselect( sock );
+        if (sock->client_buffered > 0) sock_signal_buffered( sock );
 
         return;
     }
@@ -3509,6 +3534,12 @@ static void poll_socket( struct sock *poll_sock, struct async *async, int exclus
             req->sockets[i].flags |= AFD_POLL_CONNECT_ERR;
             req->sockets[i].status = sock_get_ntstatus( sock->errors[AFD_POLL_BIT_CONNECT_ERR] );
         }
+
+        if (sock->client_buffered > 0 && (mask & AFD_POLL_READ))
+        {
+            if (!req->sockets[i].flags) req->sockets[i].status = STATUS_SUCCESS;
+            req->sockets[i].flags |= AFD_POLL_READ;
+        }
     }
 
     for (i = 0; i < count; ++i)
@@ -3847,7 +3878,7 @@ DECL_HANDLER(recv_socket)
          * asyncs will not consume all available data; if there's no data
          * available, the current request won't be immediately satiable.
          */
-        if ((!req->force_async && sock->nonblocking) ||
+        if ((!req->force_async && sock->nonblocking) || (!req->oob && sock->client_buffered > 0) ||
             check_fd_events( sock->fd, req->oob && !is_oobinline( sock ) ? POLLPRI : POLLIN ))
         {
             /* Give the client opportunity to complete synchronously.
@@ -3870,6 +3901,10 @@ DECL_HANDLER(recv_socket)
     sock->pending_events &= ~(req->oob ? AFD_POLL_OOB : AFD_POLL_READ);
     sock->reported_events &= ~(req->oob ? AFD_POLL_OOB : AFD_POLL_READ);
 
+    /* the receive re-enables FD_READ, post it again for the remaining prefetched data */
+    if (!req->oob && sock->client_buffered > 0)
+        sock_dispatch_events( sock, sock->state, POLLIN );
+
     if ((async = create_request_async( fd, get_fd_comp_flags( fd ), &req->async )))
     {
         set_error( status );
@@ -3886,6 +3921,9 @@ DECL_HANDLER(recv_socket)
         reply->wait = async_handoff( async, NULL, 0 );
         reply->options = get_fd_options( fd );
         reply->nonblocking = sock->nonblocking;
+        /* prefetched data would be invisible to other handles and selects */
+        reply->batch = sock->type == WS_SOCK_DGRAM && !req->oob && sock->obj.handle_count == 1 &&
+                       !sock->mask && !sock->window;
         release_object( async );
     }
     release_object( sock );
@@ -4099,3 +4137,56 @@ DECL_HANDLER(socket_get_icmp_id)
     set_error( STATUS_NOT_FOUND );
     release_object( sock );
 }
+
+DECL_HANDLER(get_socket_poll_state)
+{
+    const obj_handle_t *handles = get_req_data();
+    unsigned int i, count = get_req_data_size() / sizeof(*handles);
+    unsigned int *state;
+
+    if (!(state = set_reply_data_size( count * sizeof(*state) ))) return;
+
+    for (i = 0; i < count; ++i)
+    {
+        struct sock *sock = (struct sock *)get_handle_obj( current->process, handles[i], 0, &sock_ops );
+
+        if (!sock) return;
+
+        state[i] = 0;
+        /* queued asyncs consume readiness before the client would see it, and
+         * errors have to update the socket state */
+        if (sock->type != WS_SOCK_DGRAM || async_queued( &sock->read_q ) || async_queued( &sock->write_q ) ||
+            sock->reset || sock->aborted || sock->hangup || sock->errors[AFD_POLL_BIT_CONNECT_ERR] ||
+            sock->client_buffered > 0)
+            state[i] |= SOCKET_POLL_STATE_SERVER;
+        if (sock->state == SOCK_CONNECTED)
+            state[i] |= SOCKET_POLL_STATE_CONNECTED;
+        if (is_oobinline( sock ))
+            state[i] |= SOCKET_POLL_STATE_OOBINLINE;
+
+        release_object( sock );
+    }
+}
+
+DECL_HANDLER(set_socket_buffered)
+{
+    struct sock *sock = (struct sock *)get_handle_obj( current->process, req->handle, 0, &sock_ops );
+
+    if (!sock) return;
+
+    if (sock->client_buffered + req->delta < 0)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        release_object( sock );
+        return;
+    }
+    sock->client_buffered += req->delta;
+    if (req->delta > 0)
+    {
+        sock->buffered_process = current->process;
+        sock->buffered_handle = req->handle;
+        if (sock->client_buffered > 0) sock_signal_buffered( sock );
+    }
+
+    release_object( sock );
+}
@@ -37,6 +37,9 @@
 #define _WITH_CPU_SET_T
 #include <sched.h>
 #endif
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -240,6 +243,7 @@ static inline void init_thread_structure( struct thread *thread )
     thread->state           = RUNNING;
     thread->exit_code       = 0;
     thread->priority        = 0;
+    thread->unix_nice       = 0;
     thread->suspend         = 0;
     thread->dbg_hidden      = 0;
     thread->desktop_users   = 0;
@@ -606,6 +610,163 @@ affinity_t get_thread_affinity( struct thread *thread )
 #define THREAD_PRIORITY_REALTIME_HIGHEST 6
 #define THREAD_PRIORITY_REALTIME_LOWEST -7
 
+/* Windows base priority of a thread, from 1 to 31 */
+static int get_base_priority( int priority_class, int priority )
+{
+    static const int class_base[] =
+    {
+        8,  /* unknown */
+        4,  /* PROCESS_PRIOCLASS_IDLE */
+        8,  /* PROCESS_PRIOCLASS_NORMAL */
+        13, /* PROCESS_PRIOCLASS_HIGH */
+        24, /* PROCESS_PRIOCLASS_REALTIME */
+        6,  /* PROCESS_PRIOCLASS_BELOW_NORMAL */
+        10, /* PROCESS_PRIOCLASS_ABOVE_NORMAL */
+    };
+
+    if (priority_class < 0 || priority_class >= ARRAY_SIZE(class_base)) priority_class = 0;
+
+    if (priority_class == PROCESS_PRIOCLASS_REALTIME)
+    {
+        if (priority == THREAD_PRIORITY_IDLE) return 16;
+        if (priority == THREAD_PRIORITY_TIME_CRITICAL) return 31;
+        return class_base[priority_class] + priority;
+    }
+    if (priority == THREAD_PRIORITY_IDLE) return 1;
+    if (priority == THREAD_PRIORITY_TIME_CRITICAL) return 15;
+    return max( 1, min( 15, class_base[priority_class] + priority ));
+}
+
+#ifdef __linux__
+
+/* Mapping of Windows priorities to Unix scheduling. It is disabled unless the
+ * WINEPRIORITY environment variable is set to a comma-separated list of:
+ *   on        use the default settings
+ *   off       leave Unix priorities alone
+ *   step=N    nice levels per Windows base priority level (default 2)
+ *   fifo, rr  use SCHED_FIFO or SCHED_RR for time-critical and realtime threads
+ *   rtprio=N  lowest Unix realtime priority to use (default 1)
+ */
+static struct
+{
+    int initialized;
+    int enabled;
+    int step;
+    int policy;
+    int rtprio;
+} priority_config;
+
+static void init_priority_config(void)
+{
+    const char *str = getenv( "WINEPRIORITY" );
+
+    priority_config.initialized = 1;
+    priority_config.enabled = str && *str;
+    priority_config.step = 2;
+    priority_config.policy = SCHED_OTHER;
+    priority_config.rtprio = 1;
+
+    while (str && *str)
+    {
+        size_t len = strcspn( str, "," );
+
+        if (len == 2 && !strncmp( str, "on", 2 )) priority_config.enabled = 1;
+        else if (len == 3 && !strncmp( str, "off", 3 )) priority_config.enabled = 0;
+        else if (len == 4 && !strncmp( str, "fifo", 4 )) priority_config.policy = SCHED_FIFO;
+        else if (len == 2 && !strncmp( str, "rr", 2 )) priority_config.policy = SCHED_RR;
+        else if (!strncmp( str, "step=", 5 )) priority_config.step = max( 0, min( 5, atoi( str + 5 )));
+        else if (!strncmp( str, "rtprio=", 7 )) priority_config.rtprio = max( 1, atoi( str + 7 ));
+        else fprintf( stderr, "wineserver: unknown WINEPRIORITY option %.*s\n", (int)len, str );
+
+        str += len;
+        if (*str) str++;
+    }
+}
+
+/* check whether the nice value of a thread can be restored once lowered */
+static int can_restore_nice( struct thread *thread )
+{
+    struct rlimit rlimit;
+
+    if (!geteuid()) return 1;
+    if (prlimit( thread->unix_pid, RLIMIT_NICE, NULL, &rlimit )) return 0;
+    return rlimit.rlim_cur == RLIM_INFINITY || 20 - (int)rlimit.rlim_cur <= thread->unix_nice;
+}
+
+static void apply_thread_priority( struct thread *thread, int priority_class, int priority )
+{
+    struct sched_param param;
+    int base, nice;
+
+    if (thread->unix_tid == -1) return;
+    if (!priority_config.initialized) init_priority_config();
+    if (!priority_config.enabled) return;
+
+    base = get_base_priority( priority_class, priority );
+
+    if (priority_config.policy != SCHED_OTHER && base >= 15)
+    {
+        param.sched_priority = min( priority_config.rtprio + base - 15,
+                                    sched_get_priority_max( priority_config.policy ));
+        if (!sched_setscheduler( thread->unix_tid, priority_config.policy, &param ))
+        {
+            if (debug_level) fprintf( stderr, "%04x: base priority %d -> %s %d\n", thread->id, base,
+                                      priority_config.policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR",
+                                      param.sched_priority );
+            return;
+        }
+        if (debug_level) fprintf( stderr, "%04x: cannot set realtime priority: %s\n",
+                                  thread->id, strerror( errno ));
+    }
+    else if (sched_getscheduler( thread->unix_tid ) != SCHED_OTHER)
+    {
+        param.sched_priority = 0;
+        sched_setscheduler( thread->unix_tid, SCHED_OTHER, &param );
+    }
+
+    nice = max( -20, min( 19, thread->unix_nice + (8 - min( base, 15 )) * priority_config.step ));
+    /* don't lower the priority if we can't raise it back later */
+    if (nice > thread->unix_nice && !can_restore_nice( thread )) nice = thread->unix_nice;
+
+    if (setpriority( PRIO_PROCESS, thread->unix_tid, nice ))
+    {
+        if (debug_level) fprintf( stderr, "%04x: cannot set nice value %d: %s\n",
+                                  thread->id, nice, strerror( errno ));
+    }
+    else if (debug_level) fprintf( stderr, "%04x: base priority %d -> nice %d\n", thread->id, base, nice );
+}
+
+static void init_thread_priority( struct thread *thread )
+{
+    errno = 0;
+    thread->unix_nice = getpriority( PRIO_PROCESS, thread->unix_tid );
+    if (errno) thread->unix_nice = 0;
+
+    if (get_base_priority( thread->process->priority, thread->priority ) != 8)
+        apply_thread_priority( thread, thread->process->priority, thread->priority );
+}
+
+#else
+
+static void apply_thread_priority( struct thread *thread, int priority_class, int priority )
+{
+}
+
+static void init_thread_priority( struct thread *thread )
+{
+}
+
+#endif
+
+void set_thread_priority( struct thread *thread, int priority_class, int priority )
+{
+    int old = get_base_priority( thread->process->priority, thread->priority );
+
+    thread->priority = priority;
+    if (get_base_priority( priority_class, priority ) != old || priority_class != thread->process->priority)
+        apply_thread_priority( thread, priority_class, priority );
+}
+
 /* set all information about a thread */
 static void set_thread_info( struct thread *thread,
                              const struct set_thread_info_request *req )
@@ -622,7 +783,7 @@ static void set_thread_info( struct thread *thread,
         if ((req->priority >= min && req->priority <= max) ||
             req->priority == THREAD_PRIORITY_IDLE ||
             req->priority == THREAD_PRIORITY_TIME_CRITICAL)
-            thread->priority = req->priority;
+            set_thread_priority( thread, thread->process->priority, req->priority );
         else
             set_error( STATUS_INVALID_PARAMETER );
     }
@@ -1414,6 +1575,7 @@ DECL_HANDLER(init_first_thread)
         process->affinity = current->affinity = get_thread_affinity( current );
     else
         set_thread_affinity( current, current->affinity );
+    init_thread_priority( current );
 
     debug_level = max( debug_level, req->debug_level );
 
@@ -1445,6 +1607,7 @@ DECL_HANDLER(init_thread)
     init_thread_context( current );
     generate_debug_event( current, DbgCreateThreadStateChange, &req->entry );
     set_thread_affinity( current, current->affinity );
+    init_thread_priority( current );
 
     reply->suspend = (current->suspend || current->process->suspend || current->context != NULL);
 }
@@ -1383,6 +1383,48 @@ static void dump_varargs_handle_infos( const char *prefix, data_size_t size )
     fputc( '}', stderr );
 }
 
+static void dump_varargs_irp_requests( const char *prefix, data_size_t size )
+{
+    const irp_request_t *irp;
+    data_size_t len;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*irp))
+    {
+        irp = cur_data;
+        dump_irp_params( "{params=", &irp->params );
+        fprintf( stderr, ",handle=%04x,client_tid=%04x", irp->handle, irp->client_tid );
+        dump_uint64( ",client_thread=", &irp->client_thread );
+        fprintf( stderr, ",in_size=%u}", irp->in_size );
+        len = min( size, sizeof(*irp) + ((irp->in_size + 7) & ~7) );
+        size -= len;
+        remove_data( len );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
+static void dump_varargs_irp_results( const char *prefix, data_size_t size )
+{
+    const irp_result_t *result;
+    data_size_t len;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*result))
+    {
+        result = cur_data;
+        fprintf( stderr, "{handle=%04x,status=%08x", result->handle, result->status );
+        dump_uint64( ",user_ptr=", &result->user_ptr );
+        fprintf( stderr, ",pending=%d,iosb_status=%08x,result=%u,size=%u}",
+                 result->pending, result->iosb_status, result->result, result->size );
+        len = min( size, sizeof(*result) + ((result->size + 7) & ~7) );
+        size -= len;
+        remove_data( len );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
 typedef void (*dump_func)( const void *req );
 
 /* Everything below this line is generated automatically by tools/make_requests */
@@ -2075,6 +2117,7 @@ static void dump_recv_socket_reply( const struct recv_socket_reply *req )
     fprintf( stderr, " wait=%04x", req->wait );
     fprintf( stderr, ", options=%08x", req->options );
     fprintf( stderr, ", nonblocking=%d", req->nonblocking );
+    fprintf( stderr, ", batch=%d", req->batch );
 }
 
 static void dump_send_socket_request( const struct send_socket_request *req )
@@ -2120,6 +2163,22 @@ static void dump_socket_get_icmp_id_reply( const struct socket_get_icmp_id_reply
     fprintf( stderr, " icmp_id=%04x", req->icmp_id );
 }
 
+static void dump_get_socket_poll_state_request( const struct get_socket_poll_state_request *req )
+{
+    dump_varargs_uints( " sockets=", cur_size );
+}
+
+static void dump_get_socket_poll_state_reply( const struct get_socket_poll_state_reply *req )
+{
+    dump_varargs_uints( " state=", cur_size );
+}
+
+static void dump_set_socket_buffered_request( const struct set_socket_buffered_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", delta=%d", req->delta );
+}
+
 static void dump_get_next_console_request_request( const struct get_next_console_request_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -2454,6 +2513,7 @@ static void dump_set_key_value_request( const struct set_key_value_request *req
 static void dump_get_key_value_request( const struct get_key_value_request *req )
 {
     fprintf( stderr, " hkey=%04x", req->hkey );
+    fprintf( stderr, ", cache=%08x", req->cache );
     dump_varargs_unicode_str( ", name=", cur_size );
 }
 
@@ -2461,6 +2521,8 @@ static void dump_get_key_value_reply( const struct get_key_value_reply *req )
 {
     fprintf( stderr, " type=%d", req->type );
     fprintf( stderr, ", total=%u", req->total );
+    fprintf( stderr, ", serial_index=%08x", req->serial_index );
+    fprintf( stderr, ", serial=%08x", req->serial );
     dump_varargs_bytes( ", data=", cur_size );
 }
 
@@ -4232,23 +4294,15 @@ static void dump_delete_device_request( const struct delete_device_request *req
 static void dump_get_next_device_request_request( const struct get_next_device_request_request *req )
 {
     fprintf( stderr, " manager=%04x", req->manager );
-    fprintf( stderr, ", prev=%04x", req->prev );
-    fprintf( stderr, ", status=%08x", req->status );
-    dump_uint64( ", user_ptr=", &req->user_ptr );
-    fprintf( stderr, ", pending=%d", req->pending );
-    fprintf( stderr, ", iosb_status=%08x", req->iosb_status );
-    fprintf( stderr, ", result=%u", req->result );
-    dump_varargs_bytes( ", data=", cur_size );
+    fprintf( stderr, ", max_count=%08x", req->max_count );
+    dump_varargs_irp_results( ", results=", cur_size );
 }
 
 static void dump_get_next_device_request_reply( const struct get_next_device_request_reply *req )
 {
-    dump_irp_params( " params=", &req->params );
-    fprintf( stderr, ", next=%04x", req->next );
-    fprintf( stderr, ", client_tid=%04x", req->client_tid );
-    dump_uint64( ", client_thread=", &req->client_thread );
+    fprintf( stderr, " count=%08x", req->count );
     fprintf( stderr, ", in_size=%u", req->in_size );
-    dump_varargs_bytes( ", next_data=", cur_size );
+    dump_varargs_irp_requests( ", next=", cur_size );
 }
 
 static void dump_get_kernel_object_ptr_request( const struct get_kernel_object_ptr_request *req )
@@ -4666,6 +4720,8 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_socket_get_events_request,
     (dump_func)dump_socket_send_icmp_id_request,
     (dump_func)dump_socket_get_icmp_id_request,
+    (dump_func)dump_get_socket_poll_state_request,
+    (dump_func)dump_set_socket_buffered_request,
     (dump_func)dump_get_next_console_request_request,
     (dump_func)dump_read_directory_changes_request,
     (dump_func)dump_read_change_request,
@@ -4953,6 +5009,8 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_socket_get_events_reply,
     NULL,
     (dump_func)dump_socket_get_icmp_id_reply,
+    (dump_func)dump_get_socket_poll_state_reply,
+    NULL,
     (dump_func)dump_get_next_console_request_reply,
     NULL,
     (dump_func)dump_read_change_reply,
@@ -5240,6 +5298,8 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "socket_get_events",
     "socket_send_icmp_id",
     "socket_get_icmp_id",
+    "get_socket_poll_state",
+    "set_socket_buffered",
     "get_next_console_request",
     "read_directory_changes",
     "read_change",